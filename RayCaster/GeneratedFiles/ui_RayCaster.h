@@ -207,6 +207,7 @@ public:
     QPushButton *m_BtnMaterialRemove;
     QGraphicsView *m_graphicView;
     QPushButton *m_BtnRender;
+    QPushButton *m_BtnCancelRender;
     QProgressBar *m_pBarRendering;
     QMenuBar *menuBar;
     QMenu *menuFile;
@@ -852,6 +853,9 @@ public:
         m_BtnRender = new QPushButton(centralWidget);
         m_BtnRender->setObjectName(QStringLiteral("m_BtnRender"));
         m_BtnRender->setGeometry(QRect(260, 560, 75, 23));
+        m_BtnCancelRender = new QPushButton(centralWidget);
+        m_BtnCancelRender->setObjectName(QStringLiteral("m_BtnCancelRender"));
+        m_BtnCancelRender->setGeometry(QRect(345, 560, 75, 23));
         m_pBarRendering = new QProgressBar(centralWidget);
         m_pBarRendering->setObjectName(QStringLiteral("m_pBarRendering"));
         m_pBarRendering->setGeometry(QRect(20, 600, 601, 23));
@@ -991,6 +995,7 @@ public:
         m_BtnMaterialRemove->setText(QApplication::translate("RayCasterClass", "Remove", 0));
         m_tabScene->setTabText(m_tabScene->indexOf(m_tabMaterial), QApplication::translate("RayCasterClass", "Material", 0));
         m_BtnRender->setText(QApplication::translate("RayCasterClass", "Render", 0));
+        m_BtnCancelRender->setText(QApplication::translate("RayCasterClass", "Cancel", 0));
         menuFile->setTitle(QApplication::translate("RayCasterClass", "File", 0));
     } // retranslateUi
 
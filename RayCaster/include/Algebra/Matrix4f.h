@@ -3,12 +3,17 @@
 #define MATRIX_4F_H
 
 #include <cstdio>
+#include "Vector4f.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define MATRIX_4F_SSE
+#include <xmmintrin.h>
+#endif
 
 class Matrix2f;
 class Matrix3f;
 class Quat4f;
 class Vector3f;
-class Vector4f;
 
 ///////////////////////////
 // 4x4 Matrix Math Header
@@ -16,18 +21,21 @@ class Vector4f;
 // Nicolas Bordes - 10/2016
 ///////////////////////////
 
+///@brief row major, element (i, j) is at 4 * i + j.
+///Element access and the matrix-vector and matrix-matrix products are inline below,
+///the products load whole rows with SSE and add up in the same order as the scalar loops
 class Matrix4f
 {
 public:
 	// Constructor
-	Matrix4f(float fill = 0.f);
-	Matrix4f(float m00, float m01, float m02, float m03, float m10, float m11, float m12, float m13, float m20, float m21, float m22, float m23, float m30, float m31, float m32, float m33);
+	constexpr Matrix4f(float fill = 0.f);
+	constexpr Matrix4f(float m00, float m01, float m02, float m03, float m10, float m11, float m12, float m13, float m20, float m21, float m22, float m23, float m30, float m31, float m32, float m33);
 	Matrix4f(const Vector4f& v0, const Vector4f& v1, const Vector4f& v2, const Vector4f& v3, bool setColumns = true);
-	Matrix4f(const Matrix4f& m);
-	Matrix4f& operator = (const Matrix4f& m);
+	Matrix4f(const Matrix4f& m) = default;
+	Matrix4f& operator = (const Matrix4f& m) = default;
 
 	// Utility
-	const float& operator () (int i, int j) const;
+	constexpr const float& operator () (int i, int j) const;
 	float& operator () (int i, int j);
 	Vector4f getRow(int i) const;
 	void setRow(int i, const Vector4f& v);
@@ -41,6 +49,7 @@ public:
 	void setSubMatrix3x3(int i0, int j0, Matrix3f m);
 
 	operator float* ();
+	operator const float* () const;
 	void print();
 
 	// Math
@@ -85,4 +94,103 @@ Vector4f operator * (const Matrix4f& m, const Vector4f& v);
 // Matrix-Matrix multiplication
 Matrix4f operator * (const Matrix4f& m1, const Matrix4f& m2);
 
+/////////////////////////
+// Inline implementations
+/////////////////////////
+
+inline constexpr Matrix4f::Matrix4f(float fill) :
+m_elements{ fill, fill, fill, fill, fill, fill, fill, fill, fill, fill, fill, fill, fill, fill, fill, fill }
+{
+}
+
+inline constexpr Matrix4f::Matrix4f(float m00, float m01, float m02, float m03, float m10, float m11, float m12, float m13, float m20, float m21, float m22, float m23, float m30, float m31, float m32, float m33) :
+m_elements{ m00, m01, m02, m03, m10, m11, m12, m13, m20, m21, m22, m23, m30, m31, m32, m33 }
+{
+}
+
+inline constexpr const float& Matrix4f::operator () (int i, int j) const
+{
+	return m_elements[i * 4 + j];
+}
+
+inline float& Matrix4f::operator () (int i, int j)
+{
+	return m_elements[i * 4 + j];
+}
+
+inline Matrix4f::operator float* ()
+{
+	return m_elements;
+}
+
+inline Matrix4f::operator const float* () const
+{
+	return m_elements;
+}
+
+inline Vector4f operator * (const Matrix4f& m, const Vector4f& v)
+{
+	const float* a = m;
+#ifdef MATRIX_4F_SSE
+	// columns times the coordinates, each sum starts from 0 like the scalar loop so signed zeros match
+	__m128 c0 = _mm_loadu_ps(a);
+	__m128 c1 = _mm_loadu_ps(a + 4);
+	__m128 c2 = _mm_loadu_ps(a + 8);
+	__m128 c3 = _mm_loadu_ps(a + 12);
+	_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+	__m128 sum = _mm_add_ps(_mm_setzero_ps(), _mm_mul_ps(c0, _mm_set1_ps(v[0])));
+	sum = _mm_add_ps(sum, _mm_mul_ps(c1, _mm_set1_ps(v[1])));
+	sum = _mm_add_ps(sum, _mm_mul_ps(c2, _mm_set1_ps(v[2])));
+	sum = _mm_add_ps(sum, _mm_mul_ps(c3, _mm_set1_ps(v[3])));
+	Vector4f output;
+	_mm_storeu_ps(output, sum);
+	return output;
+#else
+	Vector4f output(0, 0, 0, 0);
+	for (int i = 0; i < 4; ++i)
+	{
+		for (int j = 0; j < 4; ++j)
+		{
+			output[i] += a[i * 4 + j] * v[j];
+		}
+	}
+	return output;
+#endif
+}
+
+inline Matrix4f operator * (const Matrix4f& m1, const Matrix4f& m2)
+{
+	const float* a = m1;
+	const float* b = m2;
+	Matrix4f product; // zeroes
+	float* p = product;
+#ifdef MATRIX_4F_SSE
+	// row i of the product is the rows of m2 weighted by row i of m1
+	__m128 b0 = _mm_loadu_ps(b);
+	__m128 b1 = _mm_loadu_ps(b + 4);
+	__m128 b2 = _mm_loadu_ps(b + 8);
+	__m128 b3 = _mm_loadu_ps(b + 12);
+	for (int i = 0; i < 4; ++i)
+	{
+		__m128 sum = _mm_add_ps(_mm_setzero_ps(), _mm_mul_ps(_mm_set1_ps(a[i * 4]), b0));
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(a[i * 4 + 1]), b1));
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(a[i * 4 + 2]), b2));
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(a[i * 4 + 3]), b3));
+		_mm_storeu_ps(p + i * 4, sum);
+	}
+#else
+	for (int i = 0; i < 4; ++i)
+	{
+		for (int j = 0; j < 4; ++j)
+		{
+			for (int k = 0; k < 4; ++k)
+			{
+				p[i * 4 + k] += a[i * 4 + j] * b[j * 4 + k];
+			}
+		}
+	}
+#endif
+	return product;
+}
+
 #endif // MATRIX_4F_H
\ No newline at end of file
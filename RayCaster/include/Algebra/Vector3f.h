@@ -2,6 +2,8 @@
 #ifndef VECTOR_3F_H
 #define VECTOR_3F_H
 
+#include <cmath>
+
 class Vector2f;
 
 ///////////////////////////
@@ -10,6 +12,9 @@ class Vector2f;
 // Nicolas Bordes - 10/2016
 ///////////////////////////
 
+///@brief three packed floats: meshes, BVH nodes and their binary caches rely on the
+///12 byte layout. The arithmetic is defined inline below so the intersection loops
+///of other translation units compile it in place instead of calling it.
 class Vector3f
 {
 public:
@@ -20,20 +25,20 @@ public:
 	static const Vector3f FORWARD;	// (0,0,1)
 
 	//Constructors
-	Vector3f(float f = 0.f);
-	Vector3f(float x, float y, float z);
+	constexpr Vector3f(float f = 0.f);
+	constexpr Vector3f(float x, float y, float z);
 
 	Vector3f(const Vector2f & xy, float z);
 	Vector3f(float x, const Vector2f & yz);
-	Vector3f(const Vector3f & vec);
-	Vector3f & operator = (const Vector3f & vec);
+	Vector3f(const Vector3f & vec) = default;
+	Vector3f & operator = (const Vector3f & vec) = default;
 
-	const float& operator [] (int i) const;
+	constexpr const float& operator [] (int i) const;
 	float& operator [] (int i);
 
-	float x() const;
-	float y() const;
-	float z() const;
+	constexpr float x() const;
+	constexpr float y() const;
+	constexpr float z() const;
 
 	Vector2f xy() const;
 	Vector2f yz() const;
@@ -53,15 +58,15 @@ public:
 	Vector3f& operator *= (float f);
 
 	float abs() const;
-	float absSquared() const;
+	constexpr float absSquared() const;
 	void normalise();
 	Vector3f normalized() const;
 	Vector2f homogenized() const;
 
 	void negate();
 
-	static float dot(const Vector3f& v0, const Vector3f& v1);
-	static Vector3f cross(const Vector3f& v0, const Vector3f& v1);
+	static constexpr float dot(const Vector3f& v0, const Vector3f& v1);
+	static constexpr Vector3f cross(const Vector3f& v0, const Vector3f& v1);
 	static Vector3f lerp(const Vector3f& v0, const Vector3f& v1, float alpha); //v0*(1-alpha) + v1*alpha
 
 	static Vector3f cubicInterpolate(const Vector3f& p0, const Vector3f& p1, const Vector3f& p2, const Vector3f& p3, float t);
@@ -75,20 +80,191 @@ private:
 /////////////////
 
 // between vectors
-Vector3f operator + (const Vector3f& v0, const Vector3f& v1);
-Vector3f operator - (const Vector3f& v0, const Vector3f& v1);
-Vector3f operator * (const Vector3f& v0, const Vector3f& v1);
-Vector3f operator / (const Vector3f& v0, const Vector3f& v1);
+constexpr Vector3f operator + (const Vector3f& v0, const Vector3f& v1);
+constexpr Vector3f operator - (const Vector3f& v0, const Vector3f& v1);
+constexpr Vector3f operator * (const Vector3f& v0, const Vector3f& v1);
+constexpr Vector3f operator / (const Vector3f& v0, const Vector3f& v1);
 
 // negation
-Vector3f operator - (const Vector3f& v);
+constexpr Vector3f operator - (const Vector3f& v);
 
 // with scalar
-Vector3f operator * (float f, const Vector3f& v);
-Vector3f operator * (const Vector3f& v, float f);
-Vector3f operator / (const Vector3f& v, float f);
+constexpr Vector3f operator * (float f, const Vector3f& v);
+constexpr Vector3f operator * (const Vector3f& v, float f);
+constexpr Vector3f operator / (const Vector3f& v, float f);
+
+constexpr bool operator == (const Vector3f& v0, const Vector3f& v1);
+constexpr bool operator != (const Vector3f& v0, const Vector3f& v1);
+
+/////////////////////////
+// Inline implementations
+/////////////////////////
+
+inline constexpr Vector3f::Vector3f(float f) :
+m_elements{ f, f, f }
+{
+}
+
+inline constexpr Vector3f::Vector3f(float x, float y, float z) :
+m_elements{ x, y, z }
+{
+}
+
+inline constexpr const float& Vector3f::operator [] (int i) const
+{
+	return m_elements[i];
+}
+
+inline float& Vector3f::operator [] (int i)
+{
+	return m_elements[i];
+}
+
+inline constexpr float Vector3f::x() const
+{
+	return m_elements[0];
+}
+
+inline constexpr float Vector3f::y() const
+{
+	return m_elements[1];
+}
+
+inline constexpr float Vector3f::z() const
+{
+	return m_elements[2];
+}
+
+inline Vector3f::operator const float* () const
+{
+	return m_elements;
+}
+
+inline Vector3f::operator float* ()
+{
+	return m_elements;
+}
+
+inline Vector3f& Vector3f::operator += (const Vector3f& vec)
+{
+	m_elements[0] += vec[0];
+	m_elements[1] += vec[1];
+	m_elements[2] += vec[2];
+	return *this;
+}
+
+inline Vector3f& Vector3f::operator -= (const Vector3f& vec)
+{
+	m_elements[0] -= vec[0];
+	m_elements[1] -= vec[1];
+	m_elements[2] -= vec[2];
+	return *this;
+}
+
+inline Vector3f& Vector3f::operator *= (float f)
+{
+	m_elements[0] *= f;
+	m_elements[1] *= f;
+	m_elements[2] *= f;
+	return *this;
+}
+
+inline float Vector3f::abs() const
+{
+	return std::sqrt(absSquared());
+}
+
+inline constexpr float Vector3f::absSquared() const
+{
+	return m_elements[0] * m_elements[0] + m_elements[1] * m_elements[1] + m_elements[2] * m_elements[2];
+}
 
-bool operator == (const Vector3f& v0, const Vector3f& v1);
-bool operator != (const Vector3f& v0, const Vector3f& v1);
+inline void Vector3f::normalise()
+{
+	float norm = abs();
+	m_elements[0] /= norm;
+	m_elements[1] /= norm;
+	m_elements[2] /= norm;
+}
+
+inline Vector3f Vector3f::normalized() const
+{
+	float norm = abs();
+	return Vector3f(m_elements[0] / norm, m_elements[1] / norm, m_elements[2] / norm);
+}
+
+inline void Vector3f::negate()
+{
+	m_elements[0] = -m_elements[0];
+	m_elements[1] = -m_elements[1];
+	m_elements[2] = -m_elements[2];
+}
+
+inline constexpr float Vector3f::dot(const Vector3f& v0, const Vector3f& v1)
+{
+	return v0[0] * v1[0] + v0[1] * v1[1] + v0[2] * v1[2];
+}
+
+inline constexpr Vector3f Vector3f::cross(const Vector3f& v0, const Vector3f& v1)
+{
+	return Vector3f(v0.y() * v1.z() - v0.z() * v1.y(),
+					v0.z() * v1.x() - v0.x() * v1.z(),
+					v0.x() * v1.y() - v0.y() * v1.x());
+}
+
+inline Vector3f Vector3f::lerp(const Vector3f& v0, const Vector3f& v1, float alpha)
+{
+	return alpha * (v1 - v0) + v0;
+}
+
+inline constexpr Vector3f operator + (const Vector3f& v0, const Vector3f& v1)
+{
+	return Vector3f(v0.x() + v1.x(), v0.y() + v1.y(), v0.z() + v1.z());
+}
+
+inline constexpr Vector3f operator - (const Vector3f& v0, const Vector3f& v1)
+{
+	return Vector3f(v0.x() - v1.x(), v0.y() - v1.y(), v0.z() - v1.z());
+}
+
+inline constexpr Vector3f operator * (const Vector3f& v0, const Vector3f& v1)
+{
+	return Vector3f(v0.x() * v1.x(), v0.y() * v1.y(), v0.z() * v1.z());
+}
+
+inline constexpr Vector3f operator / (const Vector3f& v0, const Vector3f& v1)
+{
+	return Vector3f(v0.x() / v1.x(), v0.y() / v1.y(), v0.z() / v1.z());
+}
+
+inline constexpr Vector3f operator - (const Vector3f& v)
+{
+	return Vector3f(-v.x(), -v.y(), -v.z());
+}
+
+inline constexpr Vector3f operator * (float f, const Vector3f& v)
+{
+	return Vector3f(f * v.x(), f * v.y(), f * v.z());
+}
+
+inline constexpr Vector3f operator * (const Vector3f& v, float f)
+{
+	return Vector3f(v.x() * f, v.y() * f, v.z() * f);
+}
+
+inline constexpr Vector3f operator / (const Vector3f& v, float f)
+{
+	return Vector3f(v.x() / f, v.y() / f, v.z() / f);
+}
+
+inline constexpr bool operator == (const Vector3f& v0, const Vector3f& v1)
+{
+	return ((v0.x() == v1.x() && v0.y() == v1.y() && v0.z() == v1.z()));
+}
+
+inline constexpr bool operator != (const Vector3f& v0, const Vector3f& v1)
+{
+	return ((v0.x() != v1.x() || v0.y() != v1.y() || v0.z() != v1.z()));
+}
 
-#endif // VECTOR_2F_H
\ No newline at end of file
+#endif // VECTOR_3F_H
\ No newline at end of file
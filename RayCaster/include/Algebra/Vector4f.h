@@ -2,8 +2,9 @@
 #ifndef VECTOR_4F_H
 #define VECTOR_4F_H
 
+#include "Vector3f.h"
+
 class Vector2f;
-class Vector3f;
 
 ///////////////////////////
 // 4D Vector Math Header
@@ -16,34 +17,34 @@ class Vector4f
 public:
 
 	//Constructors
-	Vector4f(float f = 0.f);
-	Vector4f(float x, float y, float z, float w);
+	constexpr Vector4f(float f = 0.f);
+	constexpr Vector4f(float x, float y, float z, float w);
 	Vector4f(float buffer[4]);
 		  
 	Vector4f(const Vector2f & xy, float z, float w);
 	Vector4f(float x, const Vector2f & yz, float w);
 	Vector4f(float x, float y, const Vector2f & zw);
 
-	Vector4f(const Vector3f & xyz, float w);
+	constexpr Vector4f(const Vector3f & xyz, float w);
 	Vector4f(float x, const Vector3f & yzw );
 
-	Vector4f(const Vector4f & vec);
-	Vector4f & operator = (const Vector4f & vec);
+	Vector4f(const Vector4f & vec) = default;
+	Vector4f & operator = (const Vector4f & vec) = default;
 
-	const float& operator [] (int i) const;
+	constexpr const float& operator [] (int i) const;
 	float& operator [] (int i);
 
-	float x() const;
-	float y() const;
-	float z() const;
-	float w() const;
+	constexpr float x() const;
+	constexpr float y() const;
+	constexpr float z() const;
+	constexpr float w() const;
 
 	Vector2f xy() const;
 	Vector2f yz() const;
 	Vector2f zw() const;
 	Vector2f wx() const;
 
-	Vector3f xyz() const;
+	constexpr Vector3f xyz() const;
 	Vector3f yzw() const;
 	Vector3f zwx() const;
 	Vector3f wxy() const;
@@ -95,4 +96,68 @@ Vector4f operator / (const Vector4f& v, float f);
 bool operator == (const Vector4f& v0, const Vector4f& v1);
 bool operator != (const Vector4f& v0, const Vector4f& v1);
 
+/////////////////////////
+// Inline implementations
+/////////////////////////
+
+inline constexpr Vector4f::Vector4f(float f) :
+m_elements{ f, f, f, f }
+{
+}
+
+inline constexpr Vector4f::Vector4f(float x, float y, float z, float w) :
+m_elements{ x, y, z, w }
+{
+}
+
+inline constexpr Vector4f::Vector4f(const Vector3f & xyz, float w) :
+m_elements{ xyz.x(), xyz.y(), xyz.z(), w }
+{
+}
+
+inline constexpr const float& Vector4f::operator [] (int i) const
+{
+	return m_elements[i];
+}
+
+inline float& Vector4f::operator [] (int i)
+{
+	return m_elements[i];
+}
+
+inline constexpr float Vector4f::x() const
+{
+	return m_elements[0];
+}
+
+inline constexpr float Vector4f::y() const
+{
+	return m_elements[1];
+}
+
+inline constexpr float Vector4f::z() const
+{
+	return m_elements[2];
+}
+
+inline constexpr float Vector4f::w() const
+{
+	return m_elements[3];
+}
+
+inline constexpr Vector3f Vector4f::xyz() const
+{
+	return Vector3f(m_elements[0], m_elements[1], m_elements[2]);
+}
+
+inline Vector4f::operator const float* () const
+{
+	return m_elements;
+}
+
+inline Vector4f::operator float* ()
+{
+	return m_elements;
+}
+
 #endif // VECTOR_4F_H
\ No newline at end of file
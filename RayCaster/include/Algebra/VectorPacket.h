@@ -0,0 +1,841 @@
+#pragma once
+#ifndef VECTOR_PACKET_H
+#define VECTOR_PACKET_H
+
+#include <cmath>
+#include <cstring>
+#include "Vector3f.h"
+
+// define RAYCASTER_NO_SIMD to build the packets on the scalar fallback
+#if !defined(RAYCASTER_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define PACKET_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(PACKET_SSE2) && defined(__AVX__)
+#define PACKET_AVX
+#include <immintrin.h>
+#endif
+
+///////////////////////////
+// Vector Packet Header
+///////////////////////////
+
+///@brief operations on one register of lanes, the packets below are made of several.
+///Width 8 needs AVX, width 4 SSE2, width 1 is the scalar fallback.
+///Masks have every bit of a lane set when true, except the scalar ones which are bools.
+///min(a, b) is a < b ? a : b and max(a, b) a > b ? a : b on every width, like the SSE instructions.
+template <int Width>
+struct PacketBlock;
+
+template <>
+struct PacketBlock<1>
+{
+	typedef float Type;
+	typedef bool Mask;
+	static const int WIDTH = 1;
+
+	static Type set(float f) { return f; }
+	static Type load(const float* p) { return *p; }
+	static Type loadBytes(const unsigned char* p) { return (float)*p; }
+	static void store(float* p, Type a) { *p = a; }
+	static float getLane(const Type& a, int i) { return a; }
+	static void setLane(Type& a, int i, float f) { a = f; }
+
+	static Type add(Type a, Type b) { return a + b; }
+	static Type sub(Type a, Type b) { return a - b; }
+	static Type mul(Type a, Type b) { return a * b; }
+	static Type div(Type a, Type b) { return a / b; }
+	static Type min(Type a, Type b) { return (a < b) ? a : b; }
+	static Type max(Type a, Type b) { return (a > b) ? a : b; }
+	static Type sqrt(Type a) { return std::sqrt(a); }
+	static Type abs(Type a) { return std::fabs(a); }
+	static Type neg(Type a) { return -a; }
+
+	static Mask lt(Type a, Type b) { return a < b; }
+	static Mask le(Type a, Type b) { return a <= b; }
+	static Mask gt(Type a, Type b) { return a > b; }
+	static Mask ge(Type a, Type b) { return a >= b; }
+	static Mask eq(Type a, Type b) { return a == b; }
+	static Mask neq(Type a, Type b) { return a != b; }
+	static Type select(Mask m, Type a, Type b) { return m ? a : b; }
+
+	static Mask setMask(bool b) { return b; }
+	static bool getMaskLane(const Mask& m, int i) { return m; }
+	static void setMaskLane(Mask& m, int i, bool b) { m = b; }
+	static Mask maskAnd(Mask a, Mask b) { return a && b; }
+	static Mask maskOr(Mask a, Mask b) { return a || b; }
+	static Mask maskXor(Mask a, Mask b) { return a != b; }
+	static Mask maskNot(Mask a) { return !a; }
+	static unsigned int getBits(Mask m) { return m ? 1u : 0u; }
+
+	static void loadVector3(const float* p, Type& x, Type& y, Type& z) { x = p[0]; y = p[1]; z = p[2]; }
+	static void storeVector3(float* p, Type x, Type y, Type z) { p[0] = x; p[1] = y; p[2] = z; }
+};
+
+#ifdef PACKET_SSE2
+template <>
+struct PacketBlock<4>
+{
+	typedef __m128 Type;
+	typedef __m128 Mask;
+	static const int WIDTH = 4;
+
+	static Type set(float f) { return _mm_set1_ps(f); }
+	static Type load(const float* p) { return _mm_loadu_ps(p); }
+	static Type loadBytes(const unsigned char* p)
+	{
+		int bytes;
+		memcpy(&bytes, p, sizeof(bytes));
+		__m128i zero = _mm_setzero_si128();
+		__m128i words = _mm_unpacklo_epi8(_mm_cvtsi32_si128(bytes), zero);
+		return _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero));
+	}
+	static void store(float* p, Type a) { _mm_storeu_ps(p, a); }
+	// __m128 may alias floats
+	static float getLane(const Type& a, int i) { return reinterpret_cast<const float*>(&a)[i]; }
+	static void setLane(Type& a, int i, float f) { reinterpret_cast<float*>(&a)[i] = f; }
+
+	static Type add(Type a, Type b) { return _mm_add_ps(a, b); }
+	static Type sub(Type a, Type b) { return _mm_sub_ps(a, b); }
+	static Type mul(Type a, Type b) { return _mm_mul_ps(a, b); }
+	static Type div(Type a, Type b) { return _mm_div_ps(a, b); }
+	static Type min(Type a, Type b) { return _mm_min_ps(a, b); }
+	static Type max(Type a, Type b) { return _mm_max_ps(a, b); }
+	static Type sqrt(Type a) { return _mm_sqrt_ps(a); }
+	static Type abs(Type a) { return _mm_andnot_ps(_mm_set1_ps(-0.f), a); }
+	static Type neg(Type a) { return _mm_xor_ps(_mm_set1_ps(-0.f), a); }
+
+	static Mask lt(Type a, Type b) { return _mm_cmplt_ps(a, b); }
+	static Mask le(Type a, Type b) { return _mm_cmple_ps(a, b); }
+	static Mask gt(Type a, Type b) { return _mm_cmpgt_ps(a, b); }
+	static Mask ge(Type a, Type b) { return _mm_cmpge_ps(a, b); }
+	static Mask eq(Type a, Type b) { return _mm_cmpeq_ps(a, b); }
+	static Mask neq(Type a, Type b) { return _mm_cmpneq_ps(a, b); }
+	static Type select(Mask m, Type a, Type b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+
+	static Mask setMask(bool b) { return _mm_castsi128_ps(_mm_set1_epi32(b ? -1 : 0)); }
+	static bool getMaskLane(const Mask& m, int i) { return ((_mm_movemask_ps(m) >> i) & 1) != 0; }
+	static void setMaskLane(Mask& m, int i, bool b) { reinterpret_cast<int*>(&m)[i] = b ? -1 : 0; }
+	static Mask maskAnd(Mask a, Mask b) { return _mm_and_ps(a, b); }
+	static Mask maskOr(Mask a, Mask b) { return _mm_or_ps(a, b); }
+	static Mask maskXor(Mask a, Mask b) { return _mm_xor_ps(a, b); }
+	static Mask maskNot(Mask a) { return _mm_xor_ps(a, setMask(true)); }
+	static unsigned int getBits(Mask m) { return (unsigned int)_mm_movemask_ps(m); }
+
+	///@brief transpose 4 packed Vector3f, p = x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+	static void loadVector3(const float* p, Type& x, Type& y, Type& z)
+	{
+		__m128 a = _mm_loadu_ps(p);
+		__m128 b = _mm_loadu_ps(p + 4);
+		__m128 c = _mm_loadu_ps(p + 8);
+		__m128 x23 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 1, 0, 2));
+		x = _mm_shuffle_ps(a, x23, _MM_SHUFFLE(2, 0, 3, 0));
+		__m128 y01 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));
+		__m128 y23 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3));
+		y = _mm_shuffle_ps(y01, y23, _MM_SHUFFLE(2, 0, 2, 0));
+		__m128 z01 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));
+		__m128 z23 = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0));
+		z = _mm_shuffle_ps(z01, z23, _MM_SHUFFLE(2, 0, 2, 0));
+	}
+
+	static void storeVector3(float* p, Type x, Type y, Type z)
+	{
+		__m128 xy01 = _mm_unpacklo_ps(x, y);
+		__m128 xy23 = _mm_unpackhi_ps(x, y);
+		__m128 z0x1 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 0, 0, 0));
+		__m128 y1z1 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1));
+		__m128 z2x3 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2));
+		__m128 y3z3 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3));
+		_mm_storeu_ps(p, _mm_shuffle_ps(xy01, z0x1, _MM_SHUFFLE(3, 0, 1, 0)));
+		_mm_storeu_ps(p + 4, _mm_shuffle_ps(y1z1, xy23, _MM_SHUFFLE(1, 0, 2, 0)));
+		_mm_storeu_ps(p + 8, _mm_shuffle_ps(z2x3, y3z3, _MM_SHUFFLE(2, 0, 2, 0)));
+	}
+};
+#endif
+
+#ifdef PACKET_AVX
+template <>
+struct PacketBlock<8>
+{
+	typedef __m256 Type;
+	typedef __m256 Mask;
+	static const int WIDTH = 8;
+
+	static Type set(float f) { return _mm256_set1_ps(f); }
+	static Type load(const float* p) { return _mm256_loadu_ps(p); }
+	static Type loadBytes(const unsigned char* p)
+	{
+		return _mm256_insertf128_ps(_mm256_castps128_ps256(PacketBlock<4>::loadBytes(p)), PacketBlock<4>::loadBytes(p + 4), 1);
+	}
+	static void store(float* p, Type a) { _mm256_storeu_ps(p, a); }
+	static float getLane(const Type& a, int i) { return reinterpret_cast<const float*>(&a)[i]; }
+	static void setLane(Type& a, int i, float f) { reinterpret_cast<float*>(&a)[i] = f; }
+
+	static Type add(Type a, Type b) { return _mm256_add_ps(a, b); }
+	static Type sub(Type a, Type b) { return _mm256_sub_ps(a, b); }
+	static Type mul(Type a, Type b) { return _mm256_mul_ps(a, b); }
+	static Type div(Type a, Type b) { return _mm256_div_ps(a, b); }
+	static Type min(Type a, Type b) { return _mm256_min_ps(a, b); }
+	static Type max(Type a, Type b) { return _mm256_max_ps(a, b); }
+	static Type sqrt(Type a) { return _mm256_sqrt_ps(a); }
+	static Type abs(Type a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a); }
+	static Type neg(Type a) { return _mm256_xor_ps(_mm256_set1_ps(-0.f), a); }
+
+	static Mask lt(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+	static Mask le(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+	static Mask gt(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	static Mask ge(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+	static Mask eq(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+	static Mask neq(Type a, Type b) { return _mm256_cmp_ps(a, b, _CMP_NEQ_UQ); }
+	static Type select(Mask m, Type a, Type b) { return _mm256_blendv_ps(b, a, m); }
+
+	static Mask setMask(bool b) { return _mm256_castsi256_ps(_mm256_set1_epi32(b ? -1 : 0)); }
+	static bool getMaskLane(const Mask& m, int i) { return ((_mm256_movemask_ps(m) >> i) & 1) != 0; }
+	static void setMaskLane(Mask& m, int i, bool b) { reinterpret_cast<int*>(&m)[i] = b ? -1 : 0; }
+	static Mask maskAnd(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+	static Mask maskOr(Mask a, Mask b) { return _mm256_or_ps(a, b); }
+	static Mask maskXor(Mask a, Mask b) { return _mm256_xor_ps(a, b); }
+	static Mask maskNot(Mask a) { return _mm256_xor_ps(a, setMask(true)); }
+	static unsigned int getBits(Mask m) { return (unsigned int)_mm256_movemask_ps(m); }
+
+	///@brief transpose 8 packed Vector3f, as two halves of 4
+	static void loadVector3(const float* p, Type& x, Type& y, Type& z)
+	{
+		__m128 x0, y0, z0, x1, y1, z1;
+		PacketBlock<4>::loadVector3(p, x0, y0, z0);
+		PacketBlock<4>::loadVector3(p + 12, x1, y1, z1);
+		x = _mm256_insertf128_ps(_mm256_castps128_ps256(x0), x1, 1);
+		y = _mm256_insertf128_ps(_mm256_castps128_ps256(y0), y1, 1);
+		z = _mm256_insertf128_ps(_mm256_castps128_ps256(z0), z1, 1);
+	}
+
+	static void storeVector3(float* p, Type x, Type y, Type z)
+	{
+		PacketBlock<4>::storeVector3(p, _mm256_castps256_ps128(x), _mm256_castps256_ps128(y), _mm256_castps256_ps128(z));
+		PacketBlock<4>::storeVector3(p + 12, _mm256_extractf128_ps(x, 1), _mm256_extractf128_ps(y, 1), _mm256_extractf128_ps(z, 1));
+	}
+};
+#endif
+
+///@brief widest block a packet of N lanes is made of
+template <int N>
+struct PacketBlockWidth
+{
+#if defined(PACKET_AVX)
+	static const int value = (N % 8 == 0) ? 8 : (N % 4 == 0) ? 4 : 1;
+#elif defined(PACKET_SSE2)
+	static const int value = (N % 4 == 0) ? 4 : 1;
+#else
+	static const int value = 1;
+#endif
+};
+
+///@brief N booleans, the result of comparing packets lane by lane
+template <int N>
+class MaskPacket
+{
+public:
+	typedef PacketBlock<PacketBlockWidth<N>::value> Block;
+	static const int BLOCK_COUNT = N / Block::WIDTH;
+
+	MaskPacket(bool b = false);
+
+	bool operator [] (int i) const;
+	void set(int i, bool b);
+
+	///@return bit i set when lane i is true
+	unsigned int getBits() const;
+	bool any() const;
+	bool all() const;
+	bool none() const;
+
+	typename Block::Mask m_blocks[BLOCK_COUNT];
+};
+
+///@brief N floats, one per lane.
+///The blocks are public for the operators below, use the lanes through the accessors.
+///AVX blocks need 32 byte alignment, which new only guarantees from C++17: keep 8 wide packets on the stack
+template <int N>
+class FloatPacket
+{
+public:
+	typedef PacketBlock<PacketBlockWidth<N>::value> Block;
+	static const int BLOCK_COUNT = N / Block::WIDTH;
+
+	FloatPacket(float f = 0.f);
+
+	///@param p N contiguous floats, no alignment needed
+	static FloatPacket load(const float* p);
+	///@param p N contiguous bytes, converted exactly
+	static FloatPacket loadBytes(const unsigned char* p);
+	void store(float* p) const;
+
+	float operator [] (int i) const;
+	void set(int i, float f);
+
+	FloatPacket& operator += (const FloatPacket& p);
+	FloatPacket& operator -= (const FloatPacket& p);
+	FloatPacket& operator *= (const FloatPacket& p);
+
+	///@brief 1 / x rounded like the scalar division
+	FloatPacket reciprocal() const;
+	FloatPacket sqrt() const;
+	FloatPacket abs() const;
+
+	static FloatPacket min(const FloatPacket& p0, const FloatPacket& p1);
+	static FloatPacket max(const FloatPacket& p0, const FloatPacket& p1);
+	///@return lanes of p0 where mask is true, of p1 elsewhere
+	static FloatPacket select(const MaskPacket<N>& mask, const FloatPacket& p0, const FloatPacket& p1);
+
+	typename Block::Type m_blocks[BLOCK_COUNT];
+};
+
+///@brief N Vector3f stored as structure of arrays: the x of every lane, then the y, then the z
+template <int N>
+class Vector3fPacket
+{
+public:
+	Vector3fPacket(float f = 0.f);
+	///@brief v in every lane
+	Vector3fPacket(const Vector3f& v);
+	Vector3fPacket(const FloatPacket<N>& x, const FloatPacket<N>& y, const FloatPacket<N>& z);
+
+	///@param v N contiguous vectors
+	static Vector3fPacket load(const Vector3f* v);
+	void store(Vector3f* v) const;
+
+	Vector3f get(int i) const;
+	void set(int i, const Vector3f& v);
+
+	const FloatPacket<N>& x() const;
+	const FloatPacket<N>& y() const;
+	const FloatPacket<N>& z() const;
+	FloatPacket<N>& x();
+	FloatPacket<N>& y();
+	FloatPacket<N>& z();
+	const FloatPacket<N>& operator [] (int axis) const;
+	FloatPacket<N>& operator [] (int axis);
+
+	Vector3fPacket& operator += (const Vector3fPacket& v);
+	Vector3fPacket& operator -= (const Vector3fPacket& v);
+	Vector3fPacket& operator *= (const FloatPacket<N>& f);
+
+	FloatPacket<N> absSquared() const;
+	FloatPacket<N> abs() const;
+	Vector3fPacket normalized() const;
+	///@brief 1 / x of every coordinate, the inverse direction of the slab tests
+	Vector3fPacket reciprocal() const;
+
+	static FloatPacket<N> dot(const Vector3fPacket& v0, const Vector3fPacket& v1);
+	static Vector3fPacket cross(const Vector3fPacket& v0, const Vector3fPacket& v1);
+	static Vector3fPacket min(const Vector3fPacket& v0, const Vector3fPacket& v1);
+	static Vector3fPacket max(const Vector3fPacket& v0, const Vector3fPacket& v1);
+	static Vector3fPacket select(const MaskPacket<N>& mask, const Vector3fPacket& v0, const Vector3fPacket& v1);
+
+private:
+	FloatPacket<N> m_elements[3];
+};
+
+typedef MaskPacket<4> Mask4;
+typedef MaskPacket<8> Mask8;
+typedef FloatPacket<4> Float4;
+typedef FloatPacket<8> Float8;
+typedef Vector3fPacket<4> Vector3f4;
+typedef Vector3fPacket<8> Vector3f8;
+
+//////////////
+// MaskPacket
+//////////////
+
+template <int N>
+inline MaskPacket<N>::MaskPacket(bool b)
+{
+	for (int k = 0; k < BLOCK_COUNT; ++k) m_blocks[k] = Block::setMask(b);
+}
+
+template <int N>
+inline bool MaskPacket<N>::operator [] (int i) const
+{
+	return Block::getMaskLane(m_blocks[i / Block::WIDTH], i % Block::WIDTH);
+}
+
+template <int N>
+inline void MaskPacket<N>::set(int i, bool b)
+{
+	Block::setMaskLane(m_blocks[i / Block::WIDTH], i % Block::WIDTH, b);
+}
+
+template <int N>
+inline unsigned int MaskPacket<N>::getBits() const
+{
+	unsigned int bits = 0;
+	for (int k = 0; k < BLOCK_COUNT; ++k) bits |= Block::getBits(m_blocks[k]) << (k * Block::WIDTH);
+	return bits;
+}
+
+template <int N>
+inline bool MaskPacket<N>::any() const
+{
+	return getBits() != 0;
+}
+
+template <int N>
+inline bool MaskPacket<N>::all() const
+{
+	return getBits() == (N == 32 ? 0xFFFFFFFFu : (1u << N) - 1);
+}
+
+template <int N>
+inline bool MaskPacket<N>::none() const
+{
+	return getBits() == 0;
+}
+
+template <int N>
+inline MaskPacket<N> operator & (const MaskPacket<N>& m0, const MaskPacket<N>& m1)
+{
+	typedef typename MaskPacket<N>::Block Block;
+	MaskPacket<N> out;
+	for (int k = 0; k < MaskPacket<N>::BLOCK_COUNT; ++k) out.m_blocks[k] = Block::maskAnd(m0.m_blocks[k], m1.m_blocks[k]);
+	return out;
+}
+
+template <int N>
+inline MaskPacket<N> operator | (const MaskPacket<N>& m0, const MaskPacket<N>& m1)
+{
+	typedef typename MaskPacket<N>::Block Block;
+	MaskPacket<N> out;
+	for (int k = 0; k < MaskPacket<N>::BLOCK_COUNT; ++k) out.m_blocks[k] = Block::maskOr(m0.m_blocks[k], m1.m_blocks[k]);
+	return out;
+}
+
+template <int N>
+inline MaskPacket<N> operator ^ (const MaskPacket<N>& m0, const MaskPacket<N>& m1)
+{
+	typedef typename MaskPacket<N>::Block Block;
+	MaskPacket<N> out;
+	for (int k = 0; k < MaskPacket<N>::BLOCK_COUNT; ++k) out.m_blocks[k] = Block::maskXor(m0.m_blocks[k], m1.m_blocks[k]);
+	return out;
+}
+
+template <int N>
+inline MaskPacket<N> operator ~ (const MaskPacket<N>& m)
+{
+	typedef typename MaskPacket<N>::Block Block;
+	MaskPacket<N> out;
+	for (int k = 0; k < MaskPacket<N>::BLOCK_COUNT; ++k) out.m_blocks[k] = Block::maskNot(m.m_blocks[k]);
+	return out;
+}
+
+//////////////
+// FloatPacket
+//////////////
+
+// applies a block operation to every block of the packets
+#define FLOAT_PACKET_MAP(out, expression) \
+	for (int k = 0; k < FloatPacket<N>::BLOCK_COUNT; ++k) (out).m_blocks[k] = (expression)
+
+template <int N>
+inline FloatPacket<N>::FloatPacket(float f)
+{
+	for (int k = 0; k < BLOCK_COUNT; ++k) m_blocks[k] = Block::set(f);
+}
+
+template <int N>
+inline FloatPacket<N> FloatPacket<N>::load(const float* p)
+{
+	FloatPacket<N> out;
+	FLOAT_PACKET_MAP(out, Block::load(p + k * Block::WIDTH));
+	return out;
+}
+
+template <int N>
+inline FloatPacket<N> FloatPacket<N>::loadBytes(const unsigned char* p)
+{
+	FloatPacket<N> out;
+	FLOAT_PACKET_MAP(out, Block::loadBytes(p + k * Block::WIDTH));
+	return out;
+}
+
+template <int N>
+inline void FloatPacket<N>::store(float* p) const
+{
+	for (int k = 0; k < BLOCK_COUNT; ++k) Block::store(p + k * Block::WIDTH, m_blocks[k]);
+}
+
+template <int N>
+inline float FloatPacket<N>::operator [] (int i) const
+{
+	return Block::getLane(m_blocks[i / Block::WIDTH], i % Block::WIDTH);
+}
+
+template <int N>
+inline void FloatPacket<N>::set(int i, float f)
+{
+	Block::setLane(m_blocks[i / Block::WIDTH], i % Block::WIDTH, f);
+}
+
+template <int N>
+inline FloatPacket<N>& FloatPacket<N>::operator += (const FloatPacket<N>& p)
+{
+	FLOAT_PACKET_MAP(*this, Block::add(m_blocks[k], p.m_blocks[k]));
+	return *this;
+}
+
+template <int N>
+inline FloatPacket<N>& FloatPacket<N>::operator -= (const FloatPacket<N>& p)
+{
+	FLOAT_PACKET_MAP(*this, Block::sub(m_blocks[k], p.m_blocks[k]));
+	return *this;
+}
+
+template <int N>
+inline FloatPacket<N>& FloatPacket<N>::operator *= (const FloatPacket<N>& p)
+{
+	FLOAT_PACKET_MAP(*this, Block::mul(m_blocks[k], p.m_blocks[k]));
+	return *this;
+}
+
+template <int N>
+inline FloatPacket<N> FloatPacket<N>::reciprocal() const
+{
+	FloatPacket<N> out;
+	FLOAT_PACKET_MAP(out, Block::div(Block::set(1.f), m_blocks[k]));
+	return out;
+}
+
+template <int N>
+inline FloatPacket<N> FloatPacket<N>::sqrt() const
+{
+	FloatPacket<N> out;
+	FLOAT_PACKET_MAP(out, Block::sqrt(m_blocks[k]));
+	return out;
+}
+
+template <int N>
+inline FloatPacket<N> FloatPacket<N>::abs() const
+{
+	FloatPacket<N> out;
+	FLOAT_PACKET_MAP(out, Block::abs(m_blocks[k]));
+	return out;
+}
+
+template <int N>
+inline FloatPacket<N> FloatPacket<N>::min(const FloatPacket<N>& p0, const FloatPacket<N>& p1)
+{
+	FloatPacket<N> out;
+	FLOAT_PACKET_MAP(out, Block::min(p0.m_blocks[k], p1.m_blocks[k]));
+	return out;
+}
+
+template <int N>
+inline FloatPacket<N> FloatPacket<N>::max(const FloatPacket<N>& p0, const FloatPacket<N>& p1)
+{
+	FloatPacket<N> out;
+	FLOAT_PACKET_MAP(out, Block::max(p0.m_blocks[k], p1.m_blocks[k]));
+	return out;
+}
+
+template <int N>
+inline FloatPacket<N> FloatPacket<N>::select(const MaskPacket<N>& mask, const FloatPacket<N>& p0, const FloatPacket<N>& p1)
+{
+	FloatPacket<N> out;
+	FLOAT_PACKET_MAP(out, Block::select(mask.m_blocks[k], p0.m_blocks[k], p1.m_blocks[k]));
+	return out;
+}
+
+#define FLOAT_PACKET_OPERATOR(op, blockOp) \
+template <int N> \
+inline FloatPacket<N> operator op (const FloatPacket<N>& p0, const FloatPacket<N>& p1) \
+{ \
+	FloatPacket<N> out; \
+	FLOAT_PACKET_MAP(out, FloatPacket<N>::Block::blockOp(p0.m_blocks[k], p1.m_blocks[k])); \
+	return out; \
+} \
+template <int N> \
+inline FloatPacket<N> operator op (const FloatPacket<N>& p, float f) \
+{ \
+	return p op FloatPacket<N>(f); \
+} \
+template <int N> \
+inline FloatPacket<N> operator op (float f, const FloatPacket<N>& p) \
+{ \
+	return FloatPacket<N>(f) op p; \
+}
+
+FLOAT_PACKET_OPERATOR(+, add)
+FLOAT_PACKET_OPERATOR(-, sub)
+FLOAT_PACKET_OPERATOR(*, mul)
+FLOAT_PACKET_OPERATOR(/, div)
+#undef FLOAT_PACKET_OPERATOR
+
+template <int N>
+inline FloatPacket<N> operator - (const FloatPacket<N>& p)
+{
+	FloatPacket<N> out;
+	FLOAT_PACKET_MAP(out, FloatPacket<N>::Block::neg(p.m_blocks[k]));
+	return out;
+}
+
+#define FLOAT_PACKET_COMPARISON(op, blockOp) \
+template <int N> \
+inline MaskPacket<N> operator op (const FloatPacket<N>& p0, const FloatPacket<N>& p1) \
+{ \
+	MaskPacket<N> out; \
+	FLOAT_PACKET_MAP(out, FloatPacket<N>::Block::blockOp(p0.m_blocks[k], p1.m_blocks[k])); \
+	return out; \
+}
+
+// ordered: false when a lane is NaN, except != which is then true
+FLOAT_PACKET_COMPARISON(<, lt)
+FLOAT_PACKET_COMPARISON(<=, le)
+FLOAT_PACKET_COMPARISON(>, gt)
+FLOAT_PACKET_COMPARISON(>=, ge)
+FLOAT_PACKET_COMPARISON(==, eq)
+FLOAT_PACKET_COMPARISON(!=, neq)
+#undef FLOAT_PACKET_COMPARISON
+#undef FLOAT_PACKET_MAP
+
+/////////////////
+// Vector3fPacket
+/////////////////
+
+template <int N>
+inline Vector3fPacket<N>::Vector3fPacket(float f)
+{
+	m_elements[0] = FloatPacket<N>(f);
+	m_elements[1] = FloatPacket<N>(f);
+	m_elements[2] = FloatPacket<N>(f);
+}
+
+template <int N>
+inline Vector3fPacket<N>::Vector3fPacket(const Vector3f& v)
+{
+	m_elements[0] = FloatPacket<N>(v[0]);
+	m_elements[1] = FloatPacket<N>(v[1]);
+	m_elements[2] = FloatPacket<N>(v[2]);
+}
+
+template <int N>
+inline Vector3fPacket<N>::Vector3fPacket(const FloatPacket<N>& x, const FloatPacket<N>& y, const FloatPacket<N>& z)
+{
+	m_elements[0] = x;
+	m_elements[1] = y;
+	m_elements[2] = z;
+}
+
+template <int N>
+inline Vector3fPacket<N> Vector3fPacket<N>::load(const Vector3f* v)
+{
+	typedef typename FloatPacket<N>::Block Block;
+	static_assert(sizeof(Vector3f) == 3 * sizeof(float), "Vector3f arrays must be packed floats");
+	Vector3fPacket<N> out;
+	for (int k = 0; k < FloatPacket<N>::BLOCK_COUNT; ++k)
+	{
+		Block::loadVector3(v[k * Block::WIDTH], out.m_elements[0].m_blocks[k], out.m_elements[1].m_blocks[k], out.m_elements[2].m_blocks[k]);
+	}
+	return out;
+}
+
+template <int N>
+inline void Vector3fPacket<N>::store(Vector3f* v) const
+{
+	typedef typename FloatPacket<N>::Block Block;
+	for (int k = 0; k < FloatPacket<N>::BLOCK_COUNT; ++k)
+	{
+		Block::storeVector3(v[k * Block::WIDTH], m_elements[0].m_blocks[k], m_elements[1].m_blocks[k], m_elements[2].m_blocks[k]);
+	}
+}
+
+template <int N>
+inline Vector3f Vector3fPacket<N>::get(int i) const
+{
+	return Vector3f(m_elements[0][i], m_elements[1][i], m_elements[2][i]);
+}
+
+template <int N>
+inline void Vector3fPacket<N>::set(int i, const Vector3f& v)
+{
+	m_elements[0].set(i, v[0]);
+	m_elements[1].set(i, v[1]);
+	m_elements[2].set(i, v[2]);
+}
+
+template <int N>
+inline const FloatPacket<N>& Vector3fPacket<N>::x() const
+{
+	return m_elements[0];
+}
+
+template <int N>
+inline const FloatPacket<N>& Vector3fPacket<N>::y() const
+{
+	return m_elements[1];
+}
+
+template <int N>
+inline const FloatPacket<N>& Vector3fPacket<N>::z() const
+{
+	return m_elements[2];
+}
+
+template <int N>
+inline FloatPacket<N>& Vector3fPacket<N>::x()
+{
+	return m_elements[0];
+}
+
+template <int N>
+inline FloatPacket<N>& Vector3fPacket<N>::y()
+{
+	return m_elements[1];
+}
+
+template <int N>
+inline FloatPacket<N>& Vector3fPacket<N>::z()
+{
+	return m_elements[2];
+}
+
+template <int N>
+inline const FloatPacket<N>& Vector3fPacket<N>::operator [] (int axis) const
+{
+	return m_elements[axis];
+}
+
+template <int N>
+inline FloatPacket<N>& Vector3fPacket<N>::operator [] (int axis)
+{
+	return m_elements[axis];
+}
+
+template <int N>
+inline Vector3fPacket<N>& Vector3fPacket<N>::operator += (const Vector3fPacket<N>& v)
+{
+	m_elements[0] += v.m_elements[0];
+	m_elements[1] += v.m_elements[1];
+	m_elements[2] += v.m_elements[2];
+	return *this;
+}
+
+template <int N>
+inline Vector3fPacket<N>& Vector3fPacket<N>::operator -= (const Vector3fPacket<N>& v)
+{
+	m_elements[0] -= v.m_elements[0];
+	m_elements[1] -= v.m_elements[1];
+	m_elements[2] -= v.m_elements[2];
+	return *this;
+}
+
+template <int N>
+inline Vector3fPacket<N>& Vector3fPacket<N>::operator *= (const FloatPacket<N>& f)
+{
+	m_elements[0] *= f;
+	m_elements[1] *= f;
+	m_elements[2] *= f;
+	return *this;
+}
+
+template <int N>
+inline FloatPacket<N> Vector3fPacket<N>::absSquared() const
+{
+	return dot(*this, *this);
+}
+
+template <int N>
+inline FloatPacket<N> Vector3fPacket<N>::abs() const
+{
+	return absSquared().sqrt();
+}
+
+template <int N>
+inline Vector3fPacket<N> Vector3fPacket<N>::normalized() const
+{
+	// divides like Vector3f::normalized, so every lane matches it exactly
+	FloatPacket<N> norm = abs();
+	return Vector3fPacket<N>(m_elements[0] / norm, m_elements[1] / norm, m_elements[2] / norm);
+}
+
+template <int N>
+inline Vector3fPacket<N> Vector3fPacket<N>::reciprocal() const
+{
+	return Vector3fPacket<N>(m_elements[0].reciprocal(), m_elements[1].reciprocal(), m_elements[2].reciprocal());
+}
+
+template <int N>
+inline FloatPacket<N> Vector3fPacket<N>::dot(const Vector3fPacket<N>& v0, const Vector3fPacket<N>& v1)
+{
+	return v0.m_elements[0] * v1.m_elements[0] + v0.m_elements[1] * v1.m_elements[1] + v0.m_elements[2] * v1.m_elements[2];
+}
+
+template <int N>
+inline Vector3fPacket<N> Vector3fPacket<N>::cross(const Vector3fPacket<N>& v0, const Vector3fPacket<N>& v1)
+{
+	return Vector3fPacket<N>(v0.y() * v1.z() - v0.z() * v1.y(),
+							v0.z() * v1.x() - v0.x() * v1.z(),
+							v0.x() * v1.y() - v0.y() * v1.x());
+}
+
+template <int N>
+inline Vector3fPacket<N> Vector3fPacket<N>::min(const Vector3fPacket<N>& v0, const Vector3fPacket<N>& v1)
+{
+	return Vector3fPacket<N>(FloatPacket<N>::min(v0.x(), v1.x()), FloatPacket<N>::min(v0.y(), v1.y()), FloatPacket<N>::min(v0.z(), v1.z()));
+}
+
+template <int N>
+inline Vector3fPacket<N> Vector3fPacket<N>::max(const Vector3fPacket<N>& v0, const Vector3fPacket<N>& v1)
+{
+	return Vector3fPacket<N>(FloatPacket<N>::max(v0.x(), v1.x()), FloatPacket<N>::max(v0.y(), v1.y()), FloatPacket<N>::max(v0.z(), v1.z()));
+}
+
+template <int N>
+inline Vector3fPacket<N> Vector3fPacket<N>::select(const MaskPacket<N>& mask, const Vector3fPacket<N>& v0, const Vector3fPacket<N>& v1)
+{
+	return Vector3fPacket<N>(FloatPacket<N>::select(mask, v0.x(), v1.x()),
+							FloatPacket<N>::select(mask, v0.y(), v1.y()),
+							FloatPacket<N>::select(mask, v0.z(), v1.z()));
+}
+
+template <int N>
+inline Vector3fPacket<N> operator + (const Vector3fPacket<N>& v0, const Vector3fPacket<N>& v1)
+{
+	return Vector3fPacket<N>(v0.x() + v1.x(), v0.y() + v1.y(), v0.z() + v1.z());
+}
+
+template <int N>
+inline Vector3fPacket<N> operator - (const Vector3fPacket<N>& v0, const Vector3fPacket<N>& v1)
+{
+	return Vector3fPacket<N>(v0.x() - v1.x(), v0.y() - v1.y(), v0.z() - v1.z());
+}
+
+template <int N>
+inline Vector3fPacket<N> operator * (const Vector3fPacket<N>& v0, const Vector3fPacket<N>& v1)
+{
+	return Vector3fPacket<N>(v0.x() * v1.x(), v0.y() * v1.y(), v0.z() * v1.z());
+}
+
+template <int N>
+inline Vector3fPacket<N> operator - (const Vector3fPacket<N>& v)
+{
+	return Vector3fPacket<N>(-v.x(), -v.y(), -v.z());
+}
+
+template <int N>
+inline Vector3fPacket<N> operator * (const Vector3fPacket<N>& v, const FloatPacket<N>& f)
+{
+	return Vector3fPacket<N>(v.x() * f, v.y() * f, v.z() * f);
+}
+
+template <int N>
+inline Vector3fPacket<N> operator * (const FloatPacket<N>& f, const Vector3fPacket<N>& v)
+{
+	return Vector3fPacket<N>(f * v.x(), f * v.y(), f * v.z());
+}
+
+template <int N>
+inline Vector3fPacket<N> operator / (const Vector3fPacket<N>& v, const FloatPacket<N>& f)
+{
+	return Vector3fPacket<N>(v.x() / f, v.y() / f, v.z() / f);
+}
+
+#endif // VECTOR_PACKET_H
@@ -0,0 +1,357 @@
+#pragma once
+#ifndef BVH_H
+#define BVH_H
+
+#include <vector>
+#include <cstddef>
+#include "BoundingBox.h"
+#include "Vector3f.h"
+#include "RayCounters.h"
+#include "RayPacket.h"
+
+#define BVH_BIN_COUNT 16
+#define BVH_STACK_SIZE 64
+// deepest leaf of a hierarchy, traversal pushes at most one node per level above it
+#define BVH_MAX_DEPTH BVH_STACK_SIZE
+#define BVH_TRAVERSAL_COST 0.125f
+#define BVH_INTERSECTION_COST 1.f
+// primitives per chunk when a node is binned in parallel
+#define BVH_PARALLEL_CHUNK_SIZE 16384
+// a subtree of fewer primitives is built by a single task
+#define BVH_TASK_MIN_PRIMITIVES 4096
+
+class ThreadPool;
+struct BVHBuildContext;
+struct BVHBuildScratch;
+struct BVHBuildTask;
+
+///////////////////////////
+// BVH Header
+///////////////////////////
+
+struct BVHNode
+{
+	BoundingBox box;
+	int offset;	// leaf: first entry in the primitive index list, inner node: index of the second child
+	int count;	// number of primitives in a leaf, 0 for inner nodes (first child is the next node)
+	int axis;	// split axis, used to visit the nearest child first
+};
+
+///@brief how BVH::build trades build time against trace time
+struct BVHBuildSettings
+{
+	BVHBuildSettings() : binCount(BVH_BIN_COUNT), maxLeafSize(4), pool(NULL) {}
+	int binCount;		// split candidates of a node along its longest axis, more is slower and closer to the best split
+	int maxLeafSize;	// a leaf holds up to that many primitives when splitting it costs more
+	ThreadPool* pool;	// builds subtrees and bins large nodes in parallel, NULL builds on the calling thread
+};
+
+///@brief traversal counters, used to compare a BVH against brute force
+struct BVHStats
+{
+	BVHStats() : nodeVisits(0), primitiveTests(0) {}
+	long long nodeVisits;
+	long long primitiveTests;
+};
+
+///@brief bounding volume hierarchy over an abstract list of primitives,
+///built with the binned surface area heuristic.
+///Primitives are only known through their bounds, intersection is delegated to the caller.
+class BVH
+{
+public:
+	// Constructors
+	BVH();
+	BVH(const BVH& bvh);
+	BVH& operator= (const BVH& bvh);
+	// Destructors
+	~BVH();
+
+	///@param bounds one box per primitive, the primitive id is its index in the vector
+	void build(const std::vector<BoundingBox>& bounds, int maxLeafSize = 4);
+	///@brief the hierarchy only depends on the bins and leaf size: every pool builds the same one
+	void build(const std::vector<BoundingBox>& bounds, const BVHBuildSettings& settings);
+	///@brief use a hierarchy stored elsewhere (a mapped cache file) without copying it,
+	///the arrays must stay valid as long as the BVH is used
+	void attach(const BVHNode* nodes, int nodeCount, const int* primIndices, int primCount);
+	void clear();
+
+	bool isEmpty() const;
+	int getNodeCount() const;
+	const BVHNode& getNode(int i) const;
+	const BVHNode* getNodes() const;
+	///@brief primitive ids in leaf order, leaves reference ranges of this list
+	const int* getPrimitiveIndices() const;
+	int getPrimitiveCount() const;
+	BoundingBox getBounds() const;
+	///@return duration of the last build, 0 for an attached hierarchy
+	double getBuildSeconds() const;
+	///@brief surface area heuristic of the hierarchy, the expected cost of a ray crossing the root box
+	///in BVH_INTERSECTION_COST units: lower traces faster
+	float getSAHCost() const;
+
+	///@brief closest-hit traversal
+	///@param dir must be normalized so distances match the ones stored in Hit
+	///@param isect functor bool(int primId, float& tmax) testing one primitive, it shrinks tmax when it hits
+	///@param stats optional counters, incremented for each visited node and tested primitive
+	template <class Intersector>
+	bool intersect(const Vector3f& orig, const Vector3f& dir, float tmin, float tmax, Intersector& isect, BVHStats* stats = NULL) const;
+	///@brief closest-hit traversal of the lanes of a packet, nodes are tested once for all the lanes
+	///still reaching them and nodes outside the packet frustum are skipped without any slab test.
+	///Below RAY_PACKET_MIN_LANES lanes the packet has diverged: the remaining lanes
+	///traverse the subtree one by one like intersect
+	///@param isectPacket functor RayMask(int primId, RayMask lanes) testing one primitive against lanes,
+	///it shrinks the tmax of the lanes it hits in packet and returns them
+	///@param isect functor bool(int primId, int lane, float& tmax), the intersect functor of one lane
+	///@return the lanes hit
+	template <class PacketIntersector, class Intersector>
+	RayMask intersect(RayPacket& packet, RayMask lanes, PacketIntersector& isectPacket, Intersector& isect) const;
+	///@brief any-hit traversal, returns as soon as one primitive blocks the ray
+	///@param occlude functor bool(int primId) true if the primitive blocks the ray between tmin and tmax
+	template <class Occluder>
+	bool occluded(const Vector3f& orig, const Vector3f& dir, float tmin, float tmax, Occluder& occlude, BVHStats* stats = NULL) const;
+	///@brief point query, calls visit(primId) for the primitives of each leaf whose box contains p,
+	///a superset of the primitives whose own box contains it
+	template <class Visitor>
+	void visit(const Vector3f& p, Visitor& visit) const;
+
+private:
+	template <class Intersector>
+	bool intersectSubtree(int root, const Vector3f& orig, const Vector3f& dir, float tmin, float& tmax, Intersector& isect, BVHStats* stats) const;
+	///@brief box of the primitives in [start, end), partitioned around mid when they are split
+	///@param depth of the node, its children are kept small enough for their subtrees to fit in BVH_MAX_DEPTH
+	///@return false if they make a leaf
+	bool splitNode(BVHBuildContext& context, BVHBuildScratch& scratch, int start, int end, int depth, BoundingBox& box, int& axis, int& mid);
+	///@brief subtree over [start, end) appended to nodes, offsets of inner nodes index nodes
+	int buildNode(BVHBuildContext& context, BVHBuildScratch& scratch, int start, int end, int depth, std::vector<BVHNode>& nodes);
+	///@brief the same subtree, large ones split their children between tasks of the pool
+	void buildTask(BVHBuildContext& context, int start, int end, int depth, BVHBuildTask& task);
+	///@brief append the nodes of task to m_nodes in depth-first order
+	///@return index of its root
+	int spliceTask(const BVHBuildTask& task);
+	///@brief point the traversal arrays at the built vectors
+	void useOwnedArrays();
+
+	// storage of built hierarchies, empty when attached
+	std::vector<BVHNode> m_nodes;
+	std::vector<int> m_primIndices;
+	// arrays read by the traversal: the vectors above or attached memory
+	const BVHNode* m_nodeData;
+	int m_nodeCount;
+	const int* m_primData;
+	int m_primCount;
+	double m_buildSeconds;
+};
+
+template <class Intersector>
+bool BVH::intersect(const Vector3f& orig, const Vector3f& dir, float tmin, float tmax, Intersector& isect, BVHStats* stats) const
+{
+	if (m_nodeCount == 0) return false;
+	return intersectSubtree(0, orig, dir, tmin, tmax, isect, stats);
+}
+
+template <class PacketIntersector, class Intersector>
+RayMask BVH::intersect(RayPacket& packet, RayMask lanes, PacketIntersector& isectPacket, Intersector& isect) const
+{
+	if (m_nodeCount == 0) return 0;
+
+	int stack[BVH_STACK_SIZE];
+	RayMask laneStack[BVH_STACK_SIZE];
+	int stackSize = 0;
+	int current = 0;
+	RayMask hitLanes = 0;
+
+	while (true)
+	{
+		const BVHNode& node = m_nodeData[current];
+		RAY_COUNT_NODES(1);
+		lanes = packet.overlaps(node.box) ? packet.intersect(node.box, lanes) : 0;
+		if (lanes != 0)
+		{
+			if (RayPacket::hasFewerLanes(lanes, RAY_PACKET_MIN_LANES))
+			{
+				// too few lanes left to fill the SIMD groups, go on ray by ray
+				for (int lane = 0; lane < RAY_PACKET_SIZE; ++lane)
+				{
+					if (((lanes >> lane) & 1) == 0) continue;
+					auto isectLane = [&](int primId, float& tmax)
+					{
+						return isect(primId, lane, tmax);
+					};
+					float tmax = packet.getTMax(lane);
+					if (intersectSubtree(current, packet.getOrigin(lane), packet.getUnitDirection(lane), packet.getTMin(lane), tmax, isectLane, NULL))
+					{
+						packet.setTMax(lane, tmax);
+						hitLanes |= (RayMask)1 << lane;
+					}
+				}
+			}
+			else if (node.count > 0)
+			{
+				RAY_COUNT_TESTS(node.count);
+				for (int i = node.offset; i < node.offset + node.count; ++i)
+				{
+					hitLanes |= isectPacket(m_primData[i], lanes);
+				}
+			}
+			else
+			{
+				// nearest child first along the direction of the first lane,
+				// the other lanes may visit them in the opposite order
+				int second = node.offset;
+				if (packet.getInvDirection(RayPacket::getFirstLane(lanes), node.axis) < 0)
+				{
+					second = current + 1;
+					current = node.offset;
+				}
+				else
+				{
+					current = current + 1;
+				}
+				stack[stackSize] = second;
+				laneStack[stackSize++] = lanes;
+				continue;
+			}
+		}
+		if (stackSize == 0) break;
+		current = stack[--stackSize];
+		lanes = laneStack[stackSize];
+	}
+	return hitLanes;
+}
+
+template <class Intersector>
+bool BVH::intersectSubtree(int root, const Vector3f& orig, const Vector3f& dir, float tmin, float& tmax, Intersector& isect, BVHStats* stats) const
+{
+	Vector3f invDir(1.f / dir[0], 1.f / dir[1], 1.f / dir[2]);
+	bool dirIsNeg[3] = { invDir[0] < 0, invDir[1] < 0, invDir[2] < 0 };
+	int stack[BVH_STACK_SIZE];
+	int stackSize = 0;
+	int current = root;
+	bool isHit = false;
+	float tEntry;
+
+	while (true)
+	{
+		const BVHNode& node = m_nodeData[current];
+		if (stats) stats->nodeVisits++;
+		RAY_COUNT_NODES(1);
+		if (node.box.intersect(orig, invDir, tmin, tmax, tEntry))
+		{
+			if (node.count > 0)
+			{
+				if (stats) stats->primitiveTests += node.count;
+				RAY_COUNT_TESTS(node.count);
+				for (int i = node.offset; i < node.offset + node.count; ++i)
+				{
+					if (isect(m_primData[i], tmax))
+						isHit = true;
+				}
+			}
+			else
+			{
+				// visit the child closest to the ray origin first
+				if (dirIsNeg[node.axis])
+				{
+					stack[stackSize++] = current + 1;
+					current = node.offset;
+				}
+				else
+				{
+					stack[stackSize++] = node.offset;
+					current = current + 1;
+				}
+				continue;
+			}
+		}
+		if (stackSize == 0) break;
+		current = stack[--stackSize];
+	}
+	return isHit;
+}
+
+template <class Occluder>
+bool BVH::occluded(const Vector3f& orig, const Vector3f& dir, float tmin, float tmax, Occluder& occlude, BVHStats* stats) const
+{
+	if (m_nodeCount == 0) return false;
+
+	Vector3f invDir(1.f / dir[0], 1.f / dir[1], 1.f / dir[2]);
+	bool dirIsNeg[3] = { invDir[0] < 0, invDir[1] < 0, invDir[2] < 0 };
+	int stack[BVH_STACK_SIZE];
+	int stackSize = 0;
+	int current = 0;
+	float tEntry;
+
+	while (true)
+	{
+		const BVHNode& node = m_nodeData[current];
+		if (stats) stats->nodeVisits++;
+		RAY_COUNT_NODES(1);
+		if (node.box.intersect(orig, invDir, tmin, tmax, tEntry))
+		{
+			if (node.count > 0)
+			{
+				for (int i = node.offset; i < node.offset + node.count; ++i)
+				{
+					if (stats) stats->primitiveTests++;
+					RAY_COUNT_TESTS(1);
+					if (occlude(m_primData[i]))
+						return true;
+				}
+			}
+			else
+			{
+				// same order as intersect, blockers near the origin are found first
+				if (dirIsNeg[node.axis])
+				{
+					stack[stackSize++] = current + 1;
+					current = node.offset;
+				}
+				else
+				{
+					stack[stackSize++] = node.offset;
+					current = current + 1;
+				}
+				continue;
+			}
+		}
+		if (stackSize == 0) break;
+		current = stack[--stackSize];
+	}
+	return false;
+}
+
+template <class Visitor>
+void BVH::visit(const Vector3f& p, Visitor& visit) const
+{
+	if (m_nodeCount == 0) return;
+
+	int stack[BVH_STACK_SIZE];
+	int stackSize = 0;
+	int current = 0;
+
+	while (true)
+	{
+		const BVHNode& node = m_nodeData[current];
+		if (node.box.contains(p))
+		{
+			if (node.count > 0)
+			{
+				for (int i = node.offset; i < node.offset + node.count; ++i)
+				{
+					visit(m_primData[i]);
+				}
+			}
+			else
+			{
+				stack[stackSize++] = node.offset;
+				current = current + 1;
+				continue;
+			}
+		}
+		if (stackSize == 0) break;
+		current = stack[--stackSize];
+	}
+}
+
+#endif // BVH_H
@@ -0,0 +1,82 @@
+#pragma once
+#ifndef BOUNDING_BOX_H
+#define BOUNDING_BOX_H
+
+#include <float.h>
+#include "Vector3f.h"
+#include "Matrix4f.h"
+
+///////////////////////////
+// BoundingBox Header
+///////////////////////////
+
+///@brief axis-aligned bounding box, empty until something is added to it
+class BoundingBox
+{
+public:
+	// Constructors
+	BoundingBox();
+	BoundingBox(const Vector3f& min, const Vector3f& max);
+
+	const Vector3f& getMin() const;
+	const Vector3f& getMax() const;
+
+	bool isEmpty() const;
+	void extend(const Vector3f& p);
+	void extend(const BoundingBox& box);
+
+	Vector3f getCenter() const;
+	Vector3f getExtent() const;
+	float getSurfaceArea() const;
+	int getLongestAxis() const;
+
+	///@brief slab test against a ray given as origin and inverse direction
+	///@return true if [tmin, tmax] overlaps the box, the entry distance is written to tEntry
+	bool intersect(const Vector3f& orig, const Vector3f& invDir, float tmin, float tmax, float& tEntry) const;
+	///@return true if p is inside the box or on its boundary
+	bool contains(const Vector3f& p) const;
+
+	///@return the box enclosing the eight transformed corners
+	static BoundingBox transformed(const Matrix4f& m, const BoundingBox& box);
+
+private:
+	Vector3f m_min;
+	Vector3f m_max;
+};
+
+inline bool BoundingBox::intersect(const Vector3f& orig, const Vector3f& invDir, float tmin, float tmax, float& tEntry) const
+{
+	for (int i = 0; i < 3; ++i)
+	{
+		float t0 = (m_min[i] - orig[i]) * invDir[i];
+		float t1 = (m_max[i] - orig[i]) * invDir[i];
+		if (t0 > t1)
+		{
+			float tmp = t0;
+			t0 = t1;
+			t1 = tmp;
+		}
+		tmin = (t0 > tmin) ? t0 : tmin;
+		tmax = (t1 < tmax) ? t1 : tmax;
+		if (tmin > tmax)
+		{
+			return false;
+		}
+	}
+	tEntry = tmin;
+	return true;
+}
+
+inline bool BoundingBox::contains(const Vector3f& p) const
+{
+	for (int i = 0; i < 3; ++i)
+	{
+		if (p[i] < m_min[i] || p[i] > m_max[i])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+#endif // BOUNDING_BOX_H
@@ -5,12 +5,15 @@
 #include "Object3D.h"
 #include "Ray.h"
 #include "Hit.h"
+#include "BVH.h"
+#include "WideBVH.h"
 #include <iostream>
 #include <vector>
 
-///TODO: 
-///Implement Group
-///Add data structure to store a list of Object* 
+///Bounded children are stored in a BVH rebuilt lazily after any modification,
+///unbounded ones (planes) are tested one by one.
+///Single rays traverse its wide version, packets the binary one.
+///The group owns its children: replaced, removed and remaining ones are deleted.
 ///////////////////////////
 // Group Header
 //
@@ -26,14 +29,30 @@ public:
 	~Group();
 
 	virtual bool intersect(const Ray& r, Hit& h, float tmin);
+	virtual RayMask intersect(RayPacket& packet, RayMask lanes);
+	virtual bool occluded(const Ray& r, float tmin, float tmax);
+	virtual bool getBoundingBox(BoundingBox& box) const;
+	virtual void prepare();
 	void addObject(Object3D* obj);
 	void modifyObject(int i, Object3D * object);
 	void removeObject(int i);
 	Object3D* getObject(int i) const;
 	int getGroupSize();
 
+	///@brief (re)build the BVH and its wide version over the children, done automatically on the next intersect after a modification
+	void buildBVH();
+
 private:
+	//Control class copy, children are owned
+	Group(const Group& group);
+	Group& operator= (const Group& group);
+
 	std::vector<Object3D*> m_objects;
+	std::vector<int> m_unboundedObjects;
+	std::vector<int> m_bvhObjects; // object index of each BVH primitive
+	BVH m_bvh;
+	WideBVH m_wideBVH; // collapsed from m_bvh
+	bool m_isBVHDirty;
 };
 
 #endif
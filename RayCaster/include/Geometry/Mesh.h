@@ -1,12 +1,10 @@
 #pragma once
 #ifndef MESH_H
 #define MESH_H
-#include <vector>
-#include <cstdlib>
+#include <memory>
+#include <string>
 #include "Object3D.h"
-#include "Triangle.h"
-#include "Vector2f.h"
-#include "Vector3f.h"
+#include "MeshGeometry.h"
 //#include "Trig.h"
 
 //by default counterclockwise winding is front face
@@ -15,33 +13,31 @@
 //
 // Nicolas Bordes - 10/2016
 ///////////////////////////
-struct Trig {
-	Trig() 
-	{ 
-		x[0] = 0; 
-		x[1] = 0; 
-		x[2] = 0; 
-	}
-	int & operator[](const int i) { return x[i]; }
-	int x[3];
-	int texID[3];
-};
-
+///@brief instance of a shared MeshGeometry with its own material.
+///Wrap it in a Transform to place it: the scene Group BVH is then the top level
+///over instances and each MeshGeometry BVH the bottom level.
 class Mesh :public Object3D {
 public:
+	///@brief instance of filename, the file is only parsed for its first living instance
 	Mesh(const char * filename, Material* m);
+	Mesh(const std::shared_ptr<const MeshGeometry>& geometry, Material* m);
 	~Mesh();
-	std::vector<Vector3f>v;
-	std::vector<Trig>t;
-	std::vector<Vector3f>n;
-	std::vector<Vector2f>texCoord;
 
 	virtual bool intersect(const Ray& r, Hit& h, float tmin);
+	virtual bool occluded(const Ray& r, float tmin, float tmax);
+	///@brief the lanes traverse the geometry BVH together, see MeshGeometry::intersect
+	virtual RayMask intersect(RayPacket& packet, RayMask lanes);
+	///@brief BVH traversal, stats counts visited nodes and tested triangles
+	bool intersect(const Ray& r, Hit& h, float tmin, BVHStats* stats);
+	///@brief reference path testing every triangle
+	bool intersectBruteForce(const Ray& r, Hit& h, float tmin, BVHStats* stats = NULL);
+	virtual bool getBoundingBox(BoundingBox& box) const;
 	std::string getFilename() const;
+	///@brief shared geometry, NULL if the file could not be loaded
+	const std::shared_ptr<const MeshGeometry>& getGeometry() const;
 
 private:
-	void compute_norm();
-	std::string m_filename;
+	std::shared_ptr<const MeshGeometry> m_geometry;
 };
 
 #endif
@@ -0,0 +1,155 @@
+#pragma once
+#ifndef MESH_GEOMETRY_H
+#define MESH_GEOMETRY_H
+
+#include <float.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Ray.h"
+#include "Hit.h"
+#include "Material.h"
+#include "BVH.h"
+#include "WideBVH.h"
+#include "MappedFile.h"
+#include "Vector2f.h"
+#include "Vector3f.h"
+
+#define MESH_CACHE_EXTENSION ".rcmesh"
+// bump when the cached arrays or the way they are built change
+#define MESH_CACHE_VERSION 2
+
+///////////////////////////
+// MeshGeometry Header
+///////////////////////////
+struct Trig {
+	Trig()
+	{
+		x[0] = 0;
+		x[1] = 0;
+		x[2] = 0;
+	}
+	int & operator[](const int i) { return x[i]; }
+	const int & operator[](const int i) const { return x[i]; }
+	int x[3];
+	int texID[3];
+};
+
+///@brief closest triangle found during traversal, attributes are interpolated afterwards
+struct TriangleHit {
+	TriangleHit() :t(FLT_MAX), u(0), v(0), triangle(-1) {}
+	float t;
+	float u;
+	float v;
+	int triangle;
+};
+
+///@brief triangles of one .obj file with their bottom level BVH.
+///Immutable once loaded and shared by every Mesh instance of the same file,
+///so a thousand instances cost one copy of the vertices and of the hierarchy.
+///After a parse, everything is written beside the .obj in a binary cache (file.obj.rcmesh)
+///keyed by the source name, size and modification time; later loads map that file
+///and use its arrays in place, without parsing, normal computation or BVH build.
+class MeshGeometry {
+public:
+	///@brief geometry of filename, loaded only if no living instance already uses it
+	///or the file changed on disk since, concurrent calls for the same file wait for a single load
+	///@return NULL if the file can't be opened
+	static std::shared_ptr<const MeshGeometry> load(const char * filename);
+	///@brief read and write the binary cache, on by default
+	static void setCacheEnabled(bool isEnabled);
+	static bool isCacheEnabled();
+	///@brief bins and leaf size of the BVH of the next meshes parsed, a cache built with other ones is rebuilt.
+	///The default builds on the global thread pool, see BVH::getBuildSeconds and BVH::getSAHCost to compare settings
+	static void setBVHBuildSettings(const BVHBuildSettings& settings);
+	static BVHBuildSettings getBVHBuildSettings();
+
+	~MeshGeometry();
+
+	const std::string& getFilename() const;
+	int getVertexCount() const;
+	int getTriangleCount() const;
+	int getTexCoordCount() const;
+	const Vector3f* getVertices() const;
+	const Vector3f* getNormals() const;
+	const Trig* getTriangles() const;
+	const Vector2f* getTexCoords() const;
+	const BoundingBox& getBoundingBox() const;
+	const BVH& getBVH() const;
+	const WideBVH& getWideBVH() const;
+	///@return true if the arrays are mapped from the binary cache
+	bool isFromCache() const;
+
+	///@brief closest triangle along r in [tmin, hit.t), r direction must be normalized
+	///@param stats counts visited nodes and tested triangles
+	bool intersect(const Ray& r, float tmin, TriangleHit& hit, BVHStats* stats = NULL) const;
+	///@brief closest triangles of the lanes of a packet, triangles are tested against RAY_PACKET_WIDTH lanes at once
+	///@param hits one per lane, the closest triangle found so far, its t is the packet tmax of the lane
+	///@return the lanes whose hit changed
+	RayMask intersect(RayPacket& packet, RayMask lanes, TriangleHit* hits) const;
+	///@brief reference path testing every triangle
+	bool intersectBruteForce(const Ray& r, float tmin, TriangleHit& hit, BVHStats* stats = NULL) const;
+	///@brief any-hit query, stops at the first triangle between tmin and tmax
+	///@param r its direction must be normalized
+	bool occluded(const Ray& r, float tmin, float tmax, BVHStats* stats = NULL) const;
+	///@brief interpolate normal and texture coordinates of the closest triangle into h,
+	///the texture coordinate differentials come from the differentials of r when it has some
+	void setHit(const TriangleHit& triHit, Material* material, const Ray& r, Hit& h) const;
+
+private:
+	MeshGeometry(const char * filename);
+	//Control class copy
+	MeshGeometry(const MeshGeometry& geometry);
+	MeshGeometry& operator= (const MeshGeometry& geometry);
+
+	bool loadObj(const char * filename);
+	///@brief barycentrics of the intersection of a ray with the plane of triangle i
+	///@return false if the ray is parallel to the plane
+	bool getPlaneBarycentrics(int i, const Vector3f& orig, const Vector3f& dir, float& u, float& v) const;
+	///@return false if there is no cache or it doesn't match the source file
+	bool loadCache(const char * filename);
+	void writeCache(const char * filename) const;
+	void compute_norm();
+	void buildBVH();
+	void buildTriangleRecords();
+	///@brief point the arrays used by intersection and shading at the parsed vectors
+	void useParsedArrays();
+	///@brief Moller-Trumbore test against the precomputed record of triangle i
+	///@param orig dir ray as raw floats, dir normalized
+	///@return true if tmin <= t < tmax, with u v the barycentric weights of the 2nd and 3rd vertices
+	bool intersectTriangle(int i, const float orig[3], const float dir[3], float tmin, float tmax, float& t, float& u, float& v) const;
+	///@brief the same test on the lanes of group g of packet, with the same operations so every lane finds the same t, u and v
+	///@return bit k set when lane k of the group hits between its tmin and tmax
+	unsigned int intersectTriangle(int i, const RayPacket& packet, int g, RayPacket::Floats& t, RayPacket::Floats& u, RayPacket::Floats& v) const;
+
+	std::string m_filename;
+	unsigned long long m_fileSize;
+	long long m_fileTime;
+	BoundingBox m_box;
+	BVH m_bvh;
+	WideBVH m_wideBVH; // collapsed from m_bvh, traversed by single rays when enabled
+
+	// parsed data, empty when the geometry comes from the cache
+	std::vector<Vector3f> v;
+	std::vector<Trig> t;
+	std::vector<Vector3f> n;
+	std::vector<Vector2f> texCoord;
+	// triangle records in structure-of-arrays layout, indexed like t:
+	// first vertex and the two edges leaving it, one array per component
+	std::vector<float> m_triRecords;
+
+	// arrays used by intersection and shading, in the vectors above or in m_cacheFile
+	const Vector3f* m_v;
+	const Trig* m_t;
+	const Vector3f* m_n;
+	const Vector2f* m_texCoord;
+	int m_vertexCount;
+	int m_triangleCount;
+	int m_texCoordCount;
+	const float* m_triV0[3];
+	const float* m_triEdge1[3];
+	const float* m_triEdge2[3];
+	MappedFile m_cacheFile;
+};
+
+#endif // MESH_GEOMETRY_H
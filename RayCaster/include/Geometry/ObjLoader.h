@@ -0,0 +1,38 @@
+#pragma once
+#ifndef OBJ_LOADER_H
+#define OBJ_LOADER_H
+
+#include <cstddef>
+#include <vector>
+#include "MeshGeometry.h"
+#include "Vector2f.h"
+#include "Vector3f.h"
+
+#define OBJ_LOADER_MIN_CHUNK_SIZE (1 << 20)
+
+///////////////////////////
+// ObjLoader Header
+///////////////////////////
+
+///@brief Wavefront OBJ reader working on a memory mapped file.
+///Reads v, vt and f records, faces may be v, v/vt, v/vt/vn or v//vn,
+///negative indices are relative to the end of the list, quads and n-gons are fan triangulated.
+///Triangles with an index out of range are dropped (and reported by load).
+///vn records are skipped: MeshGeometry computes smooth vertex normals itself.
+///Files bigger than OBJ_LOADER_MIN_CHUNK_SIZE are split on line boundaries
+///into chunks parsed in parallel on the global ThreadPool.
+class ObjLoader
+{
+public:
+	///@return false if the file can't be opened
+	static bool load(const char* filename, std::vector<Vector3f>& v, std::vector<Vector2f>& texCoord, std::vector<Trig>& t);
+	///@brief parse an in-memory OBJ file, the buffer doesn't need a terminating 0
+	///@param chunkCount 0 picks it from the buffer size and the thread count
+	///@return the number of triangles dropped because an index is out of range
+	static int parse(const char* data, size_t size, std::vector<Vector3f>& v, std::vector<Vector2f>& texCoord, std::vector<Trig>& t, int chunkCount = 0);
+	///@brief parse a decimal or scientific number starting at c and move c past it
+	///@return false if no number starts at c
+	static bool parseFloat(const char*& c, const char* end, float& f);
+};
+
+#endif // OBJ_LOADER_H
@@ -5,6 +5,8 @@
 #include "Ray.h"
 #include "Hit.h"
 #include "Material.h"
+#include "BoundingBox.h"
+#include "RayPacket.h"
 
 /////////////////////////////////
 // Object3D Abstract class Header
@@ -25,6 +27,45 @@ public:
 	}
 
 	virtual bool intersect(const Ray& r, Hit& h, float tmin) = 0;
+	///@brief any-hit query for shadow rays: true if something lies between tmin and tmax,
+	///measured along the normalized direction like intersect. Overridden to stop at the first blocker,
+	///the default runs a closest-hit search
+	virtual bool occluded(const Ray& r, float tmin, float tmax)
+	{
+		Hit h(tmax, NULL, Vector3f(0.f));
+		return intersect(r, h, tmin);
+	}
+	///@brief closest hits of the lanes of a packet, each one the hit intersect finds for its ray alone.
+	///Updates the Hit and the tmax of every lane it hits. Overridden to test the lanes together,
+	///the default intersects them one by one
+	///@param lanes the lanes to trace, a subset of packet.getLanes()
+	///@return the lanes hit
+	virtual RayMask intersect(RayPacket& packet, RayMask lanes)
+	{
+		RayMask hitLanes = 0;
+		for (int i = 0; i < RAY_PACKET_SIZE; ++i)
+		{
+			if (((lanes >> i) & 1) == 0) continue;
+			Hit& h = packet.getHit(i);
+			if (intersect(packet.getRay(i), h, packet.getTMin(i)))
+			{
+				packet.setTMax(i, h.getT());
+				hitLanes |= (RayMask)1 << i;
+			}
+		}
+		return hitLanes;
+	}
+	///@brief world-space bounds of the object
+	///@return false if the object is unbounded (e.g. a plane)
+	virtual bool getBoundingBox(BoundingBox& box) const
+	{
+		return false;
+	}
+	///@brief build pending acceleration structures so that intersect
+	///no longer modifies the object and can be called from several threads
+	virtual void prepare()
+	{
+	}
 
 	char* type;
 protected:
@@ -23,10 +23,16 @@ public:
 	~Sphere();
 
 	virtual bool intersect(const Ray& r, Hit& h, float tmin);
+	///@brief finds the lanes crossing the sphere RAY_PACKET_WIDTH at a time
+	virtual RayMask intersect(RayPacket& packet, RayMask lanes);
+	virtual bool getBoundingBox(BoundingBox& box) const;
 	Vector3f getCenter() const;
 	float getRadius() const;
 
 protected:
+	///@brief root of t^2 + b t + c = 0 between tmin and tmax, the near one unless it is before tmin
+	static bool getRoot(float b, float c, float tmin, float tmax, float& t);
+
 	Vector3f m_center;
 	float m_radius;
 };
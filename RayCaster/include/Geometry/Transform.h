@@ -4,6 +4,10 @@
 
 #include "Matrix4f.h"
 #include "Object3D.h"
+
+// fewer lanes than this reaching a transform trace its object one ray at a time
+#define TRANSFORM_PACKET_MIN_LANES 8
+
 ///TODO implement this class
 ///So that the intersect function first transforms the ray
 ///Add more fields as necessary
@@ -21,12 +25,40 @@ public:
 	~Transform();
 
 	virtual bool intersect(const Ray& r, Hit& h, float tmin);
+	///@brief the lanes go through the inverse matrix together, then into the object as one packet
+	virtual RayMask intersect(RayPacket& packet, RayMask lanes);
+	virtual bool occluded(const Ray& r, float tmin, float tmax);
+	virtual bool getBoundingBox(BoundingBox& box) const;
+	virtual void prepare();
 	Object3D * getObject() const;
 	Matrix4f getTransformationMatrix() const;
+	///@brief replace the matrix and recompute the cached inverses
+	void setTransformationMatrix(const Matrix4f& m);
+	///@brief true when the last row is (0, 0, 0, 1), rays then go through the 3x4 path
+	bool isAffine() const;
 
 protected:
-	Object3D* m_obj; //un-transformed object	
+	void updateInverse();
+	///@brief origin and normalized direction of r through the inverse matrix
+	void toObjectSpace(const Ray& r, Vector3f& transfOrig, Vector3f& transfDir) const;
+	///@brief ray differentials (see Ray::setDifferentials) through the inverse matrix
+	void toObjectSpace(const float* differentials, float* transfDifferentials) const;
+	///@brief write objHit, found along a ray whose distances were multiplied by scale, into h
+	void toWorldSpace(const Hit& objHit, float scale, Hit& h) const;
+
+	Object3D* m_obj; //un-transformed object, owned
 	Matrix4f m_transMatrix;
+	// cached once per matrix change instead of once per ray
+	Matrix4f m_invMatrix;
+	Matrix4f m_normalMatrix; // inverse transposed
+	bool m_isAffine;
+	float m_invAffine[12];	// 3 first rows of the inverse, row major
+	float m_normalAffine[9];	// upper 3x3 of the inverse transposed, row major
+
+private:
+	//Control class copy, the object is owned
+	Transform(const Transform& transform);
+	Transform& operator= (const Transform& transform);
 };
 
 #endif //TRANSFORM_H
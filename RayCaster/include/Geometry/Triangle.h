@@ -19,6 +19,7 @@ public:
 	Triangle(const Vector3f& a, const Vector3f& b, const Vector3f& c, Material* m);
 
 	virtual bool intersect(const Ray& ray, Hit& hit, float tmin);
+	virtual bool getBoundingBox(BoundingBox& box) const;
 	bool hasTex;
 	Vector3f normals[3];
 	Vector2f texCoords[3];
@@ -0,0 +1,214 @@
+#pragma once
+#ifndef WIDE_BVH_H
+#define WIDE_BVH_H
+
+#include <vector>
+#include <cstddef>
+#include "BVH.h"
+#include "VectorPacket.h"
+
+// children per node, tested together by one SIMD slab test
+#define WIDE_BVH_WIDTH 4
+// quantization steps of a child box along each axis of its parent
+#define WIDE_BVH_STEPS 255
+#define WIDE_BVH_STACK_SIZE (BVH_STACK_SIZE * WIDE_BVH_WIDTH)
+
+///////////////////////////
+// WideBVH Header
+///////////////////////////
+
+///@brief node of WIDE_BVH_WIDTH children, their boxes stored as structure of arrays
+///and quantized on a grid of WIDE_BVH_STEPS steps over the node box
+struct WideBVHNode
+{
+	float origin[3];	// lower corner of the node box
+	float scale[3];		// size of one step along each axis
+	unsigned char lower[3][WIDE_BVH_WIDTH];	// child boxes in steps from origin, rounded outwards
+	unsigned char upper[3][WIDE_BVH_WIDTH];
+	int child[WIDE_BVH_WIDTH];	// inner child: node index, leaf child: first entry in the primitive index list
+	int count[WIDE_BVH_WIDTH];	// primitives of a leaf child, 0 for an inner child
+	int childCount;
+};
+
+///@brief BVH collapsed to WIDE_BVH_WIDTH children per node: a ray tests all the children of a node
+///with one SIMD slab test and visits the ones it enters nearest first.
+///Child boxes are quantized to bytes, a node fits in a few cache lines instead of one per child.
+///The leaves are the ones of the binary BVH it is built from and index its primitive list,
+///so that BVH must outlive it and intersection is delegated to the caller the same way.
+///Dequantized boxes contain the exact ones, a ray finds the same closest hit as with the binary BVH,
+///up to the order in which primitives at the very same distance are found
+class WideBVH
+{
+public:
+	typedef FloatPacket<WIDE_BVH_WIDTH> Floats;
+
+	// Constructors
+	WideBVH();
+
+	///@brief collapse bvh, largest children first
+	void build(const BVH& bvh);
+	void clear();
+
+	bool isEmpty() const;
+	int getNodeCount() const;
+	const WideBVHNode& getNode(int i) const;
+
+	///@brief closest-hit traversal, the arguments of BVH::intersect
+	template <class Intersector>
+	bool intersect(const Vector3f& orig, const Vector3f& dir, float tmin, float tmax, Intersector& isect, BVHStats* stats = NULL) const;
+	///@brief any-hit traversal, the arguments of BVH::occluded
+	template <class Occluder>
+	bool occluded(const Vector3f& orig, const Vector3f& dir, float tmin, float tmax, Occluder& occlude, BVHStats* stats = NULL) const;
+
+	///@brief Group and MeshGeometry trace single rays through their wide BVH,
+	///on by default unless the packets are built on the scalar fallback. Packets keep the binary one
+	static void setEnabled(bool enabled);
+	static bool isEnabled();
+
+private:
+	//Control class copy, the leaves point into the primitive list of the source BVH
+	WideBVH(const WideBVH& bvh);
+	WideBVH& operator= (const WideBVH& bvh);
+
+	///@return index of the wide node made of the descendants of binary node i
+	int collapseNode(const BVH& bvh, int i);
+	///@brief entry distances of the ray into the children of node, bit k of the result is set when it enters child k
+	unsigned int intersectChildren(const WideBVHNode& node, const Floats orig[3], const Floats invDir[3], float tmin, float tmax, Floats& tEntry) const;
+
+	std::vector<WideBVHNode> m_nodes;
+	const int* m_primData;
+};
+
+inline unsigned int WideBVH::intersectChildren(const WideBVHNode& node, const Floats orig[3], const Floats invDir[3], float tmin, float tmax, Floats& tEntry) const
+{
+	Floats tNear(tmin), tFar(tmax);
+	for (int i = 0; i < 3; ++i)
+	{
+		Floats origin(node.origin[i]), scale(node.scale[i]);
+		Floats t0 = (origin + Floats::loadBytes(node.lower[i]) * scale - orig[i]) * invDir[i];
+		Floats t1 = (origin + Floats::loadBytes(node.upper[i]) * scale - orig[i]) * invDir[i];
+		// the comparisons of BoundingBox::intersect
+		tNear = Floats::max(Floats::min(t1, t0), tNear);
+		tFar = Floats::min(Floats::max(t0, t1), tFar);
+	}
+	tEntry = tNear;
+	return (tNear <= tFar).getBits() & ((1u << node.childCount) - 1);
+}
+
+template <class Intersector>
+bool WideBVH::intersect(const Vector3f& orig, const Vector3f& dir, float tmin, float tmax, Intersector& isect, BVHStats* stats) const
+{
+	if (m_nodes.empty()) return false;
+
+	Floats origins[3] = { orig[0], orig[1], orig[2] };
+	Floats invDirs[3] = { 1.f / dir[0], 1.f / dir[1], 1.f / dir[2] };
+	int stackChild[WIDE_BVH_STACK_SIZE];
+	int stackCount[WIDE_BVH_STACK_SIZE];
+	float stackT[WIDE_BVH_STACK_SIZE];
+	int stackSize = 0;
+	int current = 0;
+	bool isHit = false;
+	Floats tEntry;
+
+	while (true)
+	{
+		const WideBVHNode& node = m_nodes[current];
+		if (stats) stats->nodeVisits++;
+		RAY_COUNT_NODES(1);
+		unsigned int hits = intersectChildren(node, origins, invDirs, tmin, tmax, tEntry);
+		// children sorted by entry distance on top of the stack, the nearest is popped first
+		int first = stackSize;
+		for (; hits != 0; hits &= hits - 1)
+		{
+			int k = 0;
+			while (((hits >> k) & 1) == 0) ++k;
+			float t = tEntry[k];
+			int j = stackSize++;
+			for (; j > first && stackT[j - 1] < t; --j)
+			{
+				stackChild[j] = stackChild[j - 1];
+				stackCount[j] = stackCount[j - 1];
+				stackT[j] = stackT[j - 1];
+			}
+			stackChild[j] = node.child[k];
+			stackCount[j] = node.count[k];
+			stackT[j] = t;
+		}
+
+		// leaves are tested as they are popped, until an inner node
+		current = -1;
+		while (current < 0 && stackSize > 0)
+		{
+			--stackSize;
+			// a hit found since it was pushed may be closer than the child
+			if (stackT[stackSize] > tmax) continue;
+			int count = stackCount[stackSize];
+			if (count == 0)
+			{
+				current = stackChild[stackSize];
+				continue;
+			}
+			if (stats) stats->primitiveTests += count;
+			RAY_COUNT_TESTS(count);
+			for (int i = stackChild[stackSize]; i < stackChild[stackSize] + count; ++i)
+			{
+				if (isect(m_primData[i], tmax))
+					isHit = true;
+			}
+		}
+		if (current < 0) break;
+	}
+	return isHit;
+}
+
+template <class Occluder>
+bool WideBVH::occluded(const Vector3f& orig, const Vector3f& dir, float tmin, float tmax, Occluder& occlude, BVHStats* stats) const
+{
+	if (m_nodes.empty()) return false;
+
+	Floats origins[3] = { orig[0], orig[1], orig[2] };
+	Floats invDirs[3] = { 1.f / dir[0], 1.f / dir[1], 1.f / dir[2] };
+	int stackChild[WIDE_BVH_STACK_SIZE];
+	int stackCount[WIDE_BVH_STACK_SIZE];
+	int stackSize = 0;
+	int current = 0;
+	Floats tEntry;
+
+	while (true)
+	{
+		const WideBVHNode& node = m_nodes[current];
+		if (stats) stats->nodeVisits++;
+		RAY_COUNT_NODES(1);
+		// any blocker will do, children go on the stack in slot order
+		for (unsigned int hits = intersectChildren(node, origins, invDirs, tmin, tmax, tEntry); hits != 0; hits &= hits - 1)
+		{
+			int k = 0;
+			while (((hits >> k) & 1) == 0) ++k;
+			stackChild[stackSize] = node.child[k];
+			stackCount[stackSize++] = node.count[k];
+		}
+
+		current = -1;
+		while (current < 0 && stackSize > 0)
+		{
+			--stackSize;
+			int count = stackCount[stackSize];
+			if (count == 0)
+			{
+				current = stackChild[stackSize];
+				continue;
+			}
+			for (int i = stackChild[stackSize]; i < stackChild[stackSize] + count; ++i)
+			{
+				if (stats) stats->primitiveTests++;
+				RAY_COUNT_TESTS(1);
+				if (occlude(m_primData[i]))
+					return true;
+			}
+		}
+		if (current < 0) break;
+	}
+	return false;
+}
+
+#endif // WIDE_BVH_H
@@ -22,6 +22,9 @@ class Camera
 public:
 	//generate rays for each screen-space coordinate
 	virtual Ray generateRay(const Vector2f& point) = 0;
+	///@brief ray with differentials towards the next pixel in x and y
+	///@param pixelSize screen-space distance between two neighbouring pixels
+	virtual Ray generateRay(const Vector2f& point, const Vector2f& pixelSize) { return generateRay(point); }
 
 	virtual float getTMin() const = 0;
 	virtual ~Camera() {}
@@ -42,10 +45,12 @@ public:
 	PerspectiveCamera(const Vector3f& center, const Vector3f& direction, const Vector3f& up, float angle, float aspectRatio = 1);
 
 	virtual Ray generateRay(const Vector2f& point);
+	virtual Ray generateRay(const Vector2f& point, const Vector2f& pixelSize);
 
 	virtual float getTMin() const;
 
 	void setAngle(float angle);
+	void setAspectRatio(float aspectRatio);
 
 private:
 	float m_angle;
@@ -32,9 +32,14 @@ public:
 	const Vector3f& getNormal() const;
 
 	void set(float _t, Material* m, const Vector3f& n);
+	///@brief also clears the texture coordinate differentials
 	void setTexCoord(const Vector2f & coord);
+	void setTexCoordDifferentials(const Vector2f & dx, const Vector2f & dy);
 	bool hasTex;
 	Vector2f texCoord;
+	// texture coordinates change towards the next pixel in x and y, zero without ray differentials
+	Vector2f texCoordDx;
+	Vector2f texCoordDy;
 private:
 	float m_t;
 	Material* m_material;
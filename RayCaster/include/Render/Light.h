@@ -2,6 +2,7 @@
 #ifndef LIGHT_H
 #define LIGHT_H
 
+#include <float.h>
 #include <Vector3f.h>
 #include "Object3D.h"
 
@@ -24,7 +25,15 @@ public:
 
 	}
 
+	///@param dir normalized direction from p to the light
+	///@param distanceToLight distance from p to the light, FLT_MAX for lights at infinity
 	virtual void getIllumination(const Vector3f& p, Vector3f& dir, Vector3f& col, float& distanceToLight) const = 0;
+	///@brief region outside of which the light contributes nothing
+	///@return false if the light reaches the whole scene
+	virtual bool getBoundingBox(BoundingBox& box) const
+	{
+		return false;
+	}
 
 };
 
@@ -35,7 +44,7 @@ public:
 	DirectionalLight(const Vector3f& d, const Vector3f& c);
 	~DirectionalLight();
 	///@param p unsed in this function
-	///@param distanceToLight not well defined because it's not a point light
+	///@param distanceToLight FLT_MAX, the light is at infinity
 	virtual void getIllumination(const Vector3f& p, Vector3f& dir, Vector3f& col, float& distanceToLight) const;
 
 	Vector3f getDirection() const;
@@ -57,10 +66,13 @@ class PointLight : public Light
 {
 public:
 
-	PointLight(const Vector3f& p, const Vector3f& c);
+	///@param radius distance at which the light fades out, 0 for a light reaching the whole scene
+	PointLight(const Vector3f& p, const Vector3f& c, float radius = 0);
 	~PointLight();
 
+	///@param col the color, attenuated to 0 at the radius when the light has one
 	virtual void getIllumination(const Vector3f& p, Vector3f& dir, Vector3f& col, float& distanceToLight) const;
+	virtual bool getBoundingBox(BoundingBox& box) const;
 
 	Vector3f getPosition() const;
 	void setPosition(const Vector3f & position);
@@ -68,12 +80,16 @@ public:
 	Vector3f getColor() const;
 	void setColor(const Vector3f & color);
 
+	float getRadius() const;
+	void setRadius(float radius);
+
 private:
 
 	PointLight(); // don't use
 
 	Vector3f m_position;
 	Vector3f m_color;
+	float m_radius;
 
 };
 
@@ -0,0 +1,84 @@
+#pragma once
+#ifndef LIGHT_BVH_H
+#define LIGHT_BVH_H
+
+#include <vector>
+#include "BVH.h"
+#include "Light.h"
+
+///////////////////////////
+// LightBVH Header
+///////////////////////////
+
+///@brief finds the lights that can reach a point.
+///Lights with a bounding box (point lights with a radius) are stored in a BVH,
+///the other ones reach every point and are always visited.
+///Like Group, the BVH is rebuilt lazily after invalidate: call prepare before
+///visiting from several threads.
+class LightBVH
+{
+public:
+	///@param lights kept by reference, the owner calls invalidate when it changes them
+	LightBVH(const std::vector<Light*>& lights);
+	~LightBVH();
+
+	///@brief the lights were added, removed, moved or resized
+	void invalidate();
+	///@brief rebuild the BVH if invalidated
+	void prepare();
+
+	///@brief calls visit(light) for every unbounded light in order, then for the bounded lights
+	///whose box contains p, and maybe a few more of the same BVH leaves
+	template <class Visitor>
+	void visit(const Vector3f& p, Visitor& visit);
+
+	int getBoundedLightCount() const;
+
+	///@brief when disabled, visit calls every light in scene order.
+	///Meant to compare against the brute force loop, the BVH is built either way
+	static void setCullingEnabled(bool enabled);
+	static bool isCullingEnabled();
+
+private:
+	//Control class copy
+	LightBVH(const LightBVH& bvh);
+	LightBVH& operator= (const LightBVH& bvh);
+
+	void build();
+
+	const std::vector<Light*>& m_lights;
+	std::vector<int> m_unboundedLights;
+	std::vector<int> m_bvhLights; // light index of each BVH primitive
+	BVH m_bvh;
+	bool m_isDirty;
+};
+
+template <class Visitor>
+void LightBVH::visit(const Vector3f& p, Visitor& visit)
+{
+	if (m_isDirty)
+		build();
+
+	if (!isCullingEnabled())
+	{
+		for (unsigned int i = 0; i < m_lights.size(); ++i)
+		{
+			visit(m_lights[i]);
+		}
+		return;
+	}
+
+	for (unsigned int i = 0; i < m_unboundedLights.size(); ++i)
+	{
+		visit(m_lights[m_unboundedLights[i]]);
+	}
+	if (m_bvhLights.empty()) return;
+
+	auto visitLight = [&](int i)
+	{
+		visit(m_lights[m_bvhLights[i]]);
+	};
+	m_bvh.visit(p, visitLight);
+}
+
+#endif // LIGHT_BVH_H
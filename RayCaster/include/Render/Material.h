@@ -3,6 +3,7 @@
 #define MATERIAL_H
 
 #include <cassert>
+#include <memory>
 #include "Vector3f.h"
 #include "Texture.h"
 
@@ -22,16 +23,29 @@ public:
 	virtual ~Material();
 
 	virtual Vector3f getDiffuseColor() const;
+	///@brief diffuse color at the hit point: the texture when the hit has coordinates, the diffuse color otherwise.
+	///The texture level of detail comes from the texture coordinate differentials of the hit
+	Vector3f getSurfaceColor(const Hit& hit) const;
 	Vector3f getSpecularColor() const;
 	float getShininess() const;
+	const std::shared_ptr<Texture>& getTexture() const;
+	///@brief edited in place so that the objects using the material see the change
+	void setDiffuseColor(const Vector3f& color);
+	void setSpecularColor(const Vector3f& color);
+	void setShininess(float s);
+	///@param texture shared with the other materials using the same file, NULL removes it
+	void setTexture(const std::shared_ptr<Texture>& texture);
 	Vector3f Shade(const Ray& ray, const Hit& hit, const Vector3f& dirToLight, const Vector3f& lightColor);
+	///@param surfaceColor getSurfaceColor(hit), looked up once for all the lights or in a batch
+	Vector3f Shade(const Ray& ray, const Hit& hit, const Vector3f& dirToLight, const Vector3f& lightColor, const Vector3f& surfaceColor);
+	///@brief texture from the process-wide TextureCache, shared with every material using the file
 	void loadTexture(const char * filename);
 
 protected:
 	Vector3f m_diffuseColor;
 	Vector3f m_specularColor;
 	float m_shininess;
-	Texture m_t;
+	std::shared_ptr<Texture> m_t;
 };
 
 
@@ -23,6 +23,19 @@ public:
 
 	Vector3f pointAtParameter(float t) const;
 
+	///@brief rays through the neighbouring pixels in x and y, used to estimate the
+	///texture footprint of a hit. Their directions don't need to be normalized.
+	void setDifferentials(const Vector3f& dxOrigin, const Vector3f& dxDirection, const Vector3f& dyOrigin, const Vector3f& dyDirection);
+	///@param differentials dx origin, dx direction, dy origin and dy direction, 3 floats each
+	void setDifferentials(const float* differentials);
+	bool hasDifferentials() const;
+	///@brief the 12 floats of setDifferentials, only meaningful when hasDifferentials
+	const float* getDifferentials() const;
+	Vector3f getDxOrigin() const;
+	Vector3f getDxDirection() const;
+	Vector3f getDyOrigin() const;
+	Vector3f getDyDirection() const;
+
 private:
 
 	// don't use this constructor
@@ -31,6 +44,10 @@ private:
 	Vector3f m_origin;
 	Vector3f m_direction;
 
+	// dx origin, dx direction, dy origin, dy direction. Plain floats: rays are built
+	// for every instance a ray visits, they're only written when the ray has differentials
+	bool m_hasDifferentials;
+	float m_differentials[4][3];
 };
 
 inline std::ostream& operator << (std::ostream& os, const Ray& r)
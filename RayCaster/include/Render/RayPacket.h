@@ -0,0 +1,259 @@
+#pragma once
+#ifndef RAY_PACKET_H
+#define RAY_PACKET_H
+
+#include "Ray.h"
+#include "Hit.h"
+#include "BoundingBox.h"
+#include "Vector3f.h"
+#include "VectorPacket.h"
+
+// rays of a packet, the primary rays of 8x8 pixels
+#define RAY_PACKET_SIZE 64
+// rays going through one SIMD instruction sequence, the packet is split in groups of that many lanes
+#define RAY_PACKET_WIDTH 8
+#define RAY_PACKET_GROUPS (RAY_PACKET_SIZE / RAY_PACKET_WIDTH)
+// a BVH node reached by fewer lanes than this is traversed by each of them alone
+#define RAY_PACKET_MIN_LANES 2
+// a box is only culled by a frustum plane when it is further out than the rounding of the test
+#define RAY_PACKET_FRUSTUM_EPSILON 1e-5f
+
+///@brief one bit per lane of a RayPacket, lane i is bit i
+typedef unsigned long long RayMask;
+
+///////////////////////////
+// RayPacket Header
+///////////////////////////
+
+///@brief up to RAY_PACKET_SIZE rays traversing the scene together, see Object3D::intersect(RayPacket&, RayMask).
+///Origins, directions and distances are stored as structure of arrays, RAY_PACKET_WIDTH lanes at a time.
+///Each lane keeps its own tmin, tmax and Hit, and ends with the hit the ray would have found alone:
+///tmax is the distance of the closest hit found so far, like Hit::getT on the single ray path.
+///When the rays share their origin (a pinhole camera), prepare also builds a frustum enclosing them,
+///so a whole node is culled with one test instead of one slab test per lane.
+///Rays stay on the stack: the lanes are left uninitialized until set, only the set ones are read.
+class RayPacket
+{
+public:
+	typedef FloatPacket<RAY_PACKET_WIDTH> Floats;
+	typedef Vector3fPacket<RAY_PACKET_WIDTH> Vectors;
+	typedef MaskPacket<RAY_PACKET_WIDTH> Mask;
+
+	RayPacket();
+
+	///@brief lane i traces r from tmin, up to the distance already in hit.
+	///hit must stay valid as long as the packet is used
+	void setRay(int i, const Ray& r, Hit* hit, float tmin);
+	///@brief rays of the lanes of group g in one go, their hits and differentials are set with setLane
+	///@param directions not necessarily normalized, distances are measured along the normalized ones
+	void setGroup(int g, const Vectors& origins, const Vectors& directions, const Floats& tmin, const Floats& tmax);
+	///@param differentials see Ray::setDifferentials, NULL if the ray of lane i has none
+	void setLane(int i, Hit* hit, const float* differentials);
+	///@brief build the frustum once every lane is set
+	void prepare();
+
+	///@brief lanes holding a ray
+	RayMask getLanes() const;
+	///@brief ray of lane i as it was set, with its differentials
+	Ray getRay(int i) const;
+	Hit& getHit(int i) const;
+	bool hasDifferentials(int i) const;
+	///@brief the 12 floats of Ray::setDifferentials, only meaningful when hasDifferentials
+	const float* getDifferentials(int i) const;
+	Vector3f getOrigin(int i) const;
+	///@brief normalized direction of lane i, the one distances are measured along
+	Vector3f getUnitDirection(int i) const;
+	float getInvDirection(int i, int axis) const;
+	float getTMin(int i) const;
+	float getTMax(int i) const;
+	///@brief shrink the distance of lane i once a closer hit is found
+	void setTMax(int i, float tmax);
+
+	Vectors getOrigins(int g) const;
+	Vectors getUnitDirections(int g) const;
+	Floats getTMins(int g) const;
+	Floats getTMaxes(int g) const;
+
+	///@return lanes whose ray enters box between its tmin and tmax, the slab test of BoundingBox::intersect
+	RayMask intersect(const BoundingBox& box, RayMask lanes) const;
+	///@return false if box is outside the frustum of the packet, so no lane can reach it.
+	///Always true when the rays don't share their origin
+	bool overlaps(const BoundingBox& box) const;
+	bool hasFrustum() const;
+
+	///@brief the RAY_PACKET_WIDTH bits of lanes in group g
+	static unsigned int getGroupLanes(RayMask lanes, int g);
+	///@return true if lanes has fewer than count bits set, without counting them all
+	static bool hasFewerLanes(RayMask lanes, int count);
+	///@return first lane of lanes, which must not be empty
+	static int getFirstLane(RayMask lanes);
+
+private:
+	//Control class copy, hundreds of floats
+	RayPacket(const RayPacket& packet);
+	RayPacket& operator= (const RayPacket& packet);
+
+	RayMask m_lanes;
+	RayMask m_differentialLanes;
+	// lanes of setRay, whose directions prepare still has to normalize
+	RayMask m_rayLanes;
+	// one array per coordinate, indexed by lane
+	float m_origins[3][RAY_PACKET_SIZE];
+	float m_directions[3][RAY_PACKET_SIZE];
+	float m_unitDirections[3][RAY_PACKET_SIZE];
+	float m_invDirections[3][RAY_PACKET_SIZE];
+	float m_tmin[RAY_PACKET_SIZE];
+	float m_tmax[RAY_PACKET_SIZE];
+	Hit* m_hits[RAY_PACKET_SIZE];
+	float m_differentials[RAY_PACKET_SIZE][12];
+
+	// planes through the shared origin, a point q on a ray satisfies dot(normal, q - origin) >= 0 for all of them
+	int m_planeCount;
+	Vector3f m_frustumOrigin;
+	Vector3f m_planeNormals[5];
+};
+
+inline RayMask RayPacket::getLanes() const
+{
+	return m_lanes;
+}
+
+inline Hit& RayPacket::getHit(int i) const
+{
+	return *m_hits[i];
+}
+
+inline bool RayPacket::hasDifferentials(int i) const
+{
+	return ((m_differentialLanes >> i) & 1) != 0;
+}
+
+inline const float* RayPacket::getDifferentials(int i) const
+{
+	return m_differentials[i];
+}
+
+inline Vector3f RayPacket::getOrigin(int i) const
+{
+	return Vector3f(m_origins[0][i], m_origins[1][i], m_origins[2][i]);
+}
+
+inline Vector3f RayPacket::getUnitDirection(int i) const
+{
+	return Vector3f(m_unitDirections[0][i], m_unitDirections[1][i], m_unitDirections[2][i]);
+}
+
+inline float RayPacket::getInvDirection(int i, int axis) const
+{
+	return m_invDirections[axis][i];
+}
+
+inline float RayPacket::getTMin(int i) const
+{
+	return m_tmin[i];
+}
+
+inline float RayPacket::getTMax(int i) const
+{
+	return m_tmax[i];
+}
+
+inline void RayPacket::setTMax(int i, float tmax)
+{
+	m_tmax[i] = tmax;
+}
+
+inline RayPacket::Vectors RayPacket::getOrigins(int g) const
+{
+	int first = g * RAY_PACKET_WIDTH;
+	return Vectors(Floats::load(m_origins[0] + first), Floats::load(m_origins[1] + first), Floats::load(m_origins[2] + first));
+}
+
+inline RayPacket::Vectors RayPacket::getUnitDirections(int g) const
+{
+	int first = g * RAY_PACKET_WIDTH;
+	return Vectors(Floats::load(m_unitDirections[0] + first), Floats::load(m_unitDirections[1] + first), Floats::load(m_unitDirections[2] + first));
+}
+
+inline RayPacket::Floats RayPacket::getTMins(int g) const
+{
+	return Floats::load(m_tmin + g * RAY_PACKET_WIDTH);
+}
+
+inline RayPacket::Floats RayPacket::getTMaxes(int g) const
+{
+	return Floats::load(m_tmax + g * RAY_PACKET_WIDTH);
+}
+
+inline RayMask RayPacket::intersect(const BoundingBox& box, RayMask lanes) const
+{
+	RayMask hitLanes = 0;
+	for (int g = 0; g < RAY_PACKET_GROUPS; ++g)
+	{
+		unsigned int groupLanes = getGroupLanes(lanes, g);
+		if (groupLanes == 0) continue;
+
+		int first = g * RAY_PACKET_WIDTH;
+		Floats tmin = Floats::load(m_tmin + first);
+		Floats tmax = Floats::load(m_tmax + first);
+		for (int i = 0; i < 3; ++i)
+		{
+			Floats orig = Floats::load(m_origins[i] + first);
+			Floats invDir = Floats::load(m_invDirections[i] + first);
+			Floats t0 = (Floats(box.getMin()[i]) - orig) * invDir;
+			Floats t1 = (Floats(box.getMax()[i]) - orig) * invDir;
+			// min and max pick like the comparisons of BoundingBox::intersect, NaN included,
+			// so a lane enters the same boxes as its single ray
+			tmin = Floats::max(Floats::min(t1, t0), tmin);
+			tmax = Floats::min(Floats::max(t0, t1), tmax);
+		}
+		hitLanes |= (RayMask)((tmin <= tmax).getBits() & groupLanes) << first;
+	}
+	return hitLanes;
+}
+
+inline bool RayPacket::overlaps(const BoundingBox& box) const
+{
+	for (int k = 0; k < m_planeCount; ++k)
+	{
+		const Vector3f& n = m_planeNormals[k];
+		// corner of the box furthest along the normal
+		Vector3f corner(n[0] >= 0 ? box.getMax()[0] : box.getMin()[0],
+						n[1] >= 0 ? box.getMax()[1] : box.getMin()[1],
+						n[2] >= 0 ? box.getMax()[2] : box.getMin()[2]);
+		Vector3f q = corner - m_frustumOrigin;
+		float distance = n[0] * q[0] + n[1] * q[1] + n[2] * q[2];
+		float magnitude = std::fabs(n[0] * q[0]) + std::fabs(n[1] * q[1]) + std::fabs(n[2] * q[2]);
+		if (distance < -RAY_PACKET_FRUSTUM_EPSILON * magnitude)
+			return false;
+	}
+	return true;
+}
+
+inline bool RayPacket::hasFrustum() const
+{
+	return m_planeCount > 0;
+}
+
+inline unsigned int RayPacket::getGroupLanes(RayMask lanes, int g)
+{
+	return (unsigned int)(lanes >> (g * RAY_PACKET_WIDTH)) & ((1u << RAY_PACKET_WIDTH) - 1);
+}
+
+inline bool RayPacket::hasFewerLanes(RayMask lanes, int count)
+{
+	for (int i = 1; i < count && lanes != 0; ++i)
+	{
+		lanes &= lanes - 1;
+	}
+	return lanes == 0;
+}
+
+inline int RayPacket::getFirstLane(RayMask lanes)
+{
+	int i = 0;
+	while (((lanes >> i) & 1) == 0) ++i;
+	return i;
+}
+
+#endif // RAY_PACKET_H
@@ -0,0 +1,131 @@
+#pragma once
+#ifndef RENDERER_H
+#define RENDERER_H
+
+#include <atomic>
+#include <functional>
+#include <vector>
+#include "Vector3f.h"
+#include "Scene.h"
+#include "Image.h"
+#include "DisplayBuffer.h"
+#include "ThreadPool.h"
+#include "RayCounters.h"
+#include "RayPacket.h"
+
+// shadow rays start this far from the hit point, relative to its largest coordinate,
+// so they don't hit the surface they leave because of float rounding
+#define RENDERER_SHADOW_EPSILON 1e-4f
+// primary rays are traced in packets of RENDERER_PACKET_BLOCK_SIZE^2 pixels, at most RAY_PACKET_SIZE
+#define RENDERER_PACKET_BLOCK_SIZE 8
+
+///////////////////////////
+// Renderer Header
+///////////////////////////
+
+struct RenderTile
+{
+	int x0, y0; // first pixel
+	int x1, y1; // one past the last pixel
+};
+
+///@brief timings of the last render, trace and shade are summed over all threads
+struct RenderStats
+{
+	RenderStats() : wallSeconds(0), traceSeconds(0), shadeSeconds(0), primaryRays(0), nodeVisits(0), intersectionTests(0) {}
+	double wallSeconds;
+	double traceSeconds;	// camera rays generation and intersection
+	double shadeSeconds;	// lights and materials
+	long long primaryRays;
+	long long nodeVisits;			// only counted when built with RAYCASTER_COUNTERS
+	long long intersectionTests;	// only counted when built with RAYCASTER_COUNTERS
+};
+
+///@brief splits the image in tiles and renders them over a persistent thread pool.
+///Every pixel goes through renderPixel, so the output does not depend on
+///the tile size or the thread count.
+class Renderer
+{
+public:
+	// Constructors
+	///@param threadCount 0 uses the hardware concurrency, 1 renders on the calling thread
+	Renderer(int threadCount = 0, int tileSize = 32);
+	// Destructors
+	~Renderer();
+
+	int getThreadCount() const;
+	void setThreadCount(int threadCount);
+	int getTileSize() const;
+	void setTileSize(int tileSize);
+
+	typedef std::function<void(const RenderTile&)> TileCallback;
+
+	///@brief render the whole image, returns once every tile is done
+	///@param onTileDone called from the rendering threads as soon as a tile's pixels are written
+	///@return false if the render was cancelled, the image is then partially written.
+	///A cancel made before render starts still applies, see resetCancel
+	bool render(const Scene& scene, Image& image, const TileCallback& onTileDone = TileCallback());
+	///@brief 8-bit buffer converted tile by tile on the rendering threads, NULL to disable.
+	///It must have the size of the rendered images.
+	void setDisplayBuffer(DisplayBuffer* display);
+	DisplayBuffer* getDisplayBuffer() const;
+	///@brief make a running render skip its remaining tiles, safe to call from any thread
+	void cancel();
+	///@brief forget a previous cancel, called by whoever requests a render before handing it to its worker thread,
+	///so a cancel made while the worker starts isn't lost
+	void resetCancel();
+	///@brief fraction of the tiles of the current render already done, safe to call from any thread
+	float getProgress() const;
+	const RenderStats& getLastStats() const;
+
+	///@brief trace and shade one pixel
+	static Vector3f renderPixel(const Scene& scene, int x, int y, int width, int height);
+	static Ray generatePrimaryRay(const Scene& scene, int x, int y, int width, int height);
+	static Vector3f shade(const Scene& scene, const Ray& ray, const Hit& hit);
+	///@brief sum of the lights reaching the hit, lights blocked by an object are skipped
+	///when the scene has shadows enabled
+	///@param surfaceColor the material color at the hit, see Material::getSurfaceColor
+	static Vector3f shade(const Scene& scene, const Ray& ray, const Hit& hit, const Vector3f& surfaceColor);
+	///@brief Material::getSurfaceColor of each hit, texture lookups are filtered in one batch per texture
+	static void getSurfaceColors(const std::vector<Hit>& hits, std::vector<Vector3f>& colors);
+
+	///@brief when enabled, the primary rays of each block of RENDERER_PACKET_BLOCK_SIZE^2 pixels
+	///are traced as one RayPacket, otherwise one by one. Both find the same hits
+	static void setPacketsEnabled(bool enabled);
+	static bool arePacketsEnabled();
+
+	static std::vector<RenderTile> makeTiles(int width, int height, int tileSize);
+
+	///@brief true when the intersection path was built with RAYCASTER_COUNTERS
+	static bool hasCounters();
+	///@brief false color image of the node visits and intersection tests of each pixel of the last render,
+	///from blue (cheapest) to red (most expensive pixel)
+	///@return false if counters are compiled out
+	bool getHeatmap(Image& heatmap) const;
+	static Vector3f heatColor(float cost);
+
+private:
+	//Control class copy
+	Renderer(const Renderer& renderer);
+	Renderer& operator= (const Renderer& renderer);
+
+	void renderTile(const Scene& scene, Image& image, const RenderTile& tile, const TileCallback& onTileDone);
+
+	int m_threadCount;
+	int m_tileSize;
+	ThreadPool* m_pool;
+	RenderStats m_stats;
+	DisplayBuffer* m_display;
+	std::atomic<bool> m_isCancelled;
+	std::atomic<int> m_tilesDone;
+	std::atomic<int> m_tileCount;
+	std::atomic<long long> m_traceNanoseconds;
+	std::atomic<long long> m_shadeNanoseconds;
+	std::atomic<long long> m_nodeVisits;
+	std::atomic<long long> m_intersectionTests;
+	std::vector<int> m_pixelCosts; // node visits plus intersection tests, row major
+	int m_costWidth;
+	int m_costHeight;
+};
+
+#endif // RENDERER_H
@@ -1,11 +1,21 @@
 #pragma once
 #ifndef TEXTURE_HPP
 #define TEXTURE_HPP
-#include "bitmap_image.h"
+#include <cstddef>
+#include <vector>
+#include "Vector2f.h"
 #include "Vector3f.h"
 
-///@brief helper class that stores a texture and faciliates lookup
-///assume 4byte RGBA image data
+// texels are stored in square tiles of TEXTURE_TILE_SIZE^2 RGBA8 texels, 4x4 fills a 64 byte cache line
+#define TEXTURE_TILE_SIZE 4
+// levels of the mip pyramid of a texture of int dimensions
+#define TEXTURE_MAX_LEVELS 32
+
+///@brief helper class that stores a texture and faciliates lookup.
+///The bitmap is converted at load time to RGBA8 texels grouped in tiles,
+///so the 4 texels of a bilinear footprint mostly share one cache line.
+///A mip pyramid is built at load time: minified lookups read a level whose
+///texels are about one pixel apart instead of striding across the full image.
 ///////////////////////////
 // Texture Header
 //
@@ -14,14 +24,54 @@
 class Texture {
 public:
 	Texture();
-	bool valid();
-	void load(const char * filename);
-	void operator()(int x, int y, unsigned char * color);
+	bool valid() const;
+	///@return bytes held by the texels and their offset tables
+	size_t getMemorySize() const;
+	int getWidth() const;
+	int getHeight() const;
+	///@return number of mip levels, the last one is 1x1
+	int getLevelCount() const;
+	///@return false if the file can't be read as a 24 bit bitmap
+	bool load(const char * filename);
+	///@brief r g b bytes of texel (x, y), clamped to the edges
+	void operator()(int x, int y, unsigned char * color) const;
+	///@brief bilinear lookup
 	///@param x assumed to be between 0 and 1
-	Vector3f operator()(float x, float y);
+	Vector3f operator()(float x, float y) const;
+	///@brief trilinear lookup, lod is clamped to the pyramid
+	Vector3f operator()(float x, float y, float lod) const;
+	///@brief bilinear lookups of count coordinates in the full resolution level, 4 at a time with SSE2
+	void sample(const float * x, const float * y, int count, Vector3f * colors) const;
+	///@brief trilinear lookups, a lod of 0 or less reads the full resolution level only
+	void sample(const float * x, const float * y, const float * lod, int count, Vector3f * colors) const;
+	///@brief level of detail of a lookup whose neighbouring pixels are dx and dy away in texture coordinates
+	float getLevelOfDetail(const Vector2f& dx, const Vector2f& dy) const;
+
+	///@brief when disabled, trilinear lookups read the full resolution level like bilinear ones.
+	///Meant to compare renders, the pyramid is built either way
+	static void setMipmapsEnabled(bool enabled);
+	static bool areMipmapsEnabled();
 	~Texture();
 private:
-	bitmap_image * bimg;
+	//Control class copy
+	Texture(const Texture& texture);
+	Texture& operator= (const Texture& texture);
+
+	struct MipLevel {
+		int width, height;
+		// index of texel (x, y) of the level is rowOffsets[y] + columnOffsets[x]
+		std::vector<int> rowOffsets;
+		std::vector<int> columnOffsets;
+	};
+
+	///@brief append a level of w x h texels to the pyramid
+	void addLevel(int w, int h);
+	///@brief index of texel (x, y) of level in texels, which must be inside the level
+	int getTexelIndex(int level, int x, int y) const;
+	void sampleLevel(int level, const float * x, const float * y, int count, Vector3f * colors) const;
+
+	std::vector<unsigned int> texels; // r | g << 8 | b << 16 | a << 24, every level one after the other
+	std::vector<MipLevel> levels;
 	int width, height;
 };
 #endif
@@ -0,0 +1,86 @@
+#pragma once
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "Texture.h"
+
+#define TEXTURE_CACHE_DEFAULT_BUDGET ((size_t)512 << 20)
+
+///////////////////////////
+// TextureCache Header
+///////////////////////////
+
+///@brief counters of a TextureCache since its creation or the last resetStats
+struct TextureCacheStats
+{
+	TextureCacheStats() : hits(0), misses(0), evictions(0), residentBytes(0), residentCount(0), budget(0) {}
+	long long hits;
+	long long misses;		// loads from disk, including reloads of modified files
+	long long evictions;
+	size_t residentBytes;	// pixels of every texture the cache holds, used or not
+	int residentCount;
+	size_t budget;
+};
+
+///@brief textures shared by file name across the whole process.
+///A texture lives as long as a material references it; once unused it stays resident
+///for later requests until the resident bytes exceed the budget, then the least
+///recently requested unused textures are evicted first. Textures in use are never evicted,
+///so the budget can be exceeded while they are all referenced.
+///A file whose size or modification time changed is loaded again, materials holding
+///the previous version keep it until they release it.
+class TextureCache
+{
+public:
+	///@param budget bytes of pixels kept resident
+	TextureCache(size_t budget = TEXTURE_CACHE_DEFAULT_BUDGET);
+	~TextureCache();
+
+	///@return the texture of filename, loaded on first use, NULL if the file can't be loaded
+	std::shared_ptr<Texture> acquire(const std::string& filename);
+
+	void setBudget(size_t budget);
+	size_t getBudget() const;
+	///@brief evict unused textures until the resident bytes fit in the budget
+	void trim();
+	///@brief evict every unused texture
+	void releaseUnused();
+
+	TextureCacheStats getStats() const;
+	void resetStats();
+
+	///@brief cache used by Material::loadTexture and the scene assets
+	static TextureCache& getGlobal();
+
+private:
+	//Control class copy
+	TextureCache(const TextureCache& cache);
+	TextureCache& operator= (const TextureCache& cache);
+
+	struct Entry
+	{
+		std::shared_ptr<Texture> texture;
+		unsigned long long fileSize;
+		long long fileTime;
+		size_t bytes;
+		std::list<std::string>::iterator lruPosition;
+	};
+
+	///@brief evict unused entries from the least recently used until resident bytes <= budget, lock held
+	void evict(size_t budget);
+	void erase(std::map<std::string, Entry>::iterator it);
+
+	mutable std::mutex m_mutex;
+	std::map<std::string, Entry> m_entries;
+	std::list<std::string> m_lru;	// most recently requested first
+	size_t m_budget;
+	TextureCacheStats m_stats;
+};
+
+#endif // TEXTURE_CACHE_H
@@ -3,8 +3,13 @@
 #define RAYCASTER_H
 
 #include <QtWidgets/QMainWindow>
+#include <QtCore/QTimer>
+#include <QtWidgets/QGraphicsPixmapItem>
+#include <atomic>
+#include <thread>
 #include "ui_RayCaster.h"
 #include "Scene.h"
+#include "Renderer.h"
 
 ///////////////////////////
 // RayCastr UI Header
@@ -18,6 +23,7 @@ class RayCaster : public QMainWindow
 
 public:
     RayCaster(QWidget *parent = Q_NULLPTR);
+	~RayCaster();
 
 private slots:
 	// Camera
@@ -56,13 +62,30 @@ private slots:
 private:
     Ui::RayCasterClass m_ui;
 	Scene m_scene;
+	Renderer m_renderer;
 	bool m_isLoading;
 	QGraphicsScene* m_grScene;
+	// background render, the renderer converts finished tiles into m_renderDisplay
+	// and m_renderTimer pushes it to the view
+	QTimer* m_renderTimer;
+	std::thread m_renderThread;
+	std::thread m_saveThread;
+	std::atomic<bool> m_isRendering;
+	bool m_isRenderCancelled;
+	float m_displayedProgress;
+	Image* m_renderImage;
+	DisplayBuffer* m_renderDisplay;
+	QImage m_renderQImage; // finished tiles of m_renderDisplay, copied on the UI thread
+	QGraphicsPixmapItem* m_renderItem;
 
 	void updateCam();
 	void updateLight();
 	void updateObject();
 	void updateMaterial();
+	void updateRenderDisplay();
+	void finishRender();
+	void cancelRender();
+	void saveRender(Image* image);
 };
 
 #endif //RAYCASTER_H 
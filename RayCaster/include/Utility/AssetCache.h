@@ -0,0 +1,47 @@
+#pragma once
+#ifndef ASSET_CACHE_H
+#define ASSET_CACHE_H
+
+#include <map>
+#include <memory>
+#include <string>
+#include "MeshGeometry.h"
+#include "Texture.h"
+#include "TextureCache.h"
+
+///////////////////////////
+// AssetCache Header
+///////////////////////////
+
+///@brief meshes and textures of a scene, loaded once per file name.
+///Rebuilding an object or a material only takes new references to the loaded data.
+///Meshes come from the MeshGeometry registry, which reads a file again only when its size
+///or modification time changed, the cache keeps them alive while the scene is edited.
+///Textures come from the process-wide TextureCache, which also shares them between scenes.
+///Not thread safe: meant for scene loading and editing, not for render workers.
+class AssetCache
+{
+public:
+	AssetCache();
+	~AssetCache();
+
+	///@return NULL if the file can't be loaded, failures are not cached
+	std::shared_ptr<const MeshGeometry> getMesh(const std::string& filename);
+	///@return NULL if the file can't be loaded, failures are not cached
+	std::shared_ptr<Texture> getTexture(const std::string& filename);
+
+	///@brief forget the meshes no object references anymore and trim the texture cache
+	void releaseUnused();
+	void clear();
+
+	int getMeshCount() const;
+
+private:
+	//Control class copy
+	AssetCache(const AssetCache& cache);
+	AssetCache& operator= (const AssetCache& cache);
+
+	std::map<std::string, std::shared_ptr<const MeshGeometry> > m_meshes;
+};
+
+#endif // ASSET_CACHE_H
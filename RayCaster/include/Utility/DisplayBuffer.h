@@ -0,0 +1,62 @@
+#pragma once
+#ifndef DISPLAY_BUFFER_H
+#define DISPLAY_BUFFER_H
+
+#include <mutex>
+#include <vector>
+#include "Image.h"
+
+///////////////////////////
+// DisplayBuffer Header
+///////////////////////////
+
+///@brief 8-bit copy of an Image laid out for display: 32-bit 0xAARRGGBB pixels
+///(B, G, R, A bytes on little endian), rows top down and 4-byte aligned.
+///This is the memory layout of QImage::Format_RGB32, so rows copy straight into a QImage.
+///While other threads convert into it, read it with CopyDirty only:
+///it copies the regions whose conversion is finished and never the ones being written.
+class DisplayBuffer
+{
+public:
+	DisplayBuffer(int w, int h);
+	~DisplayBuffer();
+
+	int Width() const;
+	int Height() const;
+	int BytesPerLine() const;
+	unsigned char* Data();
+	const unsigned char* Data() const;
+
+	///@brief fill every pixel with an opaque color
+	void Clear(unsigned char r, unsigned char g, unsigned char b);
+	///@brief convert the pixels [x0, x1) x [y0, y1) of image, which must have the same size.
+	///Channels are clamped like the image file writers do.
+	///Distinct regions can be converted from several threads at once.
+	void Convert(const Image& image, int x0, int y0, int x1, int y1);
+	void Convert(const Image& image);
+	///@brief copy the pixels cleared or converted since the last call into dst,
+	///an image of the same size and layout, and forget them
+	///@return false if nothing changed
+	bool CopyDirty(unsigned char* dst, int dstBytesPerLine);
+
+private:
+	//Control class copy
+	DisplayBuffer(const DisplayBuffer& buffer);
+	DisplayBuffer& operator= (const DisplayBuffer& buffer);
+
+	///@brief rows [y0, y1) of the buffer, top down, and columns [x0, x1)
+	struct Region
+	{
+		int x0, y0, x1, y1;
+	};
+
+	void markDirty(int x0, int y0, int x1, int y1);
+
+	int m_width;
+	int m_height;
+	unsigned int* m_data;
+	std::mutex m_dirtyMutex;
+	std::vector<Region> m_dirty;
+};
+
+#endif // DISPLAY_BUFFER_H
@@ -0,0 +1,53 @@
+#pragma once
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+
+///////////////////////////
+// MappedFile Header
+///////////////////////////
+
+///@brief how the mapped pages are going to be read, a hint for the read-ahead of the system
+enum MappedFileAccess
+{
+	MAPPED_FILE_NORMAL,		// default read-ahead
+	MAPPED_FILE_SEQUENTIAL,	// front to back once: aggressive read-ahead, pages dropped after use
+	MAPPED_FILE_RANDOM		// scattered reads: no read-ahead
+};
+
+///@brief read-only memory mapping of a whole file, unmapped on destruction
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	///@return false if the file can't be opened or mapped, empty files map to NULL data
+	bool open(const char* filename, MappedFileAccess access = MAPPED_FILE_SEQUENTIAL);
+	void close();
+
+	bool isOpen() const;
+	const char* getData() const;
+	size_t getSize() const;
+
+	///@brief size and last modification time of a file, without opening it
+	///@param modificationTime in nanoseconds where the platform provides them
+	///@return false if the file doesn't exist
+	static bool getFileStatus(const char* filename, unsigned long long& size, long long& modificationTime);
+
+private:
+	//Control class copy
+	MappedFile(const MappedFile& file);
+	MappedFile& operator= (const MappedFile& file);
+
+	const char* m_data;
+	size_t m_size;
+	bool m_isOpen;
+#ifdef _WIN32
+	void* m_file;
+	void* m_mapping;
+#endif
+};
+
+#endif // MAPPED_FILE_H
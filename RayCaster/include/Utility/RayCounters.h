@@ -0,0 +1,38 @@
+#pragma once
+#ifndef RAY_COUNTERS_H
+#define RAY_COUNTERS_H
+
+///////////////////////////
+// RayCounters Header
+///////////////////////////
+
+// Define RAYCASTER_COUNTERS to count node visits and intersection tests
+// along the intersection path. Without it every counting macro is empty.
+
+///@brief per thread counters, the renderer resets them before each pixel
+struct RayCounters
+{
+	RayCounters() : nodeVisits(0), intersectionTests(0) {}
+	long long nodeVisits;			// acceleration structure nodes and instance transforms
+	long long intersectionTests;	// objects and triangles tested against a ray
+
+	void reset() { nodeVisits = 0; intersectionTests = 0; }
+	long long getTotal() const { return nodeVisits + intersectionTests; }
+
+	///@brief counters of the calling thread
+	static RayCounters& local()
+	{
+		static thread_local RayCounters counters;
+		return counters;
+	}
+};
+
+#ifdef RAYCASTER_COUNTERS
+#define RAY_COUNT_NODES(n) (RayCounters::local().nodeVisits += (n))
+#define RAY_COUNT_TESTS(n) (RayCounters::local().intersectionTests += (n))
+#else
+#define RAY_COUNT_NODES(n) ((void)0)
+#define RAY_COUNT_TESTS(n) ((void)0)
+#endif
+
+#endif // RAY_COUNTERS_H
@@ -3,11 +3,14 @@
 #define SCENE_H
 
 #include <cassert>
+#include <cstdio>
+#include <fstream>
 #include "Vector2f.h"
 #include "Vector3f.h"
 
 #include "Camera.h"
 #include "Light.h"
+#include "LightBVH.h"
 #include "Material.h"
 #include "Object3D.h"
 #include "Mesh.h"
@@ -16,9 +19,12 @@
 #include "Plane.h"
 #include "Triangle.h"
 #include "Transform.h"
+#include "AssetCache.h"
 #include <vector>
 
 #define MAX_PARSER_TOKEN_LENGTH 100
+// scanf format reading one token, leaving room for the terminating null
+#define MAX_PARSER_TOKEN_FORMAT "%99s "
 
 
 ///////////////////////////
@@ -42,9 +48,14 @@ public:
 
 	Vector3f getAmbientLight() const;
 	void setAmbientLight(const Vector3f & color);
+	///@brief cast shadow rays towards the lights, enabled by default
+	void setShadowsEnabled(bool enabled);
+	bool areShadowsEnabled() const;
 
 	int getNumLights() const;
 	Light* getLight(int i) const;
+	///@brief the light BVH is updated on the next render after addLight, modifyLight and removeLight,
+	///a light moved or resized in place needs getLightBVH()->invalidate()
 	void addLight(Light * newLight);
 	void modifyLight(int i, Light * light);
 	void removeLight(int i);
@@ -54,6 +65,10 @@ public:
 	void modifyMaterial(int i, Material * material);
 	void removeMaterial(int i);
 	Group* getGroup() const;
+	///@brief lights that can reach a point, see LightBVH
+	LightBVH* getLightBVH() const;
+	///@brief meshes and textures loaded for this scene, reuse them when rebuilding objects and materials
+	AssetCache& getAssets();
 
 	bool loadScene(const char* filename);
 
@@ -94,10 +109,13 @@ private:
 	Camera* m_camera;
 	Vector3f m_background_color;
 	Vector3f m_ambientLight;
+	bool m_shadowsEnabled;
 	std::vector<Light*> m_lights;
+	LightBVH* m_lightBVH; // indexes m_lights
 	std::vector<Material*> m_materials;
 	Material* m_currentMaterial;
 	Group* m_group;
+	AssetCache m_assets;
 };
 
 #endif // SCENE_H
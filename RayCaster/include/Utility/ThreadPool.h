@@ -0,0 +1,68 @@
+#pragma once
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+///////////////////////////
+// ThreadPool Header
+///////////////////////////
+
+///@brief persistent pool of worker threads, each one owning a task deque.
+///Workers pop their own tasks from the back and steal from the front of the others.
+///A thread waiting on parallelFor keeps running tasks, so calls can be nested.
+class ThreadPool
+{
+public:
+	///@param threadCount number of workers, 0 uses the hardware concurrency
+	ThreadPool(int threadCount = 0);
+	~ThreadPool();
+
+	int getThreadCount() const;
+
+	///@brief run body(i) for every i in [0, count) and return once all of them are done
+	void parallelFor(int count, const std::function<void(int)>& body);
+
+	///@brief process-wide pool sized on the hardware concurrency
+	static ThreadPool& getGlobal();
+
+private:
+	struct Task
+	{
+		const std::function<void(int)>* body;
+		int index;
+		std::atomic<int>* pending;
+	};
+
+	struct TaskQueue
+	{
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	//Control class copy
+	ThreadPool(const ThreadPool& pool);
+	ThreadPool& operator= (const ThreadPool& pool);
+
+	void workerLoop(int queueIndex);
+	bool popTask(int queueIndex, Task& task);
+	bool stealTask(int queueIndex, Task& task);
+	void runTask(Task& task);
+
+	std::vector<std::thread> m_threads;
+	std::vector<TaskQueue*> m_queues; // one per worker, the last one is shared by outside threads
+	std::atomic<int> m_queuedTasks;
+	// idle workers and parallelFor callers with nothing left to run sleep here,
+	// woken when tasks are queued or the last task of a call finishes
+	std::mutex m_sleepMutex;
+	std::condition_variable m_wakeUp;
+	bool m_isStopping;
+};
+
+#endif // THREAD_POOL_H
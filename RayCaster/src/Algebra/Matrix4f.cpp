@@ -22,37 +22,6 @@
 ///////////////
 #pragma region Constructors
 
-Matrix4f::Matrix4f(float fill)
-{
-	for (int i = 0; i < 16; ++i)
-	{
-		m_elements[i] = fill;
-	}
-}
-
-Matrix4f::Matrix4f(float m00, float m01, float m02, float m03, float m10, float m11, float m12, float m13, float m20, float m21, float m22, float m23, float m30, float m31, float m32, float m33)
-{
-	m_elements[0] = m00;
-	m_elements[1] = m01;
-	m_elements[2] = m02;
-	m_elements[3] = m03;
-
-	m_elements[4] = m10;
-	m_elements[5] = m11;
-	m_elements[6] = m12;
-	m_elements[7] = m13;
-
-	m_elements[8] = m20;
-	m_elements[9] = m21;
-	m_elements[10] = m22;
-	m_elements[11] = m23;
-
-	m_elements[12] = m30;
-	m_elements[13] = m31;
-	m_elements[14] = m32;
-	m_elements[15] = m33;
-}
-
 Matrix4f::Matrix4f(const Vector4f& v0, const Vector4f& v1, const Vector4f& v2, const Vector4f& v3, bool setColumns)
 {
 	if (setColumns)
@@ -71,35 +40,12 @@ Matrix4f::Matrix4f(const Vector4f& v0, const Vector4f& v1, const Vector4f& v2, c
 	}
 }
 
-Matrix4f::Matrix4f(const Matrix4f& m)
-{
-	memcpy(m_elements, m.m_elements, 16 * sizeof(float));
-}
-
-Matrix4f& Matrix4f::operator = (const Matrix4f& m)
-{
-	if (this != &m)
-	{
-		memcpy(m_elements, m.m_elements, 16 * sizeof(float));
-	}
-	return *this;
-}
 #pragma endregion
 //////////
 // Utility
 //////////
 #pragma region Utility
 
-const float& Matrix4f::operator () (int i, int j) const
-{
-	return m_elements[i * 4 + j];
-}
-
-float& Matrix4f::operator () (int i, int j)
-{
-	return m_elements[i * 4 + j];
-}
-
 Vector4f Matrix4f::getRow(int i) const
 {
 	return Vector4f(m_elements[i * 4], m_elements[i * 4 + 1], m_elements[i * 4 + 2], m_elements[i * 4 + 3]);
@@ -178,11 +124,6 @@ void Matrix4f::setSubMatrix3x3(int i0, int j0, Matrix3f m)
 	}
 }
 
-Matrix4f::operator float* ()
-{
-	return m_elements;
-}
-
 void Matrix4f::print()
 {
 	printf("[ %.4f %.4f %.4f %.4f ]\n[ %.4f %.4f %.4f %.4f ]\n[ %.4f %.4f %.4f %.4f ]\n[ %.4f %.4f %.4f %.4f ]\n",
@@ -642,38 +583,5 @@ Matrix4f operator * (float f, const Matrix4f& m)
 	return out;
 }
 
-// Matrix-Vector multiplication
-Vector4f operator * (const Matrix4f& m, const Vector4f& v)
-{
-	Vector4f output(0, 0, 0, 0);
-
-	for (int i = 0; i < 4; ++i)
-	{
-		for (int j = 0; j < 4; ++j)
-		{
-			output[i] += m(i, j) * v[j];
-		}
-	}
-
-	return output;
-}
-
-// Matrix-Matrix multiplication
-Matrix4f operator * (const Matrix4f& m1, const Matrix4f& m2)
-{
-	Matrix4f product; // zeroes
-
-	for (int i = 0; i < 4; ++i)
-	{
-		for (int j = 0; j < 4; ++j)
-		{
-			for (int k = 0; k < 4; ++k)
-			{
-				product(i, k) += m1(i, j) * m2(j, k);
-			}
-		}
-	}
-
-	return product;
-}
+// Matrix-Vector and Matrix-Matrix multiplications are inline in Matrix4f.h
 #pragma endregion
\ No newline at end of file
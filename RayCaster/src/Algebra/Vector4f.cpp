@@ -16,22 +16,6 @@
 ///////////////
 #pragma region Constructors
 
-Vector4f::Vector4f(float f)
-{
-	m_elements[0] = f;
-	m_elements[1] = f;
-	m_elements[2] = f;
-	m_elements[3] = f;
-}
-
-Vector4f::Vector4f(float x, float y, float z, float w)
-{
-	m_elements[0] = x;
-	m_elements[1] = y;
-	m_elements[2] = z;
-	m_elements[3] = w;
-}
-
 Vector4f::Vector4f(float buffer[4])
 {
 	m_elements[0] = buffer[0];
@@ -64,14 +48,6 @@ Vector4f::Vector4f(float x, float y, const Vector2f & zw)
 	m_elements[3] = zw.y();
 }
 
-Vector4f::Vector4f(const Vector3f & xyz, float w)
-{
-	m_elements[0] = xyz.x();
-	m_elements[1] = xyz.y();
-	m_elements[2] = xyz.z();
-	m_elements[3] = w;
-}
-
 Vector4f::Vector4f(float x, const Vector3f & yzw)
 {
 	m_elements[0] = x;
@@ -79,62 +55,12 @@ Vector4f::Vector4f(float x, const Vector3f & yzw)
 	m_elements[2] = yzw.y();
 	m_elements[3] = yzw.z();
 }
-
-Vector4f::Vector4f(const Vector4f & vec)
-{
-	m_elements[0] = vec.x();
-	m_elements[1] = vec.y();
-	m_elements[2] = vec.z();
-	m_elements[3] = vec.w();
-}
-
-Vector4f & Vector4f::operator = (const Vector4f & vec)
-{
-	if (this != &vec)
-	{
-		m_elements[0] = vec.x();
-		m_elements[1] = vec.y();
-		m_elements[2] = vec.z();
-		m_elements[3] = vec.w();
-	}
-	return *this;
-}
 #pragma endregion
 //////////
 // Utility
 //////////
 #pragma region Utility
 
-const float& Vector4f::operator [] (int i) const
-{
-	return m_elements[i];
-}
-
-float& Vector4f::operator [] (int i)
-{
-	return m_elements[i];
-}
-
-float Vector4f::x() const
-{
-	return m_elements[0];
-}
-
-float Vector4f::y() const
-{
-	return m_elements[1];
-}
-
-float Vector4f::z() const
-{
-	return m_elements[2];
-}
-
-float Vector4f::w() const
-{
-	return m_elements[3];
-}
-
 Vector2f Vector4f::xy() const
 {
 	return Vector2f(m_elements[0], m_elements[1]);
@@ -152,11 +78,6 @@ Vector2f Vector4f::wx() const
 	return Vector2f(m_elements[0], m_elements[1]);
 }
 
-Vector3f Vector4f::xyz() const
-{
-	return Vector3f(m_elements[0], m_elements[1], m_elements[2]);
-}
-
 Vector3f Vector4f::yzw() const
 {
 	return Vector3f(m_elements[1], m_elements[2], m_elements[3]);
@@ -172,16 +93,6 @@ Vector3f Vector4f::wxy() const
 	return Vector3f(m_elements[3], m_elements[0], m_elements[1]);
 }
 
-Vector4f::operator const float* () const
-{
-	return m_elements;
-}
-
-Vector4f::operator float* ()
-{
-	return m_elements;
-}
-
 void Vector4f::print() const
 {
 	printf("< %.4f, %.4f , %.4f, %.4f >\n", m_elements[0], m_elements[1], m_elements[2], m_elements[3]);
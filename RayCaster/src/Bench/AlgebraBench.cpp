@@ -0,0 +1,219 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include "Vector3f.h"
+#include "Vector4f.h"
+#include "Matrix4f.h"
+#include "VectorPacket.h"
+
+/////////////////////////////////////////////
+// Vector and matrix math benchmark
+//
+// Runs dot, cross, normalize, matrix-vector and
+// matrix-matrix products over arrays of operands
+// with the inline header implementations and with
+// the former out of line ones, and prints one CSV
+// line per run with the nanoseconds per operation.
+// dot, cross and normalize also run on 4 and 8
+// wide Vector3fPacket, loaded from and stored to
+// the same arrays of Vector3f.
+// The former path is reproduced by calling a copy
+// of the old scalar code through a function
+// pointer, like a call into Vector3f.cpp that the
+// compiler could not inline. It still inlines the
+// accessors and constructors the old code called
+// out of line too, so it is on the fast side.
+// mismatches counts results that differ in any bit
+// from the inline path.
+//
+// AlgebraBench [-count n] [-repeat n]
+/////////////////////////////////////////////
+
+typedef std::chrono::high_resolution_clock Clock;
+
+// reference: the scalar code of Vector3f.cpp and Matrix4f.cpp before it moved inline
+static float dotLegacy(const Vector3f& v0, const Vector3f& v1)
+{
+	return v0[0] * v1[0] + v0[1] * v1[1] + v0[2] * v1[2];
+}
+
+static Vector3f crossLegacy(const Vector3f& v0, const Vector3f& v1)
+{
+	return Vector3f(v0.y() * v1.z() - v0.z() * v1.y(),
+					v0.z() * v1.x() - v0.x() * v1.z(),
+					v0.x() * v1.y() - v0.y() * v1.x());
+}
+
+static Vector3f normalizedLegacy(const Vector3f& v)
+{
+	float norm = sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+	return Vector3f(v[0] / norm, v[1] / norm, v[2] / norm);
+}
+
+static Vector4f transformLegacy(const Matrix4f& m, const Vector4f& v)
+{
+	Vector4f output(0, 0, 0, 0);
+	for (int i = 0; i < 4; ++i)
+	{
+		for (int j = 0; j < 4; ++j)
+		{
+			output[i] += m(i, j) * v[j];
+		}
+	}
+	return output;
+}
+
+static Matrix4f multiplyLegacy(const Matrix4f& m1, const Matrix4f& m2)
+{
+	Matrix4f product;
+	for (int i = 0; i < 4; ++i)
+	{
+		for (int j = 0; j < 4; ++j)
+		{
+			for (int k = 0; k < 4; ++k)
+			{
+				product(i, k) += m1(i, j) * m2(j, k);
+			}
+		}
+	}
+	return product;
+}
+
+// volatile: the compiler can't see through them, like calls into another translation unit
+static float (*volatile dotCall)(const Vector3f&, const Vector3f&) = dotLegacy;
+static Vector3f (*volatile crossCall)(const Vector3f&, const Vector3f&) = crossLegacy;
+static Vector3f (*volatile normalizedCall)(const Vector3f&) = normalizedLegacy;
+static Vector4f (*volatile transformCall)(const Matrix4f&, const Vector4f&) = transformLegacy;
+static Matrix4f (*volatile multiplyCall)(const Matrix4f&, const Matrix4f&) = multiplyLegacy;
+
+static float randomFloat()
+{
+	return 2.f * rand() / (float)RAND_MAX - 1.f;
+}
+
+static bool sameBits(const float* a, const float* b, int count)
+{
+	return memcmp(a, b, count * sizeof(float)) == 0;
+}
+
+int main(int argc, char* argv[])
+{
+	int count = 1 << 14;
+	int repeat = 200;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (!strcmp(argv[i], "-count")) count = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "-repeat")) repeat = atoi(argv[i + 1]);
+	}
+
+	srand(1);
+	std::vector<Vector3f> a(count), b(count);
+	std::vector<Vector4f> p(count);
+	std::vector<Matrix4f> m(count);
+	for (int i = 0; i < count; ++i)
+	{
+		a[i] = Vector3f(randomFloat(), randomFloat(), randomFloat());
+		b[i] = Vector3f(randomFloat(), randomFloat(), randomFloat());
+		p[i] = Vector4f(a[i], 1.f);
+		for (int k = 0; k < 16; ++k)
+		{
+			m[i](k / 4, k % 4) = randomFloat();
+		}
+	}
+
+	// results of each path, compared bit for bit
+	count -= count % 8;
+	std::vector<float> dots[4];
+	std::vector<Vector3f> vectors[4];
+	std::vector<Vector4f> points[2];
+	std::vector<Matrix4f> matrices[2];
+	for (int path = 0; path < 4; ++path)
+	{
+		dots[path].resize(count);
+		vectors[path].resize(count);
+	}
+	for (int path = 0; path < 2; ++path)
+	{
+		points[path].resize(count);
+		matrices[path].resize(count);
+	}
+
+	printf("operation,path,ns_per_op,mismatches\n");
+	const char* operations[] = { "dot", "cross", "normalize", "mat_vec", "mat_mat" };
+	const char* paths[] = { "out_of_line", "inline", "packet4", "packet8" };
+	for (int op = 0; op < 5; ++op)
+	{
+		// no matrix packets
+		int pathCount = (op < 3) ? 4 : 2;
+		double ns[4];
+		for (int path = 0; path < pathCount; ++path)
+		{
+			// best of 3 runs
+			for (int run = 0; run < 3; ++run)
+			{
+				Clock::time_point start = Clock::now();
+				for (int r = 0; r < repeat; ++r)
+				{
+					if (op == 0)
+					{
+						float* out = &dots[path][0];
+						if (path == 0) for (int i = 0; i < count; ++i) out[i] = dotCall(a[i], b[i]);
+						else if (path == 1) for (int i = 0; i < count; ++i) out[i] = Vector3f::dot(a[i], b[i]);
+						else if (path == 2) for (int i = 0; i < count; i += 4) Vector3f4::dot(Vector3f4::load(&a[i]), Vector3f4::load(&b[i])).store(out + i);
+						else for (int i = 0; i < count; i += 8) Vector3f8::dot(Vector3f8::load(&a[i]), Vector3f8::load(&b[i])).store(out + i);
+					}
+					else if (op == 1)
+					{
+						Vector3f* out = &vectors[path][0];
+						if (path == 0) for (int i = 0; i < count; ++i) out[i] = crossCall(a[i], b[i]);
+						else if (path == 1) for (int i = 0; i < count; ++i) out[i] = Vector3f::cross(a[i], b[i]);
+						else if (path == 2) for (int i = 0; i < count; i += 4) Vector3f4::cross(Vector3f4::load(&a[i]), Vector3f4::load(&b[i])).store(out + i);
+						else for (int i = 0; i < count; i += 8) Vector3f8::cross(Vector3f8::load(&a[i]), Vector3f8::load(&b[i])).store(out + i);
+					}
+					else if (op == 2)
+					{
+						Vector3f* out = &vectors[path][0];
+						if (path == 0) for (int i = 0; i < count; ++i) out[i] = normalizedCall(a[i]);
+						else if (path == 1) for (int i = 0; i < count; ++i) out[i] = a[i].normalized();
+						else if (path == 2) for (int i = 0; i < count; i += 4) Vector3f4::load(&a[i]).normalized().store(out + i);
+						else for (int i = 0; i < count; i += 8) Vector3f8::load(&a[i]).normalized().store(out + i);
+					}
+					else if (op == 3)
+					{
+						Vector4f* out = &points[path][0];
+						if (path == 0) for (int i = 0; i < count; ++i) out[i] = transformCall(m[i], p[i]);
+						else for (int i = 0; i < count; ++i) out[i] = m[i] * p[i];
+					}
+					else
+					{
+						Matrix4f* out = &matrices[path][0];
+						if (path == 0) for (int i = 0; i < count; ++i) out[i] = multiplyCall(m[i], m[count - 1 - i]);
+						else for (int i = 0; i < count; ++i) out[i] = m[i] * m[count - 1 - i];
+					}
+				}
+				double runNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / ((double)count * repeat);
+				ns[path] = (run == 0 || runNs < ns[path]) ? runNs : ns[path];
+			}
+		}
+
+		for (int path = 0; path < pathCount; ++path)
+		{
+			int mismatches = 0;
+			for (int i = 0; i < count && path != 1; ++i)
+			{
+				if (op == 0) mismatches += !sameBits(&dots[path][i], &dots[1][i], 1);
+				else if (op == 1 || op == 2) mismatches += !sameBits(vectors[path][i], vectors[1][i], 3);
+				else if (op == 3) mismatches += !sameBits(points[path][i], points[1][i], 4);
+				else mismatches += !sameBits(matrices[path][i], matrices[1][i], 16);
+			}
+			printf("%s,%s,%.3f,%d\n", operations[op], paths[path], ns[path], mismatches);
+		}
+		fflush(stdout);
+	}
+	return 0;
+}
@@ -0,0 +1,167 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cfloat>
+#include <chrono>
+#include <vector>
+
+#include "Camera.h"
+#include "Group.h"
+#include "Sphere.h"
+#include "Mesh.h"
+#include "WideBVH.h"
+#include "Material.h"
+
+/////////////////////////////////////
+// BVH benchmark
+//
+// Renders primary rays over growing
+// random sphere fields, with the binary
+// BVH, its wide version and a brute-force
+// object loop, then over each mesh given
+// on the command line with the binary and
+// wide triangle BVH and the brute-force
+// triangle loop. Node visits of the wide
+// BVH test WIDE_BVH_WIDTH children each.
+/////////////////////////////////////
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static float randomFloat()
+{
+	return rand() / (float)RAND_MAX;
+}
+
+// trace every pixel, returns the number of rays that hit something
+static int traceImage(Camera& camera, Group& group, int size, bool useBVH)
+{
+	int hitCount = 0;
+	for (int x = 0; x < size; ++x)
+	{
+		for (int y = 0; y < size; ++y)
+		{
+			Hit hit;
+			Ray ray = camera.generateRay(Vector2f(2.f * x / (size - 1) - 1, 2.f * y / (size - 1) - 1));
+			if (useBVH)
+			{
+				group.intersect(ray, hit, camera.getTMin());
+			}
+			else
+			{
+				for (int i = 0; i < group.getGroupSize(); ++i)
+				{
+					group.getObject(i)->intersect(ray, hit, camera.getTMin());
+				}
+			}
+			if (hit.getT() < FLT_MAX) hitCount++;
+		}
+	}
+	return hitCount;
+}
+
+// frame the mesh bounds and trace every pixel through the mesh only
+static void benchMesh(const char* filename, int size)
+{
+	Material material(Vector3f(1.f));
+	Clock::time_point t0 = Clock::now();
+	Mesh mesh(filename, &material);
+	Clock::time_point t1 = Clock::now();
+
+	BoundingBox box;
+	mesh.getBoundingBox(box);
+	Vector3f center = box.getCenter();
+	float radius = box.getExtent().abs() / 2;
+	PerspectiveCamera camera(center + Vector3f(0, 0, 2.5f * radius), Vector3f(0, 0, -1), Vector3f(0, 1, 0), 1.f);
+
+	BVHStats bvhStats, wideStats, bruteStats;
+	int mismatches = 0;
+	double bvhMs = 0, wideMs = 0, bruteMs = 0;
+	for (int x = 0; x < size; ++x)
+	{
+		for (int y = 0; y < size; ++y)
+		{
+			Ray ray = camera.generateRay(Vector2f(2.f * x / (size - 1) - 1, 2.f * y / (size - 1) - 1));
+			Hit bvhHit, wideHit, bruteHit;
+			Clock::time_point r0 = Clock::now();
+			WideBVH::setEnabled(false);
+			mesh.intersect(ray, bvhHit, camera.getTMin(), &bvhStats);
+			Clock::time_point r1 = Clock::now();
+			WideBVH::setEnabled(true);
+			mesh.intersect(ray, wideHit, camera.getTMin(), &wideStats);
+			Clock::time_point r2 = Clock::now();
+			mesh.intersectBruteForce(ray, bruteHit, camera.getTMin(), &bruteStats);
+			Clock::time_point r3 = Clock::now();
+			bvhMs += std::chrono::duration<double, std::milli>(r1 - r0).count();
+			wideMs += std::chrono::duration<double, std::milli>(r2 - r1).count();
+			bruteMs += std::chrono::duration<double, std::milli>(r3 - r2).count();
+			if (bvhHit.getT() != bruteHit.getT() || wideHit.getT() != bruteHit.getT()) mismatches++;
+		}
+	}
+	double rays = (double)size * size;
+	printf("%s,%d,%.3f,%.3f,%.2f,%.2f,%.3f,%.2f,%.2f,%.3f,%.2f,%d\n", filename, mesh.getGeometry() ? mesh.getGeometry()->getTriangleCount() : 0,
+		std::chrono::duration<double, std::milli>(t1 - t0).count(),
+		bvhMs, bvhStats.nodeVisits / rays, bvhStats.primitiveTests / rays,
+		wideMs, wideStats.nodeVisits / rays, wideStats.primitiveTests / rays,
+		bruteMs, bruteStats.primitiveTests / rays, mismatches);
+}
+
+int main(int argc, char* argv[])
+{
+	int size = (argc > 1) ? atoi(argv[1]) : 128;
+	int maxBruteForce = (argc > 2) ? atoi(argv[2]) : 4096;
+	Material material(Vector3f(1.f));
+	PerspectiveCamera camera(Vector3f(0, 0, 12), Vector3f(0, 0, -1), Vector3f(0, 1, 0), 1.f);
+
+	printf("objects,build_ms,bvh_ms,bvh_ns_per_ray,wide_ms,wide_ns_per_ray,brute_ms,brute_ns_per_ray,hits,wide_hits\n");
+	for (int numObjects = 16; numObjects <= 262144; numObjects *= 4)
+	{
+		srand(1);
+		Group group;
+		// constant density: the field grows with the object count, spheres shrink
+		float radius = 4.f / sqrtf((float)numObjects);
+		for (int i = 0; i < numObjects; ++i)
+		{
+			Vector3f center(8 * randomFloat() - 4, 8 * randomFloat() - 4, 8 * randomFloat() - 4);
+			group.addObject(new Sphere(center, radius, &material));
+		}
+
+		Clock::time_point t0 = Clock::now();
+		group.buildBVH();
+		Clock::time_point t1 = Clock::now();
+		WideBVH::setEnabled(false);
+		int hits = traceImage(camera, group, size, true);
+		Clock::time_point t2 = Clock::now();
+		WideBVH::setEnabled(true);
+		int wideHits = traceImage(camera, group, size, true);
+		Clock::time_point t5 = Clock::now();
+
+		double buildMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+		double bvhMs = std::chrono::duration<double, std::milli>(t2 - t1).count();
+		double wideMs = std::chrono::duration<double, std::milli>(t5 - t2).count();
+		double rays = (double)size * size;
+		printf("%d,%.3f,%.3f,%.1f,%.3f,%.1f,", numObjects, buildMs, bvhMs, bvhMs * 1e6 / rays, wideMs, wideMs * 1e6 / rays);
+
+		if (numObjects <= maxBruteForce)
+		{
+			Clock::time_point t3 = Clock::now();
+			int bruteHits = traceImage(camera, group, size, false);
+			Clock::time_point t4 = Clock::now();
+			double bruteMs = std::chrono::duration<double, std::milli>(t4 - t3).count();
+			printf("%.3f,%.1f,%d,%d%s\n", bruteMs, bruteMs * 1e6 / rays, hits, wideHits, (bruteHits != hits || bruteHits != wideHits) ? " MISMATCH" : "");
+		}
+		else
+		{
+			// the looser boxes of the wide BVH can catch a grazing hit whose exact box the binary one misses
+			printf(",,%d,%d\n", hits, wideHits);
+		}
+	}
+
+	if (argc > 3)
+	{
+		printf("\nmesh,triangles,load_ms,bvh_ms,nodes_per_ray,tests_per_ray,wide_ms,wide_nodes_per_ray,wide_tests_per_ray,brute_ms,brute_tests_per_ray,mismatches\n");
+		for (int i = 3; i < argc; ++i)
+		{
+			benchMesh(argv[i], size);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,155 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "BVH.h"
+#include "ObjLoader.h"
+#include "ThreadPool.h"
+
+/////////////////////////////////////////////
+// BVH build benchmark
+//
+// Builds the triangle BVH of the bundled
+// meshes and of a synthetic bumpy grid
+// (5M triangles by default, kept in memory)
+// for every bin count and leaf size, on one
+// thread and on a thread pool, and prints
+// one CSV line per build with its duration,
+// its SAH cost (lower traces faster) and
+// node count. same_as_serial checks that
+// the pool built the very hierarchy of the
+// single thread build.
+//
+// BVHBuildBench [-mesh dir] [-triangles n]
+//     [-repeat n] [-threads n]
+//
+// -threads sizes the pool, 0 (default)
+// uses the hardware concurrency.
+/////////////////////////////////////////////
+
+static std::vector<BoundingBox> getTriangleBounds(const std::vector<Vector3f>& v, const std::vector<Trig>& t)
+{
+	std::vector<BoundingBox> bounds(t.size());
+	for (unsigned int i = 0; i < t.size(); ++i)
+	{
+		for (int j = 0; j < 3; ++j)
+		{
+			bounds[i].extend(v[t[i][j]]);
+		}
+	}
+	return bounds;
+}
+
+// the grid of ObjLoadBench, without going through a file
+static std::vector<BoundingBox> getSyntheticBounds(int triangleCount)
+{
+	int side = 1;
+	while (2LL * side * side < triangleCount) side++;
+	int vertexSide = side + 1;
+	std::vector<Vector3f> v;
+	v.reserve((size_t)vertexSide * vertexSide);
+	for (int y = 0; y < vertexSide; ++y)
+	{
+		for (int x = 0; x < vertexSide; ++x)
+		{
+			v.push_back(Vector3f((float)x / side, 0.05f * sinf(0.37f * x) * cosf(0.21f * y), (float)y / side));
+		}
+	}
+	std::vector<Trig> t;
+	t.reserve(triangleCount);
+	for (int y = 0; y < side && (int)t.size() < triangleCount; ++y)
+	{
+		for (int x = 0; x < side && (int)t.size() < triangleCount; ++x)
+		{
+			Trig first, second;
+			int a = y * vertexSide + x;
+			first[0] = a; first[1] = a + vertexSide; first[2] = a + 1;
+			second[0] = a + 1; second[1] = a + vertexSide; second[2] = a + vertexSide + 1;
+			t.push_back(first);
+			t.push_back(second);
+		}
+	}
+	t.resize(std::min((int)t.size(), triangleCount));
+	return getTriangleBounds(v, t);
+}
+
+static bool isSameHierarchy(const BVH& a, const BVH& b)
+{
+	return a.getNodeCount() == b.getNodeCount() && a.getPrimitiveCount() == b.getPrimitiveCount()
+		&& memcmp(a.getNodes(), b.getNodes(), a.getNodeCount() * sizeof(BVHNode)) == 0
+		&& memcmp(a.getPrimitiveIndices(), b.getPrimitiveIndices(), a.getPrimitiveCount() * sizeof(int)) == 0;
+}
+
+static void benchBounds(const char* name, const std::vector<BoundingBox>& bounds, ThreadPool& pool, int repeat)
+{
+	const int binCounts[] = { 4, 8, 16, 32, 64 };
+	const int leafSizes[] = { 1, 2, 4, 8 };
+	for (unsigned int b = 0; b < sizeof(binCounts) / sizeof(binCounts[0]); ++b)
+	{
+		for (unsigned int l = 0; l < sizeof(leafSizes) / sizeof(leafSizes[0]); ++l)
+		{
+			BVHBuildSettings settings;
+			settings.binCount = binCounts[b];
+			settings.maxLeafSize = leafSizes[l];
+			BVH serial;
+			for (int threads = 0; threads < 2; ++threads)
+			{
+				settings.pool = (threads == 0) ? NULL : &pool;
+				BVH bvh;
+				// best of the runs, the first one also pays for the allocations
+				double seconds = 0;
+				for (int i = 0; i < repeat; ++i)
+				{
+					bvh.build(bounds, settings);
+					seconds = (i == 0) ? bvh.getBuildSeconds() : std::min(seconds, bvh.getBuildSeconds());
+				}
+				if (threads == 0) serial = bvh;
+				printf("%s,%d,%d,%d,%d,%.3f,%.3f,%d,%s\n", name, (int)bounds.size(), settings.binCount, settings.maxLeafSize,
+					(threads == 0) ? 1 : pool.getThreadCount(), seconds * 1e3, bvh.getSAHCost(), bvh.getNodeCount(),
+					isSameHierarchy(bvh, serial) ? "yes" : "NO");
+				fflush(stdout);
+			}
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::string meshDir = "../Mesh";
+	int triangleCount = 5000000;
+	int repeat = 3;
+	int threadCount = 0;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (!strcmp(argv[i], "-mesh")) meshDir = argv[i + 1];
+		else if (!strcmp(argv[i], "-triangles")) triangleCount = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "-repeat")) repeat = std::max(1, atoi(argv[i + 1]));
+		else if (!strcmp(argv[i], "-threads")) threadCount = atoi(argv[i + 1]);
+	}
+	ThreadPool pool(threadCount);
+
+	printf("mesh,triangles,bins,leaf_size,threads,build_ms,sah_cost,nodes,same_as_serial\n");
+	const char* meshes[] = { "bunny_200", "bunny_1k", "chicken", "steve" };
+	for (unsigned int i = 0; i < sizeof(meshes) / sizeof(meshes[0]); ++i)
+	{
+		std::string filename = meshDir + "/" + meshes[i] + ".obj";
+		std::vector<Vector3f> v;
+		std::vector<Vector2f> texCoord;
+		std::vector<Trig> t;
+		if (!ObjLoader::load(filename.c_str(), v, texCoord, t))
+		{
+			printf("%s,cannot open %s\n", meshes[i], filename.c_str());
+			continue;
+		}
+		benchBounds(meshes[i], getTriangleBounds(v, t), pool, repeat);
+	}
+	if (triangleCount > 0)
+	{
+		benchBounds("synthetic", getSyntheticBounds(triangleCount), pool, repeat);
+	}
+	return 0;
+}
@@ -0,0 +1,170 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "Scene.h"
+#include "Image.h"
+#include "Renderer.h"
+#include "MeshGeometry.h"
+
+/////////////////////////////////////////////
+// Many light benchmark
+//
+// Renders a field of bunnies on a ground plane lit
+// by n point lights scattered over it, with the
+// light BVH and with the former loop over every
+// light, and prints one CSV line per run.
+// The radius of the lights shrinks as their number
+// grows so that each point is reached by about
+// the same number of lights, like the small lights
+// of a city at night: the loop grows with n, the
+// BVH with the lights actually reaching the points.
+// visited and reaching are the lights the shading
+// of a point goes through and the ones that light
+// it, averaged over a grid of points at the top of
+// the bunnies.
+//
+// LightBench [-mesh dir] [-out dir] [-res n] [-threads n]
+//     [-lights 16,64,256,1024,4096] [-shadows 0|1]
+/////////////////////////////////////////////
+
+typedef std::chrono::high_resolution_clock Clock;
+
+// bunnies per side of the field, 2 units apart
+#define LIGHT_BENCH_FIELD_SIZE 16
+// lights reaching a point of the field on average
+#define LIGHT_BENCH_LIGHTS_PER_POINT 8
+
+static std::vector<int> parseList(const char* list)
+{
+	std::vector<int> values;
+	const char* c = list;
+	while (*c)
+	{
+		values.push_back(atoi(c));
+		while (*c && *c != ',') ++c;
+		if (*c == ',') ++c;
+	}
+	return values;
+}
+
+static void buildScene(Scene& scene, const std::string& meshDir, int lightCount, float& topHeight, float& radius)
+{
+	std::shared_ptr<const MeshGeometry> bunny = MeshGeometry::load((meshDir + "/bunny_1k.obj").c_str());
+	Material* bunnyMaterial = new Material(Vector3f(0.8f, 0.7f, 0.6f), Vector3f(0.3f), 10);
+	Material* groundMaterial = new Material(Vector3f(0.5f), Vector3f(0.f), 1);
+	scene.addMaterial(bunnyMaterial);
+	scene.addMaterial(groundMaterial);
+
+	float groundHeight = (bunny != NULL) ? 10.f * bunny->getBoundingBox().getMin()[1] : 0.f;
+	topHeight = (bunny != NULL) ? 10.f * bunny->getBoundingBox().getMax()[1] : 0.f;
+	for (int i = 0; bunny != NULL && i < LIGHT_BENCH_FIELD_SIZE * LIGHT_BENCH_FIELD_SIZE; ++i)
+	{
+		int x = i % LIGHT_BENCH_FIELD_SIZE, z = i / LIGHT_BENCH_FIELD_SIZE;
+		Matrix4f matrix = Matrix4f::translation(2.f * x, 0, -2.f * z) * Matrix4f::rotateY(0.7f * i) * Matrix4f::uniformScaling(10.f);
+		scene.getGroup()->addObject(new Transform(matrix, new Mesh(bunny, bunnyMaterial)));
+	}
+	scene.getGroup()->addObject(new Plane(Vector3f(0, 1, 0), groundHeight, groundMaterial));
+
+	// lights hover over the bunnies, the area of the field is covered
+	// LIGHT_BENCH_LIGHTS_PER_POINT times by the light disks
+	float side = 2.f * LIGHT_BENCH_FIELD_SIZE;
+	radius = sqrtf(LIGHT_BENCH_LIGHTS_PER_POINT * side * side / (3.14159265f * lightCount));
+	srand(1);
+	for (int i = 0; i < lightCount; ++i)
+	{
+		Vector3f position(side * rand() / (float)RAND_MAX - 1.f, topHeight + radius * (0.1f + 0.2f * rand() / (float)RAND_MAX),
+			1.f - side * rand() / (float)RAND_MAX);
+		Vector3f color(0.3f + 0.7f * rand() / (float)RAND_MAX, 0.3f + 0.7f * rand() / (float)RAND_MAX, 0.3f + 0.7f * rand() / (float)RAND_MAX);
+		scene.addLight(new PointLight(position, color * (4.f / LIGHT_BENCH_LIGHTS_PER_POINT), radius));
+	}
+	scene.setAmbientLight(Vector3f(0.05f));
+
+	float center = side / 2 - 1.f;
+	PerspectiveCamera* camera = new PerspectiveCamera(Vector3f(center, topHeight + 0.4f * side, 0.3f * side),
+		Vector3f(0, -0.4f, -0.8f), Vector3f(0, 1, 0), 0.9f, 1.f);
+	scene.setCamera(camera);
+}
+
+// average number of lights visited and reaching a grid of points at the top of the bunnies
+static void countLights(Scene& scene, float topHeight, double& visited, double& reaching)
+{
+	int visitCount = 0, reachCount = 0, pointCount = 0;
+	Vector3f dir, col;
+	float distance;
+	float side = 2.f * LIGHT_BENCH_FIELD_SIZE;
+	for (int j = 0; j < 64; ++j)
+	{
+		for (int i = 0; i < 64; ++i)
+		{
+			Vector3f point(side * (i + 0.5f) / 64 - 1.f, topHeight, 1.f - side * (j + 0.5f) / 64);
+			auto countLight = [&](const Light* light)
+			{
+				visitCount++;
+				light->getIllumination(point, dir, col, distance);
+				if (col[0] != 0 || col[1] != 0 || col[2] != 0) reachCount++;
+			};
+			scene.getLightBVH()->visit(point, countLight);
+			pointCount++;
+		}
+	}
+	visited = (double)visitCount / pointCount;
+	reaching = (double)reachCount / pointCount;
+}
+
+int main(int argc, char* argv[])
+{
+	std::string meshDir = "../Mesh";
+	std::string outDir = ".";
+	int resolution = 256;
+	int threadCount = 0;
+	std::vector<int> lightCounts = parseList("16,64,256,1024,4096");
+	bool areShadowsEnabled = true;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (!strcmp(argv[i], "-mesh")) meshDir = argv[i + 1];
+		else if (!strcmp(argv[i], "-out")) outDir = argv[i + 1];
+		else if (!strcmp(argv[i], "-res")) resolution = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "-threads")) threadCount = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "-lights")) lightCounts = parseList(argv[i + 1]);
+		else if (!strcmp(argv[i], "-shadows")) areShadowsEnabled = atoi(argv[i + 1]) != 0;
+	}
+
+	Renderer renderer(threadCount, 32);
+	printf("lights,radius,culling,render_ms,shade_ms,visited,reaching\n");
+	for (unsigned int n = 0; n < lightCounts.size(); ++n)
+	{
+		Scene scene;
+		float topHeight, radius;
+		buildScene(scene, meshDir, lightCounts[n], topHeight, radius);
+		scene.setShadowsEnabled(areShadowsEnabled);
+		scene.getGroup()->prepare();
+
+		for (int culling = 1; culling >= 0; --culling)
+		{
+			LightBVH::setCullingEnabled(culling != 0);
+			Image image(resolution, resolution);
+			Clock::time_point start = Clock::now();
+			renderer.render(scene, image);
+			double renderMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+			if (culling)
+			{
+				std::string filename = outDir + "/lights_" + std::to_string(lightCounts[n]) + ".bmp";
+				image.SaveBMP(filename.c_str());
+			}
+
+			double visited, reaching;
+			countLights(scene, topHeight, visited, reaching);
+			printf("%d,%.3f,%d,%.3f,%.3f,%.1f,%.1f\n", lightCounts[n], radius, culling, renderMs,
+				renderer.getLastStats().shadeSeconds * 1e3, visited, reaching);
+			fflush(stdout);
+		}
+	}
+	LightBVH::setCullingEnabled(true);
+	return 0;
+}
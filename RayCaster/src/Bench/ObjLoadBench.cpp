@@ -0,0 +1,238 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ObjLoader.h"
+#include "MappedFile.h"
+#include "MeshGeometry.h"
+#include "ThreadPool.h"
+
+/////////////////////////////////////////////
+// OBJ loader benchmark
+//
+// Loads the bundled meshes and a synthetic
+// grid mesh with the memory mapped loader
+// (one chunk and parallel chunks) and with
+// the former getline/stringstream parser,
+// and prints one CSV line per run with the
+// throughput in MB/s.
+// The mesh_* rows time a whole
+// MeshGeometry::load (parse, normals, BVH)
+// against the mapped binary cache, MB/s
+// are still given relative to the .obj.
+//
+// ObjLoadBench [-mesh dir] [-out dir]
+//     [-triangles n] [-legacy-max-mb m]
+//
+// The synthetic file (10M triangles, about
+// 700 MB, by default) and its cache are
+// written to -out and removed afterwards.
+/////////////////////////////////////////////
+
+typedef std::chrono::high_resolution_clock Clock;
+
+// reference: the parser Mesh used before the memory mapped loader
+static void loadLegacy(const char* filename, std::vector<Vector3f>& v, std::vector<Vector2f>& texCoord, std::vector<Trig>& t)
+{
+	v.clear();
+	texCoord.clear();
+	t.clear();
+	std::ifstream f(filename);
+	std::string line, tok;
+	while (std::getline(f, line))
+	{
+		if (line.size() < 3 || line.at(0) == '#') continue;
+		std::stringstream ss(line);
+		ss >> tok;
+		if (tok == "v")
+		{
+			Vector3f vec;
+			ss >> vec[0] >> vec[1] >> vec[2];
+			v.push_back(vec);
+		}
+		else if (tok == "vt")
+		{
+			Vector2f texcoord;
+			ss >> texcoord[0] >> texcoord[1];
+			texCoord.push_back(texcoord);
+		}
+		else if (tok == "f")
+		{
+			Trig trig;
+			if (line.find('/') != std::string::npos)
+			{
+				for (unsigned int i = 0; i < line.size(); ++i)
+				{
+					if (line[i] == '/') line[i] = ' ';
+				}
+				std::stringstream facess(line);
+				facess >> tok;
+				for (int i = 0; i < 3; ++i)
+				{
+					facess >> trig[i] >> trig.texID[i];
+					trig[i]--;
+					trig.texID[i]--;
+				}
+			}
+			else
+			{
+				for (int i = 0; i < 3; ++i)
+				{
+					ss >> trig[i];
+					trig[i]--;
+					trig.texID[i] = 0;
+				}
+			}
+			t.push_back(trig);
+		}
+	}
+}
+
+// square grid of quads split in two triangles, with texture coordinates
+static bool writeSyntheticObj(const char* filename, long long triangleCount)
+{
+	FILE* file = fopen(filename, "wb");
+	if (file == NULL) return false;
+	int side = 1;
+	while (2LL * side * side < triangleCount) side++;
+	int vertexSide = side + 1;
+	for (int y = 0; y < vertexSide; ++y)
+	{
+		for (int x = 0; x < vertexSide; ++x)
+		{
+			fprintf(file, "v %.6f %.6f %.6f\n", (float)x / side, 0.05f * sinf(0.37f * x) * cosf(0.21f * y), (float)y / side);
+		}
+	}
+	for (int y = 0; y < vertexSide; ++y)
+	{
+		for (int x = 0; x < vertexSide; ++x)
+		{
+			fprintf(file, "vt %.6f %.6f\n", (float)x / side, (float)y / side);
+		}
+	}
+	long long written = 0;
+	for (int y = 0; y < side && written < triangleCount; ++y)
+	{
+		for (int x = 0; x < side && written < triangleCount; ++x)
+		{
+			int a = y * vertexSide + x + 1;
+			int b = a + 1;
+			int c = a + vertexSide;
+			int d = c + 1;
+			fprintf(file, "f %d/%d %d/%d %d/%d\n", a, a, c, c, b, b);
+			fprintf(file, "f %d/%d %d/%d %d/%d\n", b, b, c, c, d, d);
+			written += 2;
+		}
+	}
+	fclose(file);
+	return true;
+}
+
+static long long getFileSize(const char* filename)
+{
+	MappedFile file;
+	return file.open(filename) ? (long long)file.getSize() : -1;
+}
+
+static void benchFile(const char* name, const char* filename, bool runLegacy)
+{
+	long long size = getFileSize(filename);
+	if (size < 0)
+	{
+		printf("%s,cannot open %s\n", name, filename);
+		return;
+	}
+	double sizeMB = size / (1024.0 * 1024.0);
+	// small files are loaded several times to get a measurable duration
+	int repeat = (int)std::max(1.0, std::min(200.0, 64.0 / sizeMB));
+
+	std::vector<Vector3f> v;
+	std::vector<Vector2f> texCoord;
+	std::vector<Trig> t;
+	for (int mode = 0; mode < 5; ++mode)
+	{
+		if (mode == 2 && !runLegacy) continue;
+		int triangleCount = 0;
+		if (mode == 4)
+		{
+			// first load writes the cache, the timed ones map it (warm page cache)
+			MeshGeometry::setCacheEnabled(true);
+			MeshGeometry::load(filename);
+		}
+		Clock::time_point start = Clock::now();
+		for (int i = 0; i < repeat; ++i)
+		{
+			if (mode == 2)
+			{
+				loadLegacy(filename, v, texCoord, t);
+			}
+			else if (mode >= 3)
+			{
+				MeshGeometry::setCacheEnabled(mode == 4);
+				std::shared_ptr<const MeshGeometry> geometry = MeshGeometry::load(filename);
+				triangleCount = geometry ? geometry->getTriangleCount() : 0;
+			}
+			else
+			{
+				MappedFile file;
+				file.open(filename);
+				ObjLoader::parse(file.getData(), file.getSize(), v, texCoord, t, (mode == 0) ? 1 : 0);
+			}
+		}
+		double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / repeat;
+		if (mode < 3) triangleCount = t.size();
+		const char* modes[] = { "mmap_1_chunk", "mmap_parallel", "legacy_stringstream", "mesh_obj", "mesh_cache" };
+		printf("%s,%.2f,%d,%d,%s,%.3f,%.1f\n", name, sizeMB, triangleCount, ThreadPool::getGlobal().getThreadCount(),
+			modes[mode], ms, sizeMB / (ms * 1e-3));
+		fflush(stdout);
+	}
+	MeshGeometry::setCacheEnabled(true);
+}
+
+int main(int argc, char* argv[])
+{
+	std::string meshDir = "../Mesh";
+	std::string outDir = ".";
+	long long triangleCount = 10000000;
+	double legacyMaxMB = 64;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (!strcmp(argv[i], "-mesh")) meshDir = argv[i + 1];
+		else if (!strcmp(argv[i], "-out")) outDir = argv[i + 1];
+		else if (!strcmp(argv[i], "-triangles")) triangleCount = atoll(argv[i + 1]);
+		else if (!strcmp(argv[i], "-legacy-max-mb")) legacyMaxMB = atof(argv[i + 1]);
+	}
+
+	printf("file,size_mb,triangles,threads,loader,ms,mb_per_s\n");
+	const char* meshes[] = { "bunny_200", "bunny_1k", "chicken", "steve", "c1", "c2", "c3", "cube" };
+	for (unsigned int i = 0; i < sizeof(meshes) / sizeof(meshes[0]); ++i)
+	{
+		std::string filename = meshDir + "/" + meshes[i] + ".obj";
+		benchFile(meshes[i], filename.c_str(), true);
+	}
+
+	if (triangleCount > 0)
+	{
+		std::string filename = outDir + "/synthetic_" + std::to_string(triangleCount) + ".obj";
+		Clock::time_point start = Clock::now();
+		if (!writeSyntheticObj(filename.c_str(), triangleCount))
+		{
+			printf("synthetic,cannot write %s\n", filename.c_str());
+			return 1;
+		}
+		fprintf(stderr, "wrote %s in %.1f s\n", filename.c_str(), std::chrono::duration<double>(Clock::now() - start).count());
+		double sizeMB = getFileSize(filename.c_str()) / (1024.0 * 1024.0);
+		benchFile("synthetic", filename.c_str(), sizeMB <= legacyMaxMB);
+		remove(filename.c_str());
+		remove((filename + MESH_CACHE_EXTENSION).c_str());
+	}
+	return 0;
+}
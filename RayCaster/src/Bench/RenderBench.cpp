@@ -0,0 +1,265 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "Scene.h"
+#include "Image.h"
+#include "Renderer.h"
+#include "MeshGeometry.h"
+#include "TextureCache.h"
+
+/////////////////////////////////////////////
+// Rendering benchmark
+//
+// Renders canned scenes built from the bundled
+// meshes at several resolutions and prints one
+// JSON object per run:
+//   load  : .obj/.bmp parsing and mesh BVH builds,
+//           or mapping the binary mesh caches
+//   build : scene level acceleration structures
+//   trace : primary rays (summed over threads), in
+//           packets of 8x8 pixels unless -packets 0;
+//           single rays go through the wide BVH
+//           unless -wide 0
+//   shade : lights and materials (summed over threads)
+//   save  : writing the BMP
+// and the texture cache hits, misses and resident
+// megabytes once the scene is built.
+//
+// When built with RAYCASTER_COUNTERS, each run also reports
+// node visits and intersection tests per primary ray and
+// writes a <scene>_<res>_heatmap.bmp next to the image.
+// A packet counts a node once for all its rays: the
+// pixels of a packet share its cost evenly.
+//
+// RenderBench [-mesh dir] [-out dir] [-res 128,256,512]
+//     [-threads n] [-tile size] [-scene name]
+//     [-mesh-cache 0|1] [-texture-budget mb] [-mipmaps 0|1]
+//     [-shadows 0|1] [-packets 0|1] [-wide 0|1]
+/////////////////////////////////////////////
+
+typedef std::chrono::high_resolution_clock Clock;
+
+struct BenchScene
+{
+	const char* name;
+	void (*build)(Scene& scene, const std::string& meshDir);
+};
+
+static double elapsedMs(Clock::time_point start, Clock::time_point end)
+{
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static Material* addMaterial(Scene& scene, const Vector3f& color, const std::string& texture = "")
+{
+	Material* material = new Material(color, Vector3f(0.3f), 10);
+	if (texture != "")
+	{
+		material->loadTexture(texture.c_str());
+	}
+	scene.addMaterial(material);
+	return material;
+}
+
+static void addMesh(Scene& scene, const std::string& filename, Material* material, const Matrix4f& matrix = Matrix4f::identity())
+{
+	scene.getGroup()->addObject(new Transform(matrix, new Mesh(filename.c_str(), material)));
+}
+
+static void addLights(Scene& scene)
+{
+	scene.addLight(new PointLight(Vector3f(5, 10, 10), Vector3f(0.8f)));
+	scene.addLight(new DirectionalLight(Vector3f(-1, -1, -1), Vector3f(0.3f)));
+	scene.setAmbientLight(Vector3f(0.1f));
+}
+
+static void buildBunny200(Scene& scene, const std::string& meshDir)
+{
+	addMesh(scene, meshDir + "/bunny_200.obj", addMaterial(scene, Vector3f(0.8f, 0.7f, 0.6f)));
+	addLights(scene);
+}
+
+static void buildBunny1k(Scene& scene, const std::string& meshDir)
+{
+	addMesh(scene, meshDir + "/bunny_1k.obj", addMaterial(scene, Vector3f(0.8f, 0.7f, 0.6f)));
+	addLights(scene);
+}
+
+static void buildChicken(Scene& scene, const std::string& meshDir)
+{
+	addMesh(scene, meshDir + "/chicken.obj", addMaterial(scene, Vector3f(1.f), meshDir + "/chicken.bmp"));
+	addLights(scene);
+}
+
+static void buildSteve(Scene& scene, const std::string& meshDir)
+{
+	addMesh(scene, meshDir + "/steve.obj", addMaterial(scene, Vector3f(1.f), meshDir + "/char.bmp"));
+	addLights(scene);
+}
+
+static void buildCubes(Scene& scene, const std::string& meshDir)
+{
+	Material* material = addMaterial(scene, Vector3f(0.4f, 0.6f, 0.9f));
+	const char* files[] = { "/c1.obj", "/c2.obj", "/c3.obj", "/cube.obj" };
+	for (int i = 0; i < 4; ++i)
+	{
+		addMesh(scene, meshDir + files[i], material, Matrix4f::translation(3.f * i, 0, 0));
+	}
+	addLights(scene);
+}
+
+static void buildMixed(Scene& scene, const std::string& meshDir)
+{
+	Material* red = addMaterial(scene, Vector3f(0.8f, 0.3f, 0.3f));
+	Material* green = addMaterial(scene, Vector3f(0.3f, 0.8f, 0.3f));
+	addMesh(scene, meshDir + "/bunny_1k.obj", red, Matrix4f::uniformScaling(10.f));
+	addMesh(scene, meshDir + "/chicken.obj", addMaterial(scene, Vector3f(1.f), meshDir + "/chicken.bmp"),
+		Matrix4f::translation(-2.f, 0, 0) * Matrix4f::uniformScaling(0.2f));
+	addMesh(scene, meshDir + "/steve.obj", addMaterial(scene, Vector3f(1.f), meshDir + "/char.bmp"),
+		Matrix4f::translation(2.f, 0, 0) * Matrix4f::uniformScaling(0.3f));
+	for (int i = 0; i < 64; ++i)
+	{
+		float angle = 2.f * 3.14159265f * i / 64;
+		scene.getGroup()->addObject(new Sphere(Vector3f(3.f * cosf(angle), -0.5f, 3.f * sinf(angle)), 0.15f, red));
+	}
+	scene.getGroup()->addObject(new Plane(Vector3f(0, 1, 0), -1.f, green));
+	addLights(scene);
+}
+
+// 1024 instances sharing a single copy of the bunny geometry and BVH
+static void buildBunnyField(Scene& scene, const std::string& meshDir)
+{
+	std::shared_ptr<const MeshGeometry> bunny = MeshGeometry::load((meshDir + "/bunny_1k.obj").c_str());
+	Material* materials[2] = { addMaterial(scene, Vector3f(0.8f, 0.7f, 0.6f)), addMaterial(scene, Vector3f(0.4f, 0.6f, 0.9f)) };
+	for (int i = 0; i < 1024; ++i)
+	{
+		int x = i % 32, z = i / 32;
+		Matrix4f matrix = Matrix4f::translation(2.f * x, 0, -2.f * z) * Matrix4f::rotateY(0.7f * i) * Matrix4f::uniformScaling(10.f);
+		scene.getGroup()->addObject(new Transform(matrix, new Mesh(bunny, materials[(x + z) % 2])));
+	}
+	addLights(scene);
+}
+
+// point a camera at the bounded part of the scene, from the front
+static void frameScene(Scene& scene, int width, int height)
+{
+	BoundingBox box;
+	for (int i = 0; i < scene.getGroup()->getGroupSize(); ++i)
+	{
+		BoundingBox objBox;
+		if (scene.getGroup()->getObject(i)->getBoundingBox(objBox))
+			box.extend(objBox);
+	}
+	Vector3f center = box.getCenter();
+	float radius = box.getExtent().abs() / 2;
+	PerspectiveCamera* camera = new PerspectiveCamera(center + Vector3f(0, 0.3f * radius, 2.2f * radius),
+		Vector3f(0, -0.3f, -2.2f), Vector3f(0, 1, 0), 0.8f, (float)width / height);
+	delete scene.getCamera();
+	scene.setCamera(camera);
+}
+
+static std::vector<int> parseResolutions(const char* list)
+{
+	std::vector<int> resolutions;
+	const char* c = list;
+	while (*c)
+	{
+		resolutions.push_back(atoi(c));
+		while (*c && *c != ',') ++c;
+		if (*c == ',') ++c;
+	}
+	return resolutions;
+}
+
+int main(int argc, char* argv[])
+{
+	std::string meshDir = "../Mesh";
+	std::string outDir = ".";
+	std::vector<int> resolutions = parseResolutions("128,256,512");
+	int threadCount = 0;
+	int tileSize = 32;
+	const char* onlyScene = NULL;
+	bool areShadowsEnabled = true;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (!strcmp(argv[i], "-mesh")) meshDir = argv[i + 1];
+		else if (!strcmp(argv[i], "-out")) outDir = argv[i + 1];
+		else if (!strcmp(argv[i], "-res")) resolutions = parseResolutions(argv[i + 1]);
+		else if (!strcmp(argv[i], "-threads")) threadCount = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "-tile")) tileSize = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "-scene")) onlyScene = argv[i + 1];
+		else if (!strcmp(argv[i], "-mesh-cache")) MeshGeometry::setCacheEnabled(atoi(argv[i + 1]) != 0);
+		else if (!strcmp(argv[i], "-texture-budget")) TextureCache::getGlobal().setBudget((size_t)(atof(argv[i + 1]) * 1024 * 1024));
+		else if (!strcmp(argv[i], "-mipmaps")) Texture::setMipmapsEnabled(atoi(argv[i + 1]) != 0);
+		else if (!strcmp(argv[i], "-shadows")) areShadowsEnabled = atoi(argv[i + 1]) != 0;
+		else if (!strcmp(argv[i], "-packets")) Renderer::setPacketsEnabled(atoi(argv[i + 1]) != 0);
+		else if (!strcmp(argv[i], "-wide")) WideBVH::setEnabled(atoi(argv[i + 1]) != 0);
+	}
+
+	BenchScene scenes[] =
+	{
+		{ "bunny_200", buildBunny200 },
+		{ "bunny_1k", buildBunny1k },
+		{ "chicken", buildChicken },
+		{ "steve", buildSteve },
+		{ "cubes", buildCubes },
+		{ "mixed", buildMixed },
+		{ "bunny_field", buildBunnyField },
+	};
+	Renderer renderer(threadCount, tileSize);
+
+	for (unsigned int s = 0; s < sizeof(scenes) / sizeof(scenes[0]); ++s)
+	{
+		if (onlyScene != NULL && strcmp(onlyScene, scenes[s].name) != 0) continue;
+		for (unsigned int r = 0; r < resolutions.size(); ++r)
+		{
+			int width = resolutions[r];
+			int height = resolutions[r];
+
+			TextureCache::getGlobal().resetStats();
+			Clock::time_point t0 = Clock::now();
+			Scene scene;
+			scenes[s].build(scene, meshDir);
+			scene.setShadowsEnabled(areShadowsEnabled);
+			Clock::time_point t1 = Clock::now();
+			TextureCacheStats textureStats = TextureCache::getGlobal().getStats();
+			scene.getGroup()->prepare();
+			frameScene(scene, width, height);
+			Clock::time_point t2 = Clock::now();
+			Image image(width, height);
+			renderer.render(scene, image);
+			Clock::time_point t3 = Clock::now();
+			std::string filename = outDir + "/" + scenes[s].name + "_" + std::to_string(width) + ".bmp";
+			image.SaveBMP(filename.c_str());
+			Clock::time_point t4 = Clock::now();
+
+			const RenderStats& stats = renderer.getLastStats();
+			char counters[128] = "";
+			if (Renderer::hasCounters())
+			{
+				Image heatmap(width, height);
+				renderer.getHeatmap(heatmap);
+				std::string heatmapName = outDir + "/" + scenes[s].name + "_" + std::to_string(width) + "_heatmap.bmp";
+				heatmap.SaveBMP(heatmapName.c_str());
+				sprintf(counters, ", \"nodes_per_ray\": %.2f, \"tests_per_ray\": %.2f",
+					(double)stats.nodeVisits / stats.primaryRays, (double)stats.intersectionTests / stats.primaryRays);
+			}
+			printf("{\"scene\": \"%s\", \"width\": %d, \"height\": %d, \"threads\": %d, \"tile\": %d, \"packets\": %d, \"wide\": %d, "
+				"\"wall_ms\": %.3f, \"render_ms\": %.3f, \"primary_rays_per_sec\": %.0f, "
+				"\"phases_ms\": {\"load\": %.3f, \"build\": %.3f, \"trace\": %.3f, \"shade\": %.3f, \"save\": %.3f}, "
+				"\"textures\": {\"hits\": %lld, \"misses\": %lld, \"resident_mb\": %.2f}%s}\n",
+				scenes[s].name, width, height, renderer.getThreadCount(), renderer.getTileSize(), Renderer::arePacketsEnabled() ? 1 : 0,
+				WideBVH::isEnabled() ? 1 : 0,
+				elapsedMs(t0, t4), elapsedMs(t2, t3), stats.primaryRays / stats.wallSeconds,
+				elapsedMs(t0, t1), elapsedMs(t1, t2), stats.traceSeconds * 1e3, stats.shadeSeconds * 1e3, elapsedMs(t3, t4),
+				textureStats.hits, textureStats.misses, textureStats.residentBytes / (1024.0 * 1024.0), counters);
+			fflush(stdout);
+		}
+	}
+	return 0;
+}
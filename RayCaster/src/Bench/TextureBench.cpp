@@ -0,0 +1,199 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "Texture.h"
+#include "bitmap_image.h"
+
+/////////////////////////////////////////////
+// Texture lookup benchmark
+//
+// Filters the same coordinates with the former
+// per channel lookup on the row major BGR bitmap,
+// with the tiled texture one lookup at a time,
+// with the batched lookup, and with the batched
+// trilinear lookup in the mip pyramid, and prints
+// one CSV line per run with the lookups per second.
+// Coordinates are either coherent (a screen
+// space sweep over a quarter of the texture, like
+// a textured surface seen by a tile of rays),
+// random over the whole texture, or minified (the
+// whole texture seen by 256 x 256 pixels).
+// Trilinear lookups differ from the others when
+// minified, their mismatches are then not counted.
+//
+// TextureBench [-mesh dir] [-out dir] [-size n] [-lookups n]
+//
+// The bundled textures are small, a generated
+// n x n texture (2048 by default) is written to
+// -out and removed afterwards.
+/////////////////////////////////////////////
+
+typedef std::chrono::high_resolution_clock Clock;
+
+// reference: the lookup Texture used before the tiled storage
+static Vector3f sampleLegacy(bitmap_image& bimg, float x, float y)
+{
+	int width = bimg.width(), height = bimg.height();
+	Vector3f color;
+	x = x * width;
+	y = (1 - y) * height;
+	int ix = (int)x;
+	int iy = (int)y;
+	unsigned char pixels[4][3];
+	float alpha = x - ix;
+	float beta = y - iy;
+	int px[4] = { ix, ix + 1, ix, ix + 1 };
+	int py[4] = { iy, iy, iy + 1, iy + 1 };
+	for (int k = 0; k < 4; ++k)
+	{
+		bimg.get_pixel(clamp(px[k], 0, width - 1), clamp(py[k], 0, height - 1), pixels[k][0], pixels[k][1], pixels[k][2]);
+	}
+	for (int ii = 0; ii < 3; ii++)
+	{
+		color[ii] = (1 - alpha) * (1 - beta) * pixels[0][ii]
+			+ alpha * (1 - beta) * pixels[1][ii]
+			+ (1 - alpha) * beta * pixels[2][ii]
+			+ alpha * beta * pixels[3][ii];
+	}
+	return color / 255;
+}
+
+static bool writeSyntheticBmp(const char* filename, int size)
+{
+	bitmap_image image(size, size);
+	for (int y = 0; y < size; ++y)
+	{
+		for (int x = 0; x < size; ++x)
+		{
+			image.set_pixel(x, y, (unsigned char)(x * 7 + y), (unsigned char)(x ^ y), (unsigned char)(x * y >> 4));
+		}
+	}
+	image.save_image(filename);
+	return true;
+}
+
+static void benchTexture(const char* name, const char* filename, int lookupCount)
+{
+	Texture texture;
+	bitmap_image bimg(filename);
+	if (!texture.load(filename))
+	{
+		printf("%s,cannot open %s\n", name, filename);
+		return;
+	}
+
+	for (int pattern = 0; pattern < 3; ++pattern)
+	{
+		std::vector<float> u(lookupCount), v(lookupCount), lod(lookupCount);
+		srand(1);
+		int side = (int)sqrtf((float)lookupCount);
+		for (int i = 0; i < lookupCount; ++i)
+		{
+			if (pattern == 0)
+			{
+				// 64 x 64 pixel blocks, like the tiles of the renderer
+				int block = i / 4096, inBlock = i % 4096;
+				int px = (block % (side / 64 + 1)) * 64 + inBlock % 64;
+				int py = (block / (side / 64 + 1)) * 64 + inBlock / 64;
+				u[i] = 0.25f * px / side + 0.3f;
+				v[i] = 0.25f * py / side + 0.3f;
+			}
+			else if (pattern == 1)
+			{
+				u[i] = rand() / (float)RAND_MAX;
+				v[i] = rand() / (float)RAND_MAX;
+			}
+			else
+			{
+				// 32 x 32 pixel blocks of a 256 x 256 view of the whole texture
+				int block = (i / 1024) % 64, inBlock = i % 1024;
+				u[i] = ((block % 8) * 32 + inBlock % 32) / 256.f;
+				v[i] = ((block / 8) * 32 + inBlock / 32) / 256.f;
+			}
+			// one pixel is side / 4 texels away in the coherent sweep, 1 / 256 of the texture when minified
+			Vector2f dx((pattern == 0) ? 0.25f / side : (pattern == 2) ? 1.f / 256 : 0.f, 0.f);
+			lod[i] = texture.getLevelOfDetail(dx, Vector2f(dx.y(), dx.x()));
+		}
+
+		std::vector<Vector3f> colors(lookupCount);
+		for (int mode = 0; mode < 4; ++mode)
+		{
+			int mismatches = 0;
+			// best of 3 runs
+			double ms = 0;
+			for (int run = 0; run < 3; ++run)
+			{
+				Clock::time_point start = Clock::now();
+				if (mode == 0)
+				{
+					for (int i = 0; i < lookupCount; ++i) colors[i] = sampleLegacy(bimg, u[i], v[i]);
+				}
+				else if (mode == 1)
+				{
+					for (int i = 0; i < lookupCount; ++i) colors[i] = texture(u[i], v[i]);
+				}
+				else if (mode == 2)
+				{
+					texture.sample(&u[0], &v[0], lookupCount, &colors[0]);
+				}
+				else
+				{
+					texture.sample(&u[0], &v[0], &lod[0], lookupCount, &colors[0]);
+				}
+				double runMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+				ms = (run == 0 || runMs < ms) ? runMs : ms;
+			}
+			if (mode == 1 || mode == 2 || (mode == 3 && pattern != 2))
+			{
+				for (int i = 0; i < lookupCount; i += 97)
+				{
+					Vector3f reference = sampleLegacy(bimg, u[i], v[i]);
+					if (reference[0] != colors[i][0] || reference[1] != colors[i][1] || reference[2] != colors[i][2]) mismatches++;
+				}
+			}
+			const char* modes[] = { "legacy_bgr", "tiled_single", "tiled_batch", "mip_batch" };
+			const char* patterns[] = { "coherent", "random", "minified" };
+			printf("%s,%dx%d,%s,%s,%.3f,%.1f,%d\n", name, texture.getWidth(), texture.getHeight(), patterns[pattern], modes[mode],
+				ms, lookupCount / (ms * 1e3), mismatches);
+			fflush(stdout);
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::string meshDir = "../Mesh";
+	std::string outDir = ".";
+	int size = 2048;
+	int lookupCount = 1 << 22;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (!strcmp(argv[i], "-mesh")) meshDir = argv[i + 1];
+		else if (!strcmp(argv[i], "-out")) outDir = argv[i + 1];
+		else if (!strcmp(argv[i], "-size")) size = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "-lookups")) lookupCount = atoi(argv[i + 1]);
+	}
+
+	printf("texture,size,pattern,lookup,ms,mlookups_per_s,mismatches\n");
+	const char* textures[] = { "char", "head" };
+	for (unsigned int i = 0; i < sizeof(textures) / sizeof(textures[0]); ++i)
+	{
+		std::string filename = meshDir + "/" + textures[i] + ".bmp";
+		benchTexture(textures[i], filename.c_str(), lookupCount);
+	}
+
+	if (size > 0)
+	{
+		std::string filename = outDir + "/synthetic_" + std::to_string(size) + ".bmp";
+		writeSyntheticBmp(filename.c_str(), size);
+		benchTexture("synthetic", filename.c_str(), lookupCount);
+		remove(filename.c_str());
+	}
+	return 0;
+}
@@ -0,0 +1,442 @@
+#include "BVH.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <climits>
+#include <memory>
+
+///////////////////////////
+// BVH class Implementation
+///////////////////////////
+
+static_assert(BVH_MAX_DEPTH <= BVH_STACK_SIZE, "a leaf at BVH_MAX_DEPTH would overflow the traversal stacks");
+
+struct BVHBin
+{
+	BVHBin() : count(0) {}
+	BoundingBox box;
+	int count;
+};
+
+///@brief arrays of one build, shared by its tasks
+struct BVHBuildContext
+{
+	const std::vector<BoundingBox>* bounds;
+	std::vector<Vector3f> centroids;
+	int binCount;
+	int maxLeafSize;
+	ThreadPool* pool;
+};
+
+///@brief bins of the nodes built by one thread, reused from node to node
+struct BVHBuildScratch
+{
+	std::vector<BVHBin> bins;
+	std::vector<float> leftArea;
+	std::vector<int> leftCount;
+};
+
+///@brief part of the hierarchy built by one task: a whole subtree in nodes,
+///or a single inner node whose children were built by their own tasks
+struct BVHBuildTask
+{
+	std::vector<BVHNode> nodes;
+	std::unique_ptr<BVHBuildTask> children[2];
+};
+
+BVH::BVH() :
+m_nodes(),
+m_primIndices(),
+m_nodeData(NULL),
+m_nodeCount(0),
+m_primData(NULL),
+m_primCount(0),
+m_buildSeconds(0)
+{
+}
+
+BVH::BVH(const BVH& bvh) :
+m_nodes(bvh.m_nodes),
+m_primIndices(bvh.m_primIndices),
+m_nodeData(bvh.m_nodeData),
+m_nodeCount(bvh.m_nodeCount),
+m_primData(bvh.m_primData),
+m_primCount(bvh.m_primCount),
+m_buildSeconds(bvh.m_buildSeconds)
+{
+	if (!m_nodes.empty()) useOwnedArrays();
+}
+
+BVH& BVH::operator= (const BVH& bvh)
+{
+	if (this != &bvh)
+	{
+		m_nodes = bvh.m_nodes;
+		m_primIndices = bvh.m_primIndices;
+		m_nodeData = bvh.m_nodeData;
+		m_nodeCount = bvh.m_nodeCount;
+		m_primData = bvh.m_primData;
+		m_primCount = bvh.m_primCount;
+		m_buildSeconds = bvh.m_buildSeconds;
+		if (!m_nodes.empty()) useOwnedArrays();
+	}
+	return *this;
+}
+
+BVH::~BVH()
+{
+}
+
+void BVH::build(const std::vector<BoundingBox>& bounds, int maxLeafSize)
+{
+	BVHBuildSettings settings;
+	settings.maxLeafSize = maxLeafSize;
+	build(bounds, settings);
+}
+
+void BVH::build(const std::vector<BoundingBox>& bounds, const BVHBuildSettings& settings)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	clear();
+	if (bounds.empty()) return;
+
+	BVHBuildContext context;
+	context.bounds = &bounds;
+	context.centroids.resize(bounds.size());
+	context.binCount = std::max(settings.binCount, 2);
+	context.maxLeafSize = std::max(settings.maxLeafSize, 1);
+	context.pool = (settings.pool != NULL && settings.pool->getThreadCount() > 1) ? settings.pool : NULL;
+	m_primIndices.resize(bounds.size());
+	for (unsigned int i = 0; i < bounds.size(); ++i)
+	{
+		context.centroids[i] = bounds[i].getCenter();
+		m_primIndices[i] = i;
+	}
+	m_nodes.reserve(2 * bounds.size());
+	if (context.pool == NULL)
+	{
+		BVHBuildScratch scratch;
+		buildNode(context, scratch, 0, bounds.size(), 0, m_nodes);
+	}
+	else
+	{
+		BVHBuildTask root;
+		buildTask(context, 0, bounds.size(), 0, root);
+		spliceTask(root);
+	}
+	useOwnedArrays();
+	m_buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void BVH::attach(const BVHNode* nodes, int nodeCount, const int* primIndices, int primCount)
+{
+	clear();
+	m_nodeData = nodes;
+	m_nodeCount = nodeCount;
+	m_primData = primIndices;
+	m_primCount = primCount;
+}
+
+void BVH::clear()
+{
+	m_nodes.clear();
+	m_primIndices.clear();
+	m_nodeData = NULL;
+	m_nodeCount = 0;
+	m_primData = NULL;
+	m_primCount = 0;
+	m_buildSeconds = 0;
+}
+
+void BVH::useOwnedArrays()
+{
+	m_nodeData = m_nodes.data();
+	m_nodeCount = m_nodes.size();
+	m_primData = m_primIndices.data();
+	m_primCount = m_primIndices.size();
+}
+
+bool BVH::isEmpty() const
+{
+	return m_nodeCount == 0;
+}
+
+int BVH::getNodeCount() const
+{
+	return m_nodeCount;
+}
+
+const BVHNode& BVH::getNode(int i) const
+{
+	assert(i >= 0 && i < m_nodeCount);
+	return m_nodeData[i];
+}
+
+const BVHNode* BVH::getNodes() const
+{
+	return m_nodeData;
+}
+
+const int* BVH::getPrimitiveIndices() const
+{
+	return m_primData;
+}
+
+int BVH::getPrimitiveCount() const
+{
+	return m_primCount;
+}
+
+BoundingBox BVH::getBounds() const
+{
+	return (m_nodeCount == 0) ? BoundingBox() : m_nodeData[0].box;
+}
+
+double BVH::getBuildSeconds() const
+{
+	return m_buildSeconds;
+}
+
+float BVH::getSAHCost() const
+{
+	if (m_nodeCount == 0) return 0.f;
+
+	// a ray entering the root enters each node with the probability of its area relative to the root one
+	float rootArea = m_nodeData[0].box.getSurfaceArea();
+	if (rootArea <= 0.f) rootArea = 1.f;
+	double cost = 0;
+	for (int i = 0; i < m_nodeCount; ++i)
+	{
+		const BVHNode& node = m_nodeData[i];
+		float nodeCost = (node.count > 0) ? BVH_INTERSECTION_COST * node.count : BVH_TRAVERSAL_COST;
+		cost += nodeCost * node.box.getSurfaceArea() / rootArea;
+	}
+	return (float)cost;
+}
+
+bool BVH::splitNode(BVHBuildContext& context, BVHBuildScratch& scratch, int start, int end, int depth, BoundingBox& box, int& axis, int& mid)
+{
+	const std::vector<BoundingBox>& bounds = *context.bounds;
+	const std::vector<Vector3f>& centroids = context.centroids;
+	int count = end - start;
+	// large nodes go through their primitives in parallel chunks, each one with its own boxes and bins.
+	// Merging them gives the same boxes and counts as one pass: the hierarchy doesn't depend on the pool
+	int chunkCount = (context.pool != NULL) ? (count + BVH_PARALLEL_CHUNK_SIZE - 1) / BVH_PARALLEL_CHUNK_SIZE : 1;
+
+	BoundingBox centroidBox;
+	box = BoundingBox();
+	if (chunkCount > 1)
+	{
+		std::vector<BoundingBox> chunkBoxes(chunkCount), chunkCentroidBoxes(chunkCount);
+		context.pool->parallelFor(chunkCount, [&](int c)
+		{
+			int chunkEnd = std::min(start + (c + 1) * BVH_PARALLEL_CHUNK_SIZE, end);
+			for (int i = start + c * BVH_PARALLEL_CHUNK_SIZE; i < chunkEnd; ++i)
+			{
+				chunkBoxes[c].extend(bounds[m_primIndices[i]]);
+				chunkCentroidBoxes[c].extend(centroids[m_primIndices[i]]);
+			}
+		});
+		for (int c = 0; c < chunkCount; ++c)
+		{
+			box.extend(chunkBoxes[c]);
+			centroidBox.extend(chunkCentroidBoxes[c]);
+		}
+	}
+	else
+	{
+		for (int i = start; i < end; ++i)
+		{
+			box.extend(bounds[m_primIndices[i]]);
+			centroidBox.extend(centroids[m_primIndices[i]]);
+		}
+	}
+
+	axis = 0;
+	if (count == 1) return false;
+
+	axis = centroidBox.getLongestAxis();
+	float axisMin = centroidBox.getMin()[axis];
+	float axisExtent = centroidBox.getExtent()[axis];
+	mid = start;
+
+	if (axisExtent > 0.f)
+	{
+		// bin the centroids along the longest axis and sweep the bin boundaries
+		int binCount = context.binCount;
+		float binScale = binCount / axisExtent;
+		std::vector<BVHBin>& bins = scratch.bins;
+		bins.assign(binCount, BVHBin());
+		if (chunkCount > 1)
+		{
+			std::vector<BVHBin> chunkBins(chunkCount * binCount);
+			context.pool->parallelFor(chunkCount, [&](int c)
+			{
+				BVHBin* cBins = &chunkBins[c * binCount];
+				int chunkEnd = std::min(start + (c + 1) * BVH_PARALLEL_CHUNK_SIZE, end);
+				for (int i = start + c * BVH_PARALLEL_CHUNK_SIZE; i < chunkEnd; ++i)
+				{
+					int b = std::min((int)((centroids[m_primIndices[i]][axis] - axisMin) * binScale), binCount - 1);
+					cBins[b].count++;
+					cBins[b].box.extend(bounds[m_primIndices[i]]);
+				}
+			});
+			for (int c = 0; c < chunkCount; ++c)
+			{
+				for (int b = 0; b < binCount; ++b)
+				{
+					bins[b].count += chunkBins[c * binCount + b].count;
+					bins[b].box.extend(chunkBins[c * binCount + b].box);
+				}
+			}
+		}
+		else
+		{
+			for (int i = start; i < end; ++i)
+			{
+				int b = std::min((int)((centroids[m_primIndices[i]][axis] - axisMin) * binScale), binCount - 1);
+				bins[b].count++;
+				bins[b].box.extend(bounds[m_primIndices[i]]);
+			}
+		}
+
+		std::vector<float>& leftArea = scratch.leftArea;
+		std::vector<int>& leftCount = scratch.leftCount;
+		leftArea.resize(binCount - 1);
+		leftCount.resize(binCount - 1);
+		BoundingBox acc;
+		int accCount = 0;
+		for (int b = 0; b < binCount - 1; ++b)
+		{
+			acc.extend(bins[b].box);
+			accCount += bins[b].count;
+			leftArea[b] = acc.getSurfaceArea();
+			leftCount[b] = accCount;
+		}
+
+		float parentArea = box.getSurfaceArea();
+		if (parentArea <= 0.f) parentArea = 1.f;
+		float bestCost = FLT_MAX;
+		int bestSplit = -1;
+		acc = BoundingBox();
+		accCount = 0;
+		for (int b = binCount - 1; b > 0; --b)
+		{
+			acc.extend(bins[b].box);
+			accCount += bins[b].count;
+			if (leftCount[b - 1] == 0 || accCount == 0) continue;
+			float cost = BVH_TRAVERSAL_COST + BVH_INTERSECTION_COST *
+				(leftArea[b - 1] * leftCount[b - 1] + acc.getSurfaceArea() * accCount) / parentArea;
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestSplit = b - 1;
+			}
+		}
+
+		float leafCost = BVH_INTERSECTION_COST * count;
+		if (count <= context.maxLeafSize && leafCost <= bestCost) return false;
+
+		if (bestSplit >= 0)
+		{
+			int* split = std::partition(&m_primIndices[start], &m_primIndices[0] + end, [&](int prim)
+			{
+				int b = std::min((int)((centroids[prim][axis] - axisMin) * binScale), binCount - 1);
+				return b <= bestSplit;
+			});
+			mid = split - &m_primIndices[0];
+		}
+	}
+	else if (count <= context.maxLeafSize)
+	{
+		return false;
+	}
+
+	// median splits reach single primitive leaves in log2(count) levels: a child
+	// of more than 2^levels primitives could end up deeper than BVH_MAX_DEPTH
+	int levels = BVH_MAX_DEPTH - depth - 1;
+	long long maxChildCount = (levels >= 62) ? LLONG_MAX : (levels < 0) ? 0 : 1LL << levels;
+	if (mid == start || mid == end || mid - start > maxChildCount || end - mid > maxChildCount)
+	{
+		// centroids can't be separated by the bins or the tree gets too deep, fall back to a median split
+		mid = (start + end) / 2;
+		std::nth_element(&m_primIndices[start], &m_primIndices[mid], &m_primIndices[0] + end, [&](int a, int b)
+		{
+			return centroids[a][axis] < centroids[b][axis];
+		});
+	}
+	return true;
+}
+
+int BVH::buildNode(BVHBuildContext& context, BVHBuildScratch& scratch, int start, int end, int depth, std::vector<BVHNode>& nodes)
+{
+	int nodeIndex = nodes.size();
+	nodes.push_back(BVHNode());
+
+	BoundingBox box;
+	int axis, mid;
+	bool isSplit = splitNode(context, scratch, start, end, depth, box, axis, mid);
+	nodes[nodeIndex].box = box;
+	nodes[nodeIndex].offset = start;
+	nodes[nodeIndex].count = end - start;
+	nodes[nodeIndex].axis = 0;
+	if (!isSplit) return nodeIndex;
+
+	buildNode(context, scratch, start, mid, depth + 1, nodes);
+	int secondChild = buildNode(context, scratch, mid, end, depth + 1, nodes);
+	nodes[nodeIndex].offset = secondChild;
+	nodes[nodeIndex].count = 0;
+	nodes[nodeIndex].axis = axis;
+	return nodeIndex;
+}
+
+void BVH::buildTask(BVHBuildContext& context, int start, int end, int depth, BVHBuildTask& task)
+{
+	BVHBuildScratch scratch;
+	if (end - start < BVH_TASK_MIN_PRIMITIVES)
+	{
+		task.nodes.reserve(2 * (end - start));
+		buildNode(context, scratch, start, end, depth, task.nodes);
+		return;
+	}
+
+	task.nodes.push_back(BVHNode());
+	BVHNode& node = task.nodes[0];
+	int axis, mid;
+	bool isSplit = splitNode(context, scratch, start, end, depth, node.box, axis, mid);
+	node.offset = start;
+	node.count = end - start;
+	node.axis = 0;
+	if (!isSplit) return;
+
+	// the children partition disjoint ranges of the primitive list, they can be built side by side
+	node.count = 0;
+	node.axis = axis;
+	task.children[0].reset(new BVHBuildTask());
+	task.children[1].reset(new BVHBuildTask());
+	context.pool->parallelFor(2, [&](int c)
+	{
+		buildTask(context, (c == 0) ? start : mid, (c == 0) ? mid : end, depth + 1, *task.children[c]);
+	});
+}
+
+int BVH::spliceTask(const BVHBuildTask& task)
+{
+	int base = m_nodes.size();
+	if (task.children[0])
+	{
+		m_nodes.push_back(task.nodes[0]);
+		spliceTask(*task.children[0]);
+		m_nodes[base].offset = spliceTask(*task.children[1]);
+		return base;
+	}
+	// offsets of inner nodes are relative to the task
+	for (unsigned int i = 0; i < task.nodes.size(); ++i)
+	{
+		BVHNode node = task.nodes[i];
+		if (node.count == 0) node.offset += base;
+		m_nodes.push_back(node);
+	}
+	return base;
+}
@@ -0,0 +1,85 @@
+#include "BoundingBox.h"
+#include "Vector4f.h"
+#include "VecUtils.h"
+
+///////////////////////////////////
+// BoundingBox class Implementation
+///////////////////////////////////
+
+BoundingBox::BoundingBox() :
+m_min(FLT_MAX),
+m_max(-FLT_MAX)
+{
+}
+
+BoundingBox::BoundingBox(const Vector3f& min, const Vector3f& max) :
+m_min(min),
+m_max(max)
+{
+}
+
+const Vector3f& BoundingBox::getMin() const
+{
+	return m_min;
+}
+
+const Vector3f& BoundingBox::getMax() const
+{
+	return m_max;
+}
+
+bool BoundingBox::isEmpty() const
+{
+	return m_min[0] > m_max[0] || m_min[1] > m_max[1] || m_min[2] > m_max[2];
+}
+
+void BoundingBox::extend(const Vector3f& p)
+{
+	m_min = VecUtils::min(m_min, p);
+	m_max = VecUtils::max(m_max, p);
+}
+
+void BoundingBox::extend(const BoundingBox& box)
+{
+	if (box.isEmpty()) return;
+	m_min = VecUtils::min(m_min, box.m_min);
+	m_max = VecUtils::max(m_max, box.m_max);
+}
+
+Vector3f BoundingBox::getCenter() const
+{
+	return 0.5f * (m_min + m_max);
+}
+
+Vector3f BoundingBox::getExtent() const
+{
+	return m_max - m_min;
+}
+
+float BoundingBox::getSurfaceArea() const
+{
+	if (isEmpty()) return 0.f;
+	Vector3f e = getExtent();
+	return 2.f * (e[0] * e[1] + e[1] * e[2] + e[2] * e[0]);
+}
+
+int BoundingBox::getLongestAxis() const
+{
+	Vector3f e = getExtent();
+	if (e[0] >= e[1] && e[0] >= e[2]) return 0;
+	return (e[1] >= e[2]) ? 1 : 2;
+}
+
+BoundingBox BoundingBox::transformed(const Matrix4f& m, const BoundingBox& box)
+{
+	BoundingBox out;
+	if (box.isEmpty()) return out;
+	for (int i = 0; i < 8; ++i)
+	{
+		Vector3f corner((i & 1) ? box.m_max[0] : box.m_min[0],
+			(i & 2) ? box.m_max[1] : box.m_min[1],
+			(i & 4) ? box.m_max[2] : box.m_min[2]);
+		out.extend(VecUtils::transformPoint(m, corner));
+	}
+	return out;
+}
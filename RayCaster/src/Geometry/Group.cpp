@@ -1,4 +1,6 @@
 #include "Group.h"
+#include <cassert>
+#include "ThreadPool.h"
 
 /////////////////////////////
 // Group class Implementation
@@ -7,44 +9,170 @@
 /////////////////////////////
 
 Group::Group() :
-m_objects()
+m_objects(),
+m_isBVHDirty(true)
 {
 }
 
 Group::Group(int num_objects) :
-m_objects(num_objects)
+m_objects(num_objects),
+m_isBVHDirty(true)
 {
 }
 
 Group::~Group() 
 {
+	for (unsigned int i = 0; i < m_objects.size(); ++i) {
+		delete m_objects[i];
+	}
 }
 
 bool Group::intersect(const Ray& r, Hit& h, float tmin) 
 { 
+	if (m_isBVHDirty)
+		buildBVH();
+
 	bool isHit = false;
-	for (int i = 0; i < m_objects.size(); ++i) {
-		if(m_objects[i]->intersect(r, h, tmin))
+	RAY_COUNT_TESTS(m_unboundedObjects.size());
+	for (unsigned int i = 0; i < m_unboundedObjects.size(); ++i) {
+		if (m_objects[m_unboundedObjects[i]]->intersect(r, h, tmin))
 			isHit = true;
 	}
+
+	auto intersectObject = [&](int i, float& tmax)
+	{
+		bool objHit = m_objects[m_bvhObjects[i]]->intersect(r, h, tmin);
+		tmax = h.getT();
+		return objHit;
+	};
+	Vector3f dir = r.getDirection().normalized();
+	if (WideBVH::isEnabled() ? m_wideBVH.intersect(r.getOrigin(), dir, tmin, h.getT(), intersectObject)
+		: m_bvh.intersect(r.getOrigin(), dir, tmin, h.getT(), intersectObject))
+		isHit = true;
 	return isHit;
 }
 
+RayMask Group::intersect(RayPacket& packet, RayMask lanes)
+{
+	if (m_isBVHDirty)
+		buildBVH();
+
+	RayMask hitLanes = 0;
+	RAY_COUNT_TESTS(m_unboundedObjects.size());
+	for (unsigned int i = 0; i < m_unboundedObjects.size(); ++i) {
+		hitLanes |= m_objects[m_unboundedObjects[i]]->intersect(packet, lanes);
+	}
+
+	auto intersectObjects = [&](int i, RayMask objLanes)
+	{
+		return m_objects[m_bvhObjects[i]]->intersect(packet, objLanes);
+	};
+	// lanes left alone in a subtree go back to the single ray path
+	auto intersectObject = [&](int i, int lane, float& tmax)
+	{
+		Hit& h = packet.getHit(lane);
+		bool objHit = m_objects[m_bvhObjects[i]]->intersect(packet.getRay(lane), h, packet.getTMin(lane));
+		tmax = h.getT();
+		return objHit;
+	};
+	hitLanes |= m_bvh.intersect(packet, lanes, intersectObjects, intersectObject);
+	return hitLanes;
+}
+
+bool Group::occluded(const Ray& r, float tmin, float tmax)
+{
+	if (m_isBVHDirty)
+		buildBVH();
+
+	RAY_COUNT_TESTS(m_unboundedObjects.size());
+	for (unsigned int i = 0; i < m_unboundedObjects.size(); ++i) {
+		if (m_objects[m_unboundedObjects[i]]->occluded(r, tmin, tmax))
+			return true;
+	}
+
+	auto occludeObject = [&](int i)
+	{
+		return m_objects[m_bvhObjects[i]]->occluded(r, tmin, tmax);
+	};
+	Vector3f dir = r.getDirection().normalized();
+	if (WideBVH::isEnabled())
+		return m_wideBVH.occluded(r.getOrigin(), dir, tmin, tmax, occludeObject);
+	return m_bvh.occluded(r.getOrigin(), dir, tmin, tmax, occludeObject);
+}
+
+bool Group::getBoundingBox(BoundingBox& box) const
+{
+	box = BoundingBox();
+	for (unsigned int i = 0; i < m_objects.size(); ++i) {
+		BoundingBox objBox;
+		if (m_objects[i] == NULL) continue;
+		if (!m_objects[i]->getBoundingBox(objBox))
+			return false;
+		box.extend(objBox);
+	}
+	return true;
+}
+
+void Group::prepare()
+{
+	for (unsigned int i = 0; i < m_objects.size(); ++i) {
+		if (m_objects[i] != NULL)
+			m_objects[i]->prepare();
+	}
+	if (m_isBVHDirty)
+		buildBVH();
+}
+
+void Group::buildBVH()
+{
+	// the BVH only knows bounded objects, the other ones are tested separately
+	std::vector<BoundingBox> bounds(m_objects.size());
+	std::vector<bool> isBounded(m_objects.size(), false);
+	m_unboundedObjects.clear();
+	for (unsigned int i = 0; i < m_objects.size(); ++i) {
+		if (m_objects[i] == NULL) continue;
+		isBounded[i] = m_objects[i]->getBoundingBox(bounds[i]);
+		if (!isBounded[i])
+			m_unboundedObjects.push_back(i);
+	}
+
+	std::vector<BoundingBox> bvhBounds;
+	m_bvhObjects.clear();
+	for (unsigned int i = 0; i < m_objects.size(); ++i) {
+		if (isBounded[i]) {
+			bvhBounds.push_back(bounds[i]);
+			m_bvhObjects.push_back(i);
+		}
+	}
+	BVHBuildSettings settings;
+	settings.maxLeafSize = 1;
+	settings.pool = &ThreadPool::getGlobal();
+	m_bvh.build(bvhBounds, settings);
+	m_wideBVH.build(m_bvh);
+	m_isBVHDirty = false;
+}
+
 void Group::addObject(Object3D* obj) 
 {
 	m_objects.push_back(obj);
+	m_isBVHDirty = true;
 }
 
 void Group::modifyObject(int i, Object3D * object)
 {
 	assert(i >= 0 && i < m_objects.size());
+	if (m_objects[i] != object)
+		delete m_objects[i];
 	m_objects[i] = object;
+	m_isBVHDirty = true;
 }
 
 void Group::removeObject(int i)
 {
 	assert(i >= 0 && i < m_objects.size());
+	delete m_objects[i];
 	m_objects.erase(m_objects.begin() + i);
+	m_isBVHDirty = true;
 }
 
 int Group::getGroupSize() 
@@ -56,4 +184,4 @@ Object3D* Group::getObject(int i) const
 {
 	assert(i >= 0 && i < m_objects.size());
 	return m_objects[i];
-}
\ No newline at end of file
+}
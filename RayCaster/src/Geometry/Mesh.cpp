@@ -1,10 +1,4 @@
 #include "Mesh.h"
-#include <fstream>
-#include <iostream>
-#include <algorithm>
-#include <cstdlib>
-#include <utility>
-#include <sstream>
 
 ///////////////////////////
 // Mesh Implementation
@@ -12,117 +6,90 @@
 // Nicolas Bordes - 10/2016
 ///////////////////////////
 bool Mesh::intersect(const Ray& r, Hit& h, float tmin) {
-	bool result = false;
-	for (unsigned int i = 0; i < t.size(); i++) {
-		Triangle triangle(v[t[i][0]],
-			v[t[i][1]], v[t[i][2]], m_material);
-		for (int jj = 0;jj<3;jj++) {
-			triangle.normals[jj] = n[t[i][jj]];
+	return intersect(r, h, tmin, NULL);
+}
 
+bool Mesh::intersect(const Ray& r, Hit& h, float tmin, BVHStats* stats) {
+	if (!m_geometry) {
+		return false;
+	}
+	TriangleHit closest;
+	closest.t = h.getT();
+	if (!m_geometry->intersect(Ray(r.getOrigin(), r.getDirection().normalized()), tmin, closest, stats)) {
+		return false;
+	}
+	m_geometry->setHit(closest, m_material, r, h);
+	return true;
+}
+
+RayMask Mesh::intersect(RayPacket& packet, RayMask lanes) {
+	if (!m_geometry) {
+		return 0;
+	}
+	TriangleHit closest[RAY_PACKET_SIZE];
+	for (int i = 0; i < RAY_PACKET_SIZE; i++) {
+		if ((lanes >> i) & 1) {
+			closest[i].t = packet.getTMax(i);
 		}
-		if (texCoord.size()>0) {
-			for (int jj = 0;jj<3;jj++) {
-				triangle.texCoords[jj] = texCoord[t[i].texID[jj]];
-			}
-			triangle.hasTex = true;
+	}
+	RayMask hitLanes = m_geometry->intersect(packet, lanes, closest);
+	for (int i = 0; i < RAY_PACKET_SIZE; i++) {
+		if ((hitLanes >> i) & 1) {
+			m_geometry->setHit(closest[i], m_material, packet.getRay(i), packet.getHit(i));
 		}
-		result |= triangle.intersect(r, h, tmin);
 	}
-	return result;
+	return hitLanes;
 }
 
-Mesh::Mesh(const char * filename, Material * material) :Object3D(material)
-{
-	std::ifstream f;
-	f.open(filename);
-	if (!f.is_open()) {
-		std::cout << "Cannot open " << filename << "\n";
-		return;
+bool Mesh::occluded(const Ray& r, float tmin, float tmax) {
+	if (!m_geometry) {
+		return false;
 	}
+	return m_geometry->occluded(Ray(r.getOrigin(), r.getDirection().normalized()), tmin, tmax);
+}
 
-	m_filename = std::string(filename, strlen(filename));
-
-	std::string line;
-	std::string vTok("v");
-	std::string fTok("f");
-	std::string texTok("vt");
-	char bslash = '/', space = ' ';
-	std::string tok;
-	while (1) {
-		std::getline(f, line);
-		if (f.eof()) {
-			break;
-		}
-		if (line.size()<3) {
-			continue;
-		}
-		if (line.at(0) == '#') {
-			continue;
-		}
-		std::stringstream ss(line);
-		ss >> tok;
-		if (tok == vTok) {
-			Vector3f vec;
-			ss >> vec[0] >> vec[1] >> vec[2];
-			v.push_back(vec);
-		}
-		else if (tok == fTok) {
-			if (line.find(bslash) != std::string::npos) {
-				std::replace(line.begin(), line.end(), bslash, space);
-				std::stringstream facess(line);
-				Trig trig;
-				facess >> tok;
-				for (int ii = 0; ii<3; ii++) {
-					facess >> trig[ii] >> trig.texID[ii];
-					trig[ii]--;
-					trig.texID[ii]--;
-				}
-				t.push_back(trig);
-			}
-			else {
-				Trig trig;
-				for (int ii = 0; ii<3; ii++) {
-					ss >> trig[ii];
-					trig[ii]--;
-					trig.texID[ii] = 0;
-				}
-				t.push_back(trig);
-			}
-		}
-		else if (tok == texTok) {
-			Vector2f texcoord;
-			ss >> texcoord[0];
-			ss >> texcoord[1];
-			texCoord.push_back(texcoord);
-		}
+bool Mesh::intersectBruteForce(const Ray& r, Hit& h, float tmin, BVHStats* stats) {
+	if (!m_geometry) {
+		return false;
 	}
-	compute_norm();
+	TriangleHit closest;
+	closest.t = h.getT();
+	if (!m_geometry->intersectBruteForce(Ray(r.getOrigin(), r.getDirection().normalized()), tmin, closest, stats)) {
+		return false;
+	}
+	m_geometry->setHit(closest, m_material, r, h);
+	return true;
+}
 
-	f.close();
-	
+Mesh::Mesh(const char * filename, Material * material) :Object3D(material),
+m_geometry(MeshGeometry::load(filename))
+{
+}
+
+Mesh::Mesh(const std::shared_ptr<const MeshGeometry>& geometry, Material * material) :Object3D(material),
+m_geometry(geometry)
+{
 }
 
 Mesh::~Mesh()
 {
 }
 
-void Mesh::compute_norm()
+bool Mesh::getBoundingBox(BoundingBox& box) const
 {
-	n.resize(v.size());
-	for (unsigned int ii = 0; ii<t.size(); ii++) {
-		Vector3f a = v[t[ii][1]] - v[t[ii][0]];
-		Vector3f b = v[t[ii][2]] - v[t[ii][0]];
-		b = Vector3f::cross(a, b);
-		for (int jj = 0; jj<3; jj++) {
-			n[t[ii][jj]] += b;
-		}
-	}
-	for (unsigned int ii = 0; ii<v.size(); ii++) {
-		n[ii] = n[ii] / n[ii].abs();
+	if (!m_geometry) {
+		return false;
 	}
+	box = m_geometry->getBoundingBox();
+	return true;
 }
 
 std::string Mesh::getFilename() const
 {
-	return m_filename;
+	return m_geometry ? m_geometry->getFilename() : std::string();
+}
+
+const std::shared_ptr<const MeshGeometry>& Mesh::getGeometry() const
+{
+	return m_geometry;
 }
@@ -0,0 +1,753 @@
+#include "MeshGeometry.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+#include "ObjLoader.h"
+#include "ThreadPool.h"
+
+///////////////////////////////////
+// MeshGeometry Implementation
+///////////////////////////////////
+
+// sections of the binary cache, each one starts on a MESH_CACHE_ALIGNMENT boundary
+enum MeshCacheSection {
+	MESH_CACHE_VERTICES,
+	MESH_CACHE_NORMALS,
+	MESH_CACHE_TRIANGLES,
+	MESH_CACHE_TEXCOORDS,
+	MESH_CACHE_TRIANGLE_RECORDS,
+	MESH_CACHE_BVH_NODES,
+	MESH_CACHE_BVH_PRIMITIVES,
+	MESH_CACHE_SECTION_COUNT
+};
+
+#define MESH_CACHE_MAGIC "RCMESH\0\0"
+#define MESH_CACHE_ALIGNMENT 64
+#define MESH_CACHE_NAME_SIZE 256
+
+// the arrays are stored in memory layout: the cache is only valid for the
+// platform that wrote it, which the size and byte order fields check
+struct MeshCacheHeader {
+	char magic[8];
+	unsigned int version;
+	unsigned int byteOrder;
+	unsigned int trigSize;
+	unsigned int nodeSize;
+	// key: the cache sits beside the source, which gives the directory,
+	// the name catches a renamed or copied source, size and time an edited one
+	char sourceName[MESH_CACHE_NAME_SIZE];
+	unsigned long long sourceSize;
+	long long sourceTime;
+	// and the BVH built from it
+	int bvhBinCount;
+	int bvhLeafSize;
+	int vertexCount;
+	int triangleCount;
+	int texCoordCount;
+	int nodeCount;
+	int primitiveCount;
+	unsigned long long offsets[MESH_CACHE_SECTION_COUNT];
+	unsigned long long sizes[MESH_CACHE_SECTION_COUNT];
+	unsigned long long fileSize;
+};
+
+static std::atomic<bool> s_isCacheEnabled(true);
+static std::mutex s_bvhSettingsMutex;
+static BVHBuildSettings s_bvhSettings;
+static bool s_isBVHPoolSet = false;
+
+static std::string getCacheFilename(const char * filename)
+{
+	return std::string(filename) + MESH_CACHE_EXTENSION;
+}
+
+// unique per process and call: processes sharing an asset directory, or threads
+// loading the same file, never write into the same temporary file
+static std::string getTemporaryFilename(const std::string& cacheFilename)
+{
+	static std::atomic<unsigned int> s_counter(0);
+#ifdef _WIN32
+	int pid = _getpid();
+#else
+	int pid = (int)getpid();
+#endif
+	return cacheFilename + "." + std::to_string(pid) + "." + std::to_string(s_counter++) + ".tmp";
+}
+
+static const char * getBaseName(const char * filename)
+{
+	const char * name = filename;
+	for (const char * c = filename; *c; c++) {
+		if (*c == '/' || *c == '\\') {
+			name = c + 1;
+		}
+	}
+	return name;
+}
+
+// header of the cache that filename should have, without the section layout
+static bool makeCacheKey(const char * filename, MeshCacheHeader& header)
+{
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+	header.version = MESH_CACHE_VERSION;
+	header.byteOrder = 0x01020304;
+	header.trigSize = sizeof(Trig);
+	header.nodeSize = sizeof(BVHNode);
+	strncpy(header.sourceName, getBaseName(filename), MESH_CACHE_NAME_SIZE - 1);
+	BVHBuildSettings settings = MeshGeometry::getBVHBuildSettings();
+	header.bvhBinCount = settings.binCount;
+	header.bvhLeafSize = settings.maxLeafSize;
+	return MappedFile::getFileStatus(filename, header.sourceSize, header.sourceTime);
+}
+
+// indices of a mapped cache in range, so a damaged file can't send shading or traversal out of its arrays:
+// children after their parent (no cycle), no leaf deeper than the traversal stacks, primitives in the list
+static bool isCacheConsistent(const Trig * t, int triangleCount, int vertexCount, int texCoordCount,
+	const BVHNode * nodes, int nodeCount, const int * primIndices, int primitiveCount)
+{
+	for (int ii = 0; ii < triangleCount; ii++) {
+		for (int kk = 0; kk < 3; kk++) {
+			if (t[ii].x[kk] < 0 || t[ii].x[kk] >= vertexCount) {
+				return false;
+			}
+			// texture coordinates are only looked up when there are some
+			if (texCoordCount > 0 && (t[ii].texID[kk] < 0 || t[ii].texID[kk] >= texCoordCount)) {
+				return false;
+			}
+		}
+	}
+	for (int ii = 0; ii < primitiveCount; ii++) {
+		if (primIndices[ii] < 0 || primIndices[ii] >= triangleCount) {
+			return false;
+		}
+	}
+	std::vector<unsigned char> depth(nodeCount, 0);
+	for (int ii = 0; ii < nodeCount; ii++) {
+		const BVHNode& node = nodes[ii];
+		if (node.count > 0) {
+			if (node.offset < 0 || node.offset > primitiveCount - node.count) {
+				return false;
+			}
+			continue;
+		}
+		if (node.count < 0 || node.axis < 0 || node.axis > 2 || depth[ii] >= BVH_MAX_DEPTH
+			|| ii + 1 >= nodeCount || node.offset <= ii + 1 || node.offset >= nodeCount) {
+			return false;
+		}
+		depth[ii + 1] = std::max(depth[ii + 1], (unsigned char)(depth[ii] + 1));
+		depth[node.offset] = std::max(depth[node.offset], (unsigned char)(depth[ii] + 1));
+	}
+	return true;
+}
+
+void MeshGeometry::setCacheEnabled(bool isEnabled)
+{
+	s_isCacheEnabled = isEnabled;
+}
+
+bool MeshGeometry::isCacheEnabled()
+{
+	return s_isCacheEnabled;
+}
+
+void MeshGeometry::setBVHBuildSettings(const BVHBuildSettings& settings)
+{
+	std::lock_guard<std::mutex> lock(s_bvhSettingsMutex);
+	s_bvhSettings = settings;
+	s_isBVHPoolSet = true;
+}
+
+BVHBuildSettings MeshGeometry::getBVHBuildSettings()
+{
+	std::lock_guard<std::mutex> lock(s_bvhSettingsMutex);
+	if (!s_isBVHPoolSet) {
+		// the global pool is only created once a mesh needs it
+		s_bvhSettings.pool = &ThreadPool::getGlobal();
+		s_isBVHPoolSet = true;
+	}
+	return s_bvhSettings;
+}
+
+std::shared_ptr<const MeshGeometry> MeshGeometry::load(const char * filename)
+{
+	typedef std::shared_ptr<const MeshGeometry> GeometryPtr;
+	// weak references only: the geometry is freed with its last instance.
+	// pending is set while a thread loads the file, the other callers wait for its result
+	// instead of loading it again, the lock is never held during a parse or a BVH build
+	struct LoadedEntry {
+		std::weak_ptr<const MeshGeometry> geometry;
+		std::shared_future<GeometryPtr> pending;
+	};
+	static std::map<std::string, LoadedEntry> loaded;
+	static std::mutex loadedMutex;
+
+	unsigned long long fileSize = 0;
+	long long fileTime = 0;
+	MappedFile::getFileStatus(filename, fileSize, fileTime);
+
+	GeometryPtr geometry;
+	std::promise<GeometryPtr> result;
+	for (;;) {
+		std::shared_future<GeometryPtr> pending;
+		{
+			std::lock_guard<std::mutex> lock(loadedMutex);
+			LoadedEntry& entry = loaded[filename];
+			geometry = entry.geometry.lock();
+			if (geometry && geometry->m_fileSize == fileSize && geometry->m_fileTime == fileTime) {
+				return geometry;
+			}
+			if (!entry.pending.valid()) {
+				entry.pending = result.get_future().share();
+				break;
+			}
+			pending = entry.pending;
+		}
+		geometry = pending.get();
+		// a failed load isn't tried again, a file changed since the other load started is
+		if (!geometry || (geometry->m_fileSize == fileSize && geometry->m_fileTime == fileTime)) {
+			return geometry;
+		}
+	}
+
+	MeshGeometry* newGeometry = new MeshGeometry(filename);
+	newGeometry->m_fileSize = fileSize;
+	newGeometry->m_fileTime = fileTime;
+	if (newGeometry->loadCache(filename) || newGeometry->loadObj(filename)) {
+		geometry = GeometryPtr(newGeometry);
+	} else {
+		delete newGeometry;
+		geometry = GeometryPtr();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(loadedMutex);
+		LoadedEntry& entry = loaded[filename];
+		entry.geometry = geometry;
+		entry.pending = std::shared_future<GeometryPtr>();
+		// forget the files whose last instance is gone, including this one if it failed
+		for (std::map<std::string, LoadedEntry>::iterator it = loaded.begin(); it != loaded.end();) {
+			if (it->second.geometry.expired() && !it->second.pending.valid()) {
+				it = loaded.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+	result.set_value(geometry);
+	return geometry;
+}
+
+MeshGeometry::MeshGeometry(const char * filename) :
+m_filename(filename),
+m_fileSize(0),
+m_fileTime(0),
+m_v(NULL),
+m_t(NULL),
+m_n(NULL),
+m_texCoord(NULL),
+m_vertexCount(0),
+m_triangleCount(0),
+m_texCoordCount(0)
+{
+	for (int kk = 0; kk < 3; kk++) {
+		m_triV0[kk] = NULL;
+		m_triEdge1[kk] = NULL;
+		m_triEdge2[kk] = NULL;
+	}
+}
+
+MeshGeometry::~MeshGeometry()
+{
+}
+
+const std::string& MeshGeometry::getFilename() const
+{
+	return m_filename;
+}
+
+int MeshGeometry::getVertexCount() const
+{
+	return m_vertexCount;
+}
+
+int MeshGeometry::getTriangleCount() const
+{
+	return m_triangleCount;
+}
+
+int MeshGeometry::getTexCoordCount() const
+{
+	return m_texCoordCount;
+}
+
+const Vector3f* MeshGeometry::getVertices() const
+{
+	return m_v;
+}
+
+const Vector3f* MeshGeometry::getNormals() const
+{
+	return m_n;
+}
+
+const Trig* MeshGeometry::getTriangles() const
+{
+	return m_t;
+}
+
+const Vector2f* MeshGeometry::getTexCoords() const
+{
+	return m_texCoord;
+}
+
+const BoundingBox& MeshGeometry::getBoundingBox() const
+{
+	return m_box;
+}
+
+const BVH& MeshGeometry::getBVH() const
+{
+	return m_bvh;
+}
+
+const WideBVH& MeshGeometry::getWideBVH() const
+{
+	return m_wideBVH;
+}
+
+bool MeshGeometry::isFromCache() const
+{
+	return m_cacheFile.isOpen();
+}
+
+bool MeshGeometry::intersect(const Ray& r, float tmin, TriangleHit& hit, BVHStats* stats) const {
+	const Vector3f& dirN = r.getDirection();
+	float orig[3] = { r.getOrigin()[0], r.getOrigin()[1], r.getOrigin()[2] };
+	float dir[3] = { dirN[0], dirN[1], dirN[2] };
+	// traversal only keeps t, barycentrics and the triangle id,
+	// normal and texture coordinates are interpolated once for the closest hit
+	auto intersectPrim = [&](int i, float& tmax) {
+		float tHit, u, v;
+		if (!intersectTriangle(i, orig, dir, tmin, tmax, tHit, u, v)) {
+			return false;
+		}
+		hit.t = tHit;
+		hit.u = u;
+		hit.v = v;
+		hit.triangle = i;
+		tmax = tHit;
+		return true;
+	};
+	if (WideBVH::isEnabled()) {
+		return m_wideBVH.intersect(r.getOrigin(), dirN, tmin, hit.t, intersectPrim, stats);
+	}
+	return m_bvh.intersect(r.getOrigin(), dirN, tmin, hit.t, intersectPrim, stats);
+}
+
+bool MeshGeometry::occluded(const Ray& r, float tmin, float tmax, BVHStats* stats) const {
+	const Vector3f& dirN = r.getDirection();
+	float orig[3] = { r.getOrigin()[0], r.getOrigin()[1], r.getOrigin()[2] };
+	float dir[3] = { dirN[0], dirN[1], dirN[2] };
+	auto occludePrim = [&](int i) {
+		float tHit, u, v;
+		return intersectTriangle(i, orig, dir, tmin, tmax, tHit, u, v);
+	};
+	if (WideBVH::isEnabled()) {
+		return m_wideBVH.occluded(r.getOrigin(), dirN, tmin, tmax, occludePrim, stats);
+	}
+	return m_bvh.occluded(r.getOrigin(), dirN, tmin, tmax, occludePrim, stats);
+}
+
+RayMask MeshGeometry::intersect(RayPacket& packet, RayMask lanes, TriangleHit* hits) const {
+	auto intersectPrims = [&](int i, RayMask primLanes) {
+		RayMask hitLanes = 0;
+		for (int g = 0; g < RAY_PACKET_GROUPS; ++g) {
+			unsigned int groupLanes = RayPacket::getGroupLanes(primLanes, g);
+			if (groupLanes == 0) {
+				continue;
+			}
+			RayPacket::Floats t, u, v;
+			unsigned int groupHits = intersectTriangle(i, packet, g, t, u, v) & groupLanes;
+			if (groupHits == 0) {
+				continue;
+			}
+			float tHit[RAY_PACKET_WIDTH], uHit[RAY_PACKET_WIDTH], vHit[RAY_PACKET_WIDTH];
+			t.store(tHit);
+			u.store(uHit);
+			v.store(vHit);
+			for (int k = 0; k < RAY_PACKET_WIDTH; ++k) {
+				if (((groupHits >> k) & 1) == 0) {
+					continue;
+				}
+				int lane = g * RAY_PACKET_WIDTH + k;
+				hits[lane].t = tHit[k];
+				hits[lane].u = uHit[k];
+				hits[lane].v = vHit[k];
+				hits[lane].triangle = i;
+				packet.setTMax(lane, tHit[k]);
+			}
+			hitLanes |= (RayMask)groupHits << (g * RAY_PACKET_WIDTH);
+		}
+		return hitLanes;
+	};
+	auto intersectPrim = [&](int i, int lane, float& tmax) {
+		Vector3f o = packet.getOrigin(lane);
+		Vector3f d = packet.getUnitDirection(lane);
+		float orig[3] = { o[0], o[1], o[2] };
+		float dir[3] = { d[0], d[1], d[2] };
+		float tHit, u, v;
+		if (!intersectTriangle(i, orig, dir, packet.getTMin(lane), tmax, tHit, u, v)) {
+			return false;
+		}
+		hits[lane].t = tHit;
+		hits[lane].u = u;
+		hits[lane].v = v;
+		hits[lane].triangle = i;
+		tmax = tHit;
+		return true;
+	};
+	return m_bvh.intersect(packet, lanes, intersectPrims, intersectPrim);
+}
+
+bool MeshGeometry::intersectBruteForce(const Ray& r, float tmin, TriangleHit& hit, BVHStats* stats) const {
+	const Vector3f& dirN = r.getDirection();
+	float orig[3] = { r.getOrigin()[0], r.getOrigin()[1], r.getOrigin()[2] };
+	float dir[3] = { dirN[0], dirN[1], dirN[2] };
+	bool isHit = false;
+	for (int i = 0; i < m_triangleCount; i++) {
+		float tHit, u, v;
+		if (intersectTriangle(i, orig, dir, tmin, hit.t, tHit, u, v)) {
+			hit.t = tHit;
+			hit.u = u;
+			hit.v = v;
+			hit.triangle = i;
+			isHit = true;
+		}
+	}
+	if (stats) {
+		stats->primitiveTests += m_triangleCount;
+	}
+	RAY_COUNT_TESTS(m_triangleCount);
+	return isHit;
+}
+
+bool MeshGeometry::intersectTriangle(int i, const float orig[3], const float dir[3], float tmin, float tmax, float& tHit, float& u, float& v) const {
+	float e1x = m_triEdge1[0][i], e1y = m_triEdge1[1][i], e1z = m_triEdge1[2][i];
+	float e2x = m_triEdge2[0][i], e2y = m_triEdge2[1][i], e2z = m_triEdge2[2][i];
+
+	// p = dir x e2
+	float px = dir[1] * e2z - dir[2] * e2y;
+	float py = dir[2] * e2x - dir[0] * e2z;
+	float pz = dir[0] * e2y - dir[1] * e2x;
+	float det = e1x * px + e1y * py + e1z * pz;
+	if (det == 0.f) {
+		return false; // ray parallel to the triangle plane
+	}
+	float invDet = 1.f / det;
+
+	float sx = orig[0] - m_triV0[0][i];
+	float sy = orig[1] - m_triV0[1][i];
+	float sz = orig[2] - m_triV0[2][i];
+	u = (sx * px + sy * py + sz * pz) * invDet;
+	if (u < 0.f || u > 1.f) {
+		return false;
+	}
+
+	// q = s x e1
+	float qx = sy * e1z - sz * e1y;
+	float qy = sz * e1x - sx * e1z;
+	float qz = sx * e1y - sy * e1x;
+	v = (dir[0] * qx + dir[1] * qy + dir[2] * qz) * invDet;
+	if (v < 0.f || u + v > 1.f) {
+		return false;
+	}
+
+	tHit = (e2x * qx + e2y * qy + e2z * qz) * invDet;
+	return tHit >= tmin && tHit < tmax;
+}
+
+unsigned int MeshGeometry::intersectTriangle(int i, const RayPacket& packet, int g, RayPacket::Floats& tHit, RayPacket::Floats& u, RayPacket::Floats& v) const {
+	typedef RayPacket::Floats Floats;
+	float e1x = m_triEdge1[0][i], e1y = m_triEdge1[1][i], e1z = m_triEdge1[2][i];
+	float e2x = m_triEdge2[0][i], e2y = m_triEdge2[1][i], e2z = m_triEdge2[2][i];
+	RayPacket::Vectors orig = packet.getOrigins(g);
+	RayPacket::Vectors dir = packet.getUnitDirections(g);
+
+	// p = dir x e2
+	Floats px = dir[1] * e2z - dir[2] * e2y;
+	Floats py = dir[2] * e2x - dir[0] * e2z;
+	Floats pz = dir[0] * e2y - dir[1] * e2x;
+	Floats det = e1x * px + e1y * py + e1z * pz;
+	Floats invDet = 1.f / det;
+
+	Floats sx = orig[0] - m_triV0[0][i];
+	Floats sy = orig[1] - m_triV0[1][i];
+	Floats sz = orig[2] - m_triV0[2][i];
+	u = (sx * px + sy * py + sz * pz) * invDet;
+
+	// q = s x e1
+	Floats qx = sy * e1z - sz * e1y;
+	Floats qy = sz * e1x - sx * e1z;
+	Floats qz = sx * e1y - sy * e1x;
+	v = (dir[0] * qx + dir[1] * qy + dir[2] * qz) * invDet;
+	tHit = (e2x * qx + e2y * qy + e2z * qz) * invDet;
+
+	// the early outs of the single ray test, which let NaN barycentrics through the same way
+	Floats zero(0.f), one(1.f);
+	RayPacket::Mask miss = (det == zero) | (u < zero) | (u > one) | (v < zero) | (u + v > one);
+	RayPacket::Mask hit = (tHit >= packet.getTMins(g)) & (tHit < packet.getTMaxes(g));
+	return hit.getBits() & ~miss.getBits();
+}
+
+bool MeshGeometry::getPlaneBarycentrics(int i, const Vector3f& orig, const Vector3f& dir, float& u, float& v) const {
+	// intersectTriangle without the bounds: the offset rays may miss the triangle itself
+	Vector3f e1(m_triEdge1[0][i], m_triEdge1[1][i], m_triEdge1[2][i]);
+	Vector3f e2(m_triEdge2[0][i], m_triEdge2[1][i], m_triEdge2[2][i]);
+	Vector3f p = Vector3f::cross(dir, e2);
+	float det = Vector3f::dot(e1, p);
+	if (det == 0.f) {
+		return false;
+	}
+	Vector3f s = orig - Vector3f(m_triV0[0][i], m_triV0[1][i], m_triV0[2][i]);
+	Vector3f q = Vector3f::cross(s, e1);
+	u = Vector3f::dot(s, p) / det;
+	v = Vector3f::dot(dir, q) / det;
+	return true;
+}
+
+void MeshGeometry::setHit(const TriangleHit& triHit, Material* material, const Ray& r, Hit& h) const {
+	const Trig& trig = m_t[triHit.triangle];
+	float u = triHit.u, v = triHit.v;
+	float w = 1 - u - v;
+	h.set(triHit.t, material, w * m_n[trig.x[0]] + u * m_n[trig.x[1]] + v * m_n[trig.x[2]]);
+	if (m_texCoordCount > 0) {
+		const Vector2f& t0 = m_texCoord[trig.texID[0]];
+		const Vector2f& t1 = m_texCoord[trig.texID[1]];
+		const Vector2f& t2 = m_texCoord[trig.texID[2]];
+		h.setTexCoord(w * t0 + u * t1 + v * t2);
+		// the texture coordinates are affine on the triangle plane: the footprint
+		// of a pixel is the change of barycentrics where its neighbours cross that plane
+		float ux, vx, uy, vy;
+		if (r.hasDifferentials()
+			&& getPlaneBarycentrics(triHit.triangle, r.getDxOrigin(), r.getDxDirection(), ux, vx)
+			&& getPlaneBarycentrics(triHit.triangle, r.getDyOrigin(), r.getDyDirection(), uy, vy)) {
+			h.setTexCoordDifferentials((ux - u) * (t1 - t0) + (vx - v) * (t2 - t0), (uy - u) * (t1 - t0) + (vy - v) * (t2 - t0));
+		}
+	}
+}
+
+bool MeshGeometry::loadObj(const char * filename)
+{
+	if (!ObjLoader::load(filename, v, texCoord, t)) {
+		std::cout << "Cannot open " << filename << "\n";
+		return false;
+	}
+	compute_norm();
+	buildTriangleRecords();
+	buildBVH();
+	useParsedArrays();
+	if (s_isCacheEnabled) {
+		writeCache(filename);
+	}
+	return true;
+}
+
+void MeshGeometry::useParsedArrays()
+{
+	m_v = v.data();
+	m_t = t.data();
+	m_n = n.data();
+	m_texCoord = texCoord.data();
+	m_vertexCount = v.size();
+	m_triangleCount = t.size();
+	m_texCoordCount = texCoord.size();
+	const float * records = m_triRecords.data();
+	for (int kk = 0; kk < 3; kk++) {
+		m_triV0[kk] = records + kk * m_triangleCount;
+		m_triEdge1[kk] = records + (3 + kk) * m_triangleCount;
+		m_triEdge2[kk] = records + (6 + kk) * m_triangleCount;
+	}
+}
+
+bool MeshGeometry::loadCache(const char * filename)
+{
+	MeshCacheHeader key;
+	if (!s_isCacheEnabled || !makeCacheKey(filename, key)) {
+		return false;
+	}
+	// traversal reads the arrays in any order, sequential read-ahead would fetch and drop pages for nothing
+	if (!m_cacheFile.open(getCacheFilename(filename).c_str(), MAPPED_FILE_NORMAL)) {
+		return false;
+	}
+	const char * data = m_cacheFile.getData();
+	size_t size = m_cacheFile.getSize();
+	bool isValid = size >= sizeof(MeshCacheHeader);
+	MeshCacheHeader header;
+	if (isValid) {
+		memcpy(&header, data, sizeof(header));
+		isValid = memcmp(&header, &key, offsetof(MeshCacheHeader, vertexCount)) == 0 && header.fileSize == size;
+	}
+	if (isValid) {
+		unsigned long long expected[MESH_CACHE_SECTION_COUNT] = {
+			header.vertexCount * sizeof(Vector3f),
+			header.vertexCount * sizeof(Vector3f),
+			header.triangleCount * sizeof(Trig),
+			header.texCoordCount * sizeof(Vector2f),
+			header.triangleCount * 9 * sizeof(float),
+			header.nodeCount * sizeof(BVHNode),
+			header.primitiveCount * sizeof(int)
+		};
+		for (int ii = 0; ii < MESH_CACHE_SECTION_COUNT && isValid; ii++) {
+			isValid = header.sizes[ii] == expected[ii] && header.offsets[ii] % MESH_CACHE_ALIGNMENT == 0
+				&& header.offsets[ii] <= size && header.sizes[ii] <= size - header.offsets[ii];
+		}
+		isValid = isValid && header.vertexCount >= 0 && header.triangleCount >= 0 && header.texCoordCount >= 0
+			&& header.nodeCount >= 0 && header.primitiveCount == header.triangleCount;
+	}
+	// one pass over the indices and nodes, the vertices and triangle records are paged in by the first rays
+	isValid = isValid && isCacheConsistent((const Trig*)(data + header.offsets[MESH_CACHE_TRIANGLES]), header.triangleCount,
+		header.vertexCount, header.texCoordCount, (const BVHNode*)(data + header.offsets[MESH_CACHE_BVH_NODES]), header.nodeCount,
+		(const int*)(data + header.offsets[MESH_CACHE_BVH_PRIMITIVES]), header.primitiveCount);
+	if (!isValid) {
+		m_cacheFile.close();
+		return false;
+	}
+
+	m_v = (const Vector3f*)(data + header.offsets[MESH_CACHE_VERTICES]);
+	m_n = (const Vector3f*)(data + header.offsets[MESH_CACHE_NORMALS]);
+	m_t = (const Trig*)(data + header.offsets[MESH_CACHE_TRIANGLES]);
+	m_texCoord = (const Vector2f*)(data + header.offsets[MESH_CACHE_TEXCOORDS]);
+	m_vertexCount = header.vertexCount;
+	m_triangleCount = header.triangleCount;
+	m_texCoordCount = header.texCoordCount;
+	const float * records = (const float*)(data + header.offsets[MESH_CACHE_TRIANGLE_RECORDS]);
+	for (int kk = 0; kk < 3; kk++) {
+		m_triV0[kk] = records + kk * m_triangleCount;
+		m_triEdge1[kk] = records + (3 + kk) * m_triangleCount;
+		m_triEdge2[kk] = records + (6 + kk) * m_triangleCount;
+	}
+	m_bvh.attach((const BVHNode*)(data + header.offsets[MESH_CACHE_BVH_NODES]), header.nodeCount,
+		(const int*)(data + header.offsets[MESH_CACHE_BVH_PRIMITIVES]), header.primitiveCount);
+	// not cached: collapsing reads each node once, far less than building
+	m_wideBVH.build(m_bvh);
+	m_box = m_bvh.getBounds();
+	return true;
+}
+
+void MeshGeometry::writeCache(const char * filename) const
+{
+	MeshCacheHeader header;
+	if (!makeCacheKey(filename, header)) {
+		return;
+	}
+	header.vertexCount = m_vertexCount;
+	header.triangleCount = m_triangleCount;
+	header.texCoordCount = m_texCoordCount;
+	header.nodeCount = m_bvh.getNodeCount();
+	header.primitiveCount = m_bvh.getPrimitiveCount();
+	const void * sections[MESH_CACHE_SECTION_COUNT] = {
+		m_v, m_n, m_t, m_texCoord, m_triRecords.data(), m_bvh.getNodes(), m_bvh.getPrimitiveIndices()
+	};
+	header.sizes[MESH_CACHE_VERTICES] = m_vertexCount * sizeof(Vector3f);
+	header.sizes[MESH_CACHE_NORMALS] = m_vertexCount * sizeof(Vector3f);
+	header.sizes[MESH_CACHE_TRIANGLES] = m_triangleCount * sizeof(Trig);
+	header.sizes[MESH_CACHE_TEXCOORDS] = m_texCoordCount * sizeof(Vector2f);
+	header.sizes[MESH_CACHE_TRIANGLE_RECORDS] = m_triRecords.size() * sizeof(float);
+	header.sizes[MESH_CACHE_BVH_NODES] = header.nodeCount * sizeof(BVHNode);
+	header.sizes[MESH_CACHE_BVH_PRIMITIVES] = header.primitiveCount * sizeof(int);
+	unsigned long long offset = sizeof(MeshCacheHeader);
+	for (int ii = 0; ii < MESH_CACHE_SECTION_COUNT; ii++) {
+		offset = (offset + MESH_CACHE_ALIGNMENT - 1) / MESH_CACHE_ALIGNMENT * MESH_CACHE_ALIGNMENT;
+		header.offsets[ii] = offset;
+		offset += header.sizes[ii];
+	}
+	header.fileSize = offset;
+
+	// written under a temporary name and renamed, so a reader never maps a partial file
+	std::string cacheFilename = getCacheFilename(filename);
+	std::string tmpFilename = getTemporaryFilename(cacheFilename);
+	FILE * file = fopen(tmpFilename.c_str(), "wb");
+	if (file == NULL) {
+		return; // read-only asset directory: the mesh is parsed every time
+	}
+	static const char padding[MESH_CACHE_ALIGNMENT] = { 0 };
+	bool isWritten = fwrite(&header, sizeof(header), 1, file) == 1;
+	unsigned long long position = sizeof(header);
+	for (int ii = 0; ii < MESH_CACHE_SECTION_COUNT && isWritten; ii++) {
+		isWritten = fwrite(padding, 1, header.offsets[ii] - position, file) == header.offsets[ii] - position;
+		if (isWritten && header.sizes[ii] > 0) {
+			isWritten = fwrite(sections[ii], header.sizes[ii], 1, file) == 1;
+		}
+		position = header.offsets[ii] + header.sizes[ii];
+	}
+	isWritten = (fclose(file) == 0) && isWritten;
+	if (isWritten) {
+#ifdef _WIN32
+		remove(cacheFilename.c_str()); // rename doesn't replace on Windows
+#endif
+		// POSIX rename replaces the cache atomically: readers map either the old file or the new one
+		isWritten = rename(tmpFilename.c_str(), cacheFilename.c_str()) == 0;
+	}
+	if (!isWritten) {
+		remove(tmpFilename.c_str());
+	}
+}
+
+void MeshGeometry::buildTriangleRecords()
+{
+	// nine arrays of t.size() floats: v0 x y z, edge1 x y z, edge2 x y z
+	size_t count = t.size();
+	m_triRecords.resize(9 * count);
+	for (unsigned int ii = 0; ii < count; ii++) {
+		const Vector3f& a = v[t[ii][0]];
+		Vector3f e1 = v[t[ii][1]] - a;
+		Vector3f e2 = v[t[ii][2]] - a;
+		for (int kk = 0; kk < 3; kk++) {
+			m_triRecords[kk * count + ii] = a[kk];
+			m_triRecords[(3 + kk) * count + ii] = e1[kk];
+			m_triRecords[(6 + kk) * count + ii] = e2[kk];
+		}
+	}
+}
+
+void MeshGeometry::buildBVH()
+{
+	std::vector<BoundingBox> bounds(t.size());
+	for (unsigned int ii = 0; ii < t.size(); ii++) {
+		for (int jj = 0; jj < 3; jj++) {
+			bounds[ii].extend(v[t[ii][jj]]);
+		}
+	}
+	m_bvh.build(bounds, getBVHBuildSettings());
+	m_wideBVH.build(m_bvh);
+	m_box = m_bvh.getBounds();
+}
+
+void MeshGeometry::compute_norm()
+{
+	n.resize(v.size());
+	for (unsigned int ii = 0; ii<t.size(); ii++) {
+		Vector3f a = v[t[ii][1]] - v[t[ii][0]];
+		Vector3f b = v[t[ii][2]] - v[t[ii][0]];
+		b = Vector3f::cross(a, b);
+		for (int jj = 0; jj<3; jj++) {
+			n[t[ii][jj]] += b;
+		}
+	}
+	for (unsigned int ii = 0; ii<v.size(); ii++) {
+		n[ii] = n[ii] / n[ii].abs();
+	}
+}
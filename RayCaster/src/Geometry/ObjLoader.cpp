@@ -0,0 +1,351 @@
+#include "ObjLoader.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include "MappedFile.h"
+#include "ThreadPool.h"
+
+/////////////////////////////////
+// ObjLoader class Implementation
+/////////////////////////////////
+
+// records of one chunk of the file, indices are resolved when chunks are merged
+struct ObjChunk
+{
+	std::vector<Vector3f> v;
+	std::vector<Vector2f> texCoord;
+	std::vector<Trig> t;
+	// relative (negative) indices can point into previous chunks:
+	// they are stored relative to the chunk and listed here as triangle * 6 + corner * 2 + (0 vertex, 1 texture)
+	std::vector<int> relativeIndices;
+};
+
+static const double s_powersOf10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+	1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+static inline bool isBlank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline bool isDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+static inline void skipBlanks(const char*& c, const char* end)
+{
+	while (c < end && isBlank(*c)) ++c;
+}
+
+static inline void skipLine(const char*& c, const char* end)
+{
+	const char* eol = (const char*)memchr(c, '\n', end - c);
+	c = (eol != NULL) ? eol + 1 : end;
+}
+
+static inline bool parseInt(const char*& c, const char* end, int& i)
+{
+	bool isNegative = false;
+	if (c < end && (*c == '-' || *c == '+'))
+	{
+		isNegative = (*c == '-');
+		++c;
+	}
+	if (c == end || !isDigit(*c)) return false;
+	int value = 0;
+	while (c < end && isDigit(*c))
+	{
+		value = value * 10 + (*c - '0');
+		++c;
+	}
+	i = isNegative ? -value : value;
+	return true;
+}
+
+bool ObjLoader::parseFloat(const char*& c, const char* end, float& f)
+{
+	skipBlanks(c, end);
+	const char* start = c;
+	bool isNegative = false;
+	if (c < end && (*c == '-' || *c == '+'))
+	{
+		isNegative = (*c == '-');
+		++c;
+	}
+
+	// up to 19 significant digits fit in the mantissa, later ones only scale it
+	unsigned long long mantissa = 0;
+	int digitCount = 0;
+	int exponent = 0;
+	bool hasDigits = false;
+	while (c < end && isDigit(*c))
+	{
+		hasDigits = true;
+		if (digitCount < 19)
+		{
+			mantissa = mantissa * 10 + (*c - '0');
+			if (mantissa != 0) digitCount++;
+		}
+		else
+		{
+			exponent++;
+		}
+		++c;
+	}
+	if (c < end && *c == '.')
+	{
+		++c;
+		while (c < end && isDigit(*c))
+		{
+			hasDigits = true;
+			if (digitCount < 19)
+			{
+				mantissa = mantissa * 10 + (*c - '0');
+				if (mantissa != 0) digitCount++;
+				exponent--;
+			}
+			++c;
+		}
+	}
+	if (hasDigits && c < end && (*c == 'e' || *c == 'E'))
+	{
+		const char* expStart = c;
+		++c;
+		int e;
+		if (parseInt(c, end, e)) exponent += e;
+		else c = expStart;
+	}
+
+	if (hasDigits && mantissa < (1ull << 53) && exponent >= -22 && exponent <= 22)
+	{
+		// both the mantissa and the power of 10 are exact doubles: value is the number rounded once, to a double,
+		// and lies in the range of normal floats. Rounding it to a float gives the float nearest to the number
+		// unless it landed exactly halfway between two floats, where the number itself may not be: strtof decides
+		double value = (double)mantissa;
+		value = (exponent < 0) ? value / s_powersOf10[-exponent] : value * s_powersOf10[exponent];
+		unsigned long long bits;
+		memcpy(&bits, &value, sizeof(bits));
+		// the 29 low mantissa bits a float drops, 100...0 is the halfway point
+		if ((bits & ((1ull << 29) - 1)) != (1ull << 28))
+		{
+			f = (float)(isNegative ? -value : value);
+			return true;
+		}
+	}
+
+	// long mantissas, huge exponents, halfway cases, inf and nan go through the C library
+	char buffer[64];
+	size_t length = 0;
+	c = start;
+	while (c + length < end && !isBlank(c[length]) && c[length] != '\n' && length < sizeof(buffer) - 1)
+	{
+		buffer[length] = c[length];
+		length++;
+	}
+	buffer[length] = 0;
+	char* parsedEnd;
+	float value = strtof(buffer, &parsedEnd);
+	if (parsedEnd == buffer) return false;
+	c += parsedEnd - buffer;
+	f = value;
+	return true;
+}
+
+// one face corner: v, v/vt, v/vt/vn or v//vn
+static inline bool parseCorner(const char*& c, const char* end, int& vertex, int& texture)
+{
+	if (!parseInt(c, end, vertex)) return false;
+	texture = 0;
+	if (c < end && *c == '/')
+	{
+		++c;
+		parseInt(c, end, texture);
+		if (c < end && *c == '/')
+		{
+			++c;
+			int normal;
+			parseInt(c, end, normal);
+		}
+	}
+	return true;
+}
+
+static void parseChunk(const char* c, const char* end, ObjChunk& chunk)
+{
+	std::vector<int> vertices, textures;
+	while (c < end)
+	{
+		skipBlanks(c, end);
+		if (end - c < 2)
+		{
+			c = end;
+			break;
+		}
+		if (c[0] == 'v' && isBlank(c[1]))
+		{
+			c += 2;
+			Vector3f vec;
+			for (int i = 0; i < 3; ++i)
+			{
+				if (!ObjLoader::parseFloat(c, end, vec[i])) break;
+			}
+			chunk.v.push_back(vec);
+		}
+		else if (c[0] == 'v' && c[1] == 't' && c + 2 < end && isBlank(c[2]))
+		{
+			c += 3;
+			Vector2f texcoord;
+			for (int i = 0; i < 2; ++i)
+			{
+				if (!ObjLoader::parseFloat(c, end, texcoord[i])) break;
+			}
+			chunk.texCoord.push_back(texcoord);
+		}
+		else if (c[0] == 'f' && isBlank(c[1]))
+		{
+			c += 2;
+			vertices.clear();
+			textures.clear();
+			int vertex, texture;
+			skipBlanks(c, end);
+			while (c < end && *c != '\n' && parseCorner(c, end, vertex, texture))
+			{
+				vertices.push_back(vertex);
+				textures.push_back(texture);
+				skipBlanks(c, end);
+			}
+			// fan triangulation of quads and n-gons
+			for (unsigned int i = 2; i < vertices.size(); ++i)
+			{
+				int corners[3] = { 0, (int)i - 1, (int)i };
+				Trig trig;
+				for (int k = 0; k < 3; ++k)
+				{
+					int vi = vertices[corners[k]];
+					int ti = textures[corners[k]];
+					int tri = chunk.t.size();
+					if (vi < 0)
+					{
+						chunk.relativeIndices.push_back(tri * 6 + k * 2);
+						trig.x[k] = (int)chunk.v.size() + vi;
+					}
+					else
+					{
+						trig.x[k] = vi - 1;
+					}
+					if (ti < 0)
+					{
+						chunk.relativeIndices.push_back(tri * 6 + k * 2 + 1);
+						trig.texID[k] = (int)chunk.texCoord.size() + ti;
+					}
+					else
+					{
+						// faces without texture coordinates use the first one
+						trig.texID[k] = (ti > 0) ? ti - 1 : 0;
+					}
+				}
+				chunk.t.push_back(trig);
+			}
+		}
+		skipLine(c, end);
+	}
+}
+
+int ObjLoader::parse(const char* data, size_t size, std::vector<Vector3f>& v, std::vector<Vector2f>& texCoord, std::vector<Trig>& t, int chunkCount)
+{
+	v.clear();
+	texCoord.clear();
+	t.clear();
+	if (data == NULL || size == 0) return 0;
+
+	ThreadPool& pool = ThreadPool::getGlobal();
+	if (chunkCount <= 0)
+	{
+		// a few chunks per thread so that uneven lines still balance
+		chunkCount = (int)std::min<size_t>(size / OBJ_LOADER_MIN_CHUNK_SIZE + 1, 4 * pool.getThreadCount());
+	}
+
+	// chunk boundaries are moved to the start of the next line
+	std::vector<const char*> bounds(chunkCount + 1);
+	const char* end = data + size;
+	bounds[0] = data;
+	for (int i = 1; i < chunkCount; ++i)
+	{
+		const char* c = std::max(data + size * i / chunkCount, bounds[i - 1]);
+		skipLine(c, end);
+		bounds[i] = c;
+	}
+	bounds[chunkCount] = end;
+
+	std::vector<ObjChunk> chunks(chunkCount);
+	pool.parallelFor(chunkCount, [&](int i)
+	{
+		parseChunk(bounds[i], bounds[i + 1], chunks[i]);
+	});
+
+	size_t vertexCount = 0, texCoordCount = 0, triangleCount = 0;
+	for (int i = 0; i < chunkCount; ++i)
+	{
+		vertexCount += chunks[i].v.size();
+		texCoordCount += chunks[i].texCoord.size();
+		triangleCount += chunks[i].t.size();
+	}
+	v.reserve(vertexCount);
+	texCoord.reserve(texCoordCount);
+	t.reserve(triangleCount);
+	for (int i = 0; i < chunkCount; ++i)
+	{
+		ObjChunk& chunk = chunks[i];
+		int vertexOffset = v.size();
+		int texCoordOffset = texCoord.size();
+		int triangleOffset = t.size();
+		v.insert(v.end(), chunk.v.begin(), chunk.v.end());
+		texCoord.insert(texCoord.end(), chunk.texCoord.begin(), chunk.texCoord.end());
+		t.insert(t.end(), chunk.t.begin(), chunk.t.end());
+		for (unsigned int k = 0; k < chunk.relativeIndices.size(); ++k)
+		{
+			int code = chunk.relativeIndices[k];
+			Trig& trig = t[triangleOffset + code / 6];
+			if (code % 2 == 0) trig.x[(code % 6) / 2] += vertexOffset;
+			else trig.texID[(code % 6) / 2] += texCoordOffset;
+		}
+		// release the chunk as soon as it is merged to keep the peak memory down
+		ObjChunk().v.swap(chunk.v);
+		ObjChunk().texCoord.swap(chunk.texCoord);
+		ObjChunk().t.swap(chunk.t);
+	}
+
+	// drop the triangles pointing outside of the lists, the BVH and the triangle records index them blindly
+	// (texture indices are only used when the mesh has texture coordinates)
+	int vertexTotal = v.size();
+	int texCoordTotal = texCoord.size();
+	size_t kept = 0;
+	for (size_t i = 0; i < t.size(); ++i)
+	{
+		bool isValid = true;
+		for (int k = 0; k < 3; ++k)
+		{
+			isValid = isValid && t[i].x[k] >= 0 && t[i].x[k] < vertexTotal;
+			isValid = isValid && (texCoordTotal == 0 || (t[i].texID[k] >= 0 && t[i].texID[k] < texCoordTotal));
+		}
+		if (isValid) t[kept++] = t[i];
+	}
+	int dropped = (int)(t.size() - kept);
+	t.resize(kept);
+	return dropped;
+}
+
+bool ObjLoader::load(const char* filename, std::vector<Vector3f>& v, std::vector<Vector2f>& texCoord, std::vector<Trig>& t)
+{
+	MappedFile file;
+	if (!file.open(filename, MAPPED_FILE_SEQUENTIAL)) return false;
+	int dropped = parse(file.getData(), file.getSize(), v, texCoord, t);
+	if (dropped > 0)
+	{
+		std::cout << filename << ": dropped " << dropped << " triangles with out of range indices\n";
+	}
+	return true;
+}
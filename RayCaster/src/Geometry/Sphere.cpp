@@ -34,35 +34,79 @@ float Sphere::getRadius() const
 	return m_radius;
 }
 
+bool Sphere::getBoundingBox(BoundingBox& box) const
+{
+	box = BoundingBox(m_center - Vector3f(m_radius), m_center + Vector3f(m_radius));
+	return true;
+}
+
 bool Sphere::intersect(const Ray& r, Hit& h, float tmin)
 {
 	float t;
 	Ray ray = Ray(r.getOrigin(), r.getDirection().normalized());
 	float b = 2 * Vector3f::dot(ray.getDirection(), ray.getOrigin() - m_center);
 	float c = Vector3f::dot(ray.getOrigin() - m_center, ray.getOrigin() - m_center) - m_radius * m_radius;
+	if (getRoot(b, c, tmin, h.getT(), t))
+	{
+		h.set(t, m_material, (ray.pointAtParameter(t) - m_center).normalized());
+		return true;
+	}
+	return false;
+}
 
+RayMask Sphere::intersect(RayPacket& packet, RayMask lanes)
+{
+	typedef RayPacket::Floats Floats;
+	RayMask hitLanes = 0;
+	for (int g = 0; g < RAY_PACKET_GROUPS; ++g)
+	{
+		unsigned int groupLanes = RayPacket::getGroupLanes(lanes, g);
+		if (groupLanes == 0) continue;
+
+		// b and c like the single ray test, the lanes whose ray crosses the sphere then pick their root alone
+		RayPacket::Vectors oc = packet.getOrigins(g);
+		oc -= RayPacket::Vectors(m_center);
+		Floats b = 2 * RayPacket::Vectors::dot(packet.getUnitDirections(g), oc);
+		Floats c = RayPacket::Vectors::dot(oc, oc) - m_radius * m_radius;
+		unsigned int crossLanes = (b * b - 4 * c >= Floats(0.f)).getBits() & groupLanes;
+		if (crossLanes == 0) continue;
+
+		float bLanes[RAY_PACKET_WIDTH], cLanes[RAY_PACKET_WIDTH];
+		b.store(bLanes);
+		c.store(cLanes);
+		for (int k = 0; k < RAY_PACKET_WIDTH; ++k)
+		{
+			int lane = g * RAY_PACKET_WIDTH + k;
+			float t;
+			if (((crossLanes >> k) & 1) == 0 || !getRoot(bLanes[k], cLanes[k], packet.getTMin(lane), packet.getTMax(lane), t)) continue;
+			Ray ray = Ray(packet.getOrigin(lane), packet.getUnitDirection(lane));
+			packet.getHit(lane).set(t, m_material, (ray.pointAtParameter(t) - m_center).normalized());
+			packet.setTMax(lane, t);
+			hitLanes |= (RayMask)1 << lane;
+		}
+	}
+	return hitLanes;
+}
+
+bool Sphere::getRoot(float b, float c, float tmin, float tmax, float& t)
+{
 	float det = b * b - 4 * c;
 	if (det == 0)
 	{
 		t = -b / 2;
-		if (t >= tmin && t < h.getT())
-		{
-			h.set(t, m_material, (ray.pointAtParameter(t) - m_center).normalized());
-			return true;
-		}
 	}
 	else if (det > 0)
 	{
 		t = (-b - sqrt(det)) / 2;
-		if (t < 0)
+		// the near root is behind tmin when the ray starts inside or on the sphere (shadow rays)
+		if (t < tmin)
 		{
 			t = (-b + sqrt(det)) / 2;
 		}
-		if (t >= tmin && t < h.getT())
-		{
-			h.set(t, m_material, (ray.pointAtParameter(t) - m_center).normalized());
-			return true;
-		}
 	}
-	return false;
-}
\ No newline at end of file
+	else
+	{
+		return false;
+	}
+	return t >= tmin && t < tmax;
+}
@@ -1,5 +1,6 @@
 #include "Transform.h"
 #include "Vector4f.h"
+#include "RayCounters.h"
 
 /////////////////////////////////
 // Transform class Implementation
@@ -9,18 +10,21 @@
 
 Transform::Transform() :
 m_obj(),
-m_transMatrix()
+m_transMatrix(Matrix4f::identity())
 {
+	updateInverse();
 }
 
 Transform::Transform(const Matrix4f& m, Object3D* obj) :
 m_obj(obj),
 m_transMatrix(m)
 {
+	updateInverse();
 }
 
 Transform::~Transform()
 {
+	delete m_obj;
 }
 
 Object3D * Transform::getObject() const
@@ -33,16 +37,210 @@ Matrix4f Transform::getTransformationMatrix() const
 	return m_transMatrix;
 }
 
+void Transform::setTransformationMatrix(const Matrix4f& m)
+{
+	m_transMatrix = m;
+	updateInverse();
+}
+
+bool Transform::isAffine() const
+{
+	return m_isAffine;
+}
+
+void Transform::updateInverse()
+{
+	m_invMatrix = m_transMatrix.inverse();
+	m_normalMatrix = m_invMatrix.transposed();
+	m_isAffine = m_transMatrix(3, 0) == 0.f && m_transMatrix(3, 1) == 0.f && m_transMatrix(3, 2) == 0.f && m_transMatrix(3, 3) == 1.f;
+	for (int i = 0; i < 3; ++i)
+	{
+		for (int j = 0; j < 4; ++j)
+		{
+			m_invAffine[i * 4 + j] = m_invMatrix(i, j);
+		}
+		for (int j = 0; j < 3; ++j)
+		{
+			m_normalAffine[i * 3 + j] = m_normalMatrix(i, j);
+		}
+	}
+}
+
+void Transform::prepare()
+{
+	if (m_obj != NULL)
+		m_obj->prepare();
+}
+
+bool Transform::getBoundingBox(BoundingBox& box) const
+{
+	BoundingBox objBox;
+	if (m_obj == NULL || !m_obj->getBoundingBox(objBox)) return false;
+	box = BoundingBox::transformed(m_transMatrix, objBox);
+	return true;
+}
+
+void Transform::toObjectSpace(const float* differentials, float* transfDifferentials) const
+{
+	// origins and directions alternate, only the origins are translated
+	for (int k = 0; k < 4; ++k)
+	{
+		const float* in = differentials + 3 * k;
+		float* out = transfDifferentials + 3 * k;
+		float w = (k % 2 == 0) ? 1.f : 0.f;
+		if (m_isAffine)
+		{
+			const float* m = m_invAffine;
+			for (int i = 0; i < 3; ++i, m += 4)
+			{
+				out[i] = m[0] * in[0] + m[1] * in[1] + m[2] * in[2] + m[3] * w;
+			}
+		}
+		else
+		{
+			Vector3f transf = (m_invMatrix * Vector4f(in[0], in[1], in[2], w)).xyz();
+			for (int i = 0; i < 3; ++i)
+			{
+				out[i] = transf[i];
+			}
+		}
+	}
+}
+
+void Transform::toObjectSpace(const Ray& r, Vector3f& transfOrig, Vector3f& transfDir) const
+{
+	Vector3f dir = r.getDirection().normalized();
+	if (m_isAffine)
+	{
+		// 3x4 path: the last row is known, skip it
+		const float* m = m_invAffine;
+		const Vector3f& o = r.getOrigin();
+		for (int i = 0; i < 3; ++i, m += 4)
+		{
+			transfOrig[i] = m[0] * o[0] + m[1] * o[1] + m[2] * o[2] + m[3];
+			transfDir[i] = m[0] * dir[0] + m[1] * dir[1] + m[2] * dir[2];
+		}
+	}
+	else
+	{
+		// directions are not affected by the translation (w = 0)
+		transfDir = (m_invMatrix * Vector4f(dir, 0.f)).xyz();
+		transfOrig = (m_invMatrix * Vector4f(r.getOrigin(), 1.f)).xyz();
+	}
+}
+
 bool Transform::intersect(const Ray& r, Hit& h, float tmin)
 {
-	Vector4f transfDir = m_transMatrix.inverse() * Vector4f(r.getDirection(), 1.f);
-	Vector4f transfOrig = m_transMatrix.inverse() * Vector4f(r.getOrigin(), 1.f);
-	Ray transfRay = Ray(transfOrig.xyz(), transfDir.xyz());
-	if (m_obj->intersect(transfRay, h, tmin))
+	RAY_COUNT_NODES(1);
+	Vector3f transfOrig, transfDir;
+	toObjectSpace(r, transfOrig, transfDir);
+	Ray transfRay = Ray(transfOrig, transfDir);
+	if (r.hasDifferentials())
+	{
+		float transfDifferentials[12];
+		toObjectSpace(r.getDifferentials(), transfDifferentials);
+		transfRay.setDifferentials(transfDifferentials);
+	}
+
+	// objects measure t along their normalized direction: rescale it so the
+	// object space hit can be compared with world space hits and bounds
+	float scale = transfDir.abs();
+	Hit objHit((h.getT() < FLT_MAX) ? h.getT() * scale : FLT_MAX, h.getMaterial(), h.getNormal());
+	if (m_obj->intersect(transfRay, objHit, tmin * scale))
 	{
-		Vector4f transfNormal = m_transMatrix.inverse().transposed() * Vector4f(h.getNormal(), 1.f);
-		h.set(h.getT(), h.getMaterial(), transfNormal.xyz().normalized());
+		toWorldSpace(objHit, scale, h);
 		return true;
 	}
 	return false;
-}
\ No newline at end of file
+}
+
+RayMask Transform::intersect(RayPacket& packet, RayMask lanes)
+{
+	// projective matrices are rare, their rays go one by one, and so do the few lanes
+	// reaching an object: setting up its packet would cost more than it saves
+	if (!m_isAffine || RayPacket::hasFewerLanes(lanes, TRANSFORM_PACKET_MIN_LANES))
+		return Object3D::intersect(packet, lanes);
+
+	RAY_COUNT_NODES(1);
+	RayPacket objPacket;
+	Hit objHits[RAY_PACKET_SIZE];
+	float scales[RAY_PACKET_SIZE];
+	for (int g = 0; g < RAY_PACKET_GROUPS; ++g)
+	{
+		if (RayPacket::getGroupLanes(lanes, g) == 0) continue;
+		// the operations of toObjectSpace and intersect, lane by lane, so each lane gets the ray and
+		// distances of its single ray: the packet direction is already normalized like there
+		RayPacket::Vectors orig = packet.getOrigins(g);
+		RayPacket::Vectors dir = packet.getUnitDirections(g);
+		RayPacket::Vectors transfOrig, transfDir;
+		const float* m = m_invAffine;
+		for (int i = 0; i < 3; ++i, m += 4)
+		{
+			transfOrig[i] = m[0] * orig[0] + m[1] * orig[1] + m[2] * orig[2] + m[3];
+			transfDir[i] = m[0] * dir[0] + m[1] * dir[1] + m[2] * dir[2];
+		}
+		RayPacket::Floats scale = transfDir.abs();
+		RayPacket::Floats tmax = packet.getTMaxes(g);
+		RayPacket::Floats noHit(FLT_MAX);
+		objPacket.setGroup(g, transfOrig, transfDir, packet.getTMins(g) * scale, RayPacket::Floats::select(tmax < noHit, tmax * scale, noHit));
+		scale.store(scales + g * RAY_PACKET_WIDTH);
+	}
+	for (int i = 0; i < RAY_PACKET_SIZE; ++i)
+	{
+		if (((lanes >> i) & 1) == 0) continue;
+		const Hit& h = packet.getHit(i);
+		objHits[i] = Hit(objPacket.getTMax(i), h.getMaterial(), h.getNormal());
+		float transfDifferentials[12];
+		if (packet.hasDifferentials(i))
+		{
+			toObjectSpace(packet.getDifferentials(i), transfDifferentials);
+		}
+		objPacket.setLane(i, &objHits[i], packet.hasDifferentials(i) ? transfDifferentials : NULL);
+	}
+	objPacket.prepare();
+
+	RayMask hitLanes = m_obj->intersect(objPacket, lanes);
+	for (int i = 0; i < RAY_PACKET_SIZE; ++i)
+	{
+		if (((hitLanes >> i) & 1) == 0) continue;
+		Hit& h = packet.getHit(i);
+		toWorldSpace(objHits[i], scales[i], h);
+		packet.setTMax(i, h.getT());
+	}
+	return hitLanes;
+}
+
+void Transform::toWorldSpace(const Hit& objHit, float scale, Hit& h) const
+{
+	Vector3f transfNormal;
+	if (m_isAffine)
+	{
+		const float* m = m_normalAffine;
+		const Vector3f& n = objHit.getNormal();
+		for (int i = 0; i < 3; ++i, m += 3)
+		{
+			transfNormal[i] = m[0] * n[0] + m[1] * n[1] + m[2] * n[2];
+		}
+	}
+	else
+	{
+		transfNormal = (m_normalMatrix * Vector4f(objHit.getNormal(), 0.f)).xyz();
+	}
+	h.set(objHit.getT() / scale, objHit.getMaterial(), transfNormal.normalized());
+	if (objHit.hasTex)
+	{
+		// texture coordinates don't depend on the space, neither do their differentials
+		h.setTexCoord(objHit.texCoord);
+		h.setTexCoordDifferentials(objHit.texCoordDx, objHit.texCoordDy);
+	}
+}
+
+bool Transform::occluded(const Ray& r, float tmin, float tmax)
+{
+	RAY_COUNT_NODES(1);
+	Vector3f transfOrig, transfDir;
+	toObjectSpace(r, transfOrig, transfDir);
+	// same rescaling of the distances as intersect
+	float scale = transfDir.abs();
+	return m_obj->occluded(Ray(transfOrig, transfDir), tmin * scale, (tmax < FLT_MAX) ? tmax * scale : FLT_MAX);
+}
@@ -7,12 +7,14 @@
 ////////////////////////////////
 
 Triangle::Triangle():
-Object3D()
+Object3D(),
+hasTex(false)
 {
 }
 
 Triangle::Triangle(const Vector3f& a, const Vector3f& b, const Vector3f& c, Material* m) :
 Object3D(m),
+hasTex(false),
 m_a(a),
 m_b(b),
 m_c(c)
@@ -45,9 +47,18 @@ bool Triangle::intersect(const Ray& ray, Hit& hit, float tmin)
 			{
 				hit.setTexCoord((1 - beta - gamma) * texCoords[0] + beta * texCoords[1] + gamma * texCoords[2]);
 			}
-
+			return true;
 		}
 	}
 
 	return false;
+}
+
+bool Triangle::getBoundingBox(BoundingBox& box) const
+{
+	box = BoundingBox();
+	box.extend(m_a);
+	box.extend(m_b);
+	box.extend(m_c);
+	return true;
 }
\ No newline at end of file
@@ -0,0 +1,180 @@
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include "WideBVH.h"
+
+///////////////////////////////
+// WideBVH class Implementation
+///////////////////////////////
+
+// a wide node at depth w comes from a binary inner node at depth w or more, below BVH_MAX_DEPTH.
+// Each of its ancestors leaves at most WIDE_BVH_WIDTH - 1 children on the stack, and it pushes WIDE_BVH_WIDTH
+static_assert(WIDE_BVH_STACK_SIZE >= (WIDE_BVH_WIDTH - 1) * BVH_MAX_DEPTH + 1, "the traversal stack can't hold the deepest wide BVH");
+
+// testing the children one by one in scalar blocks is slower than the binary BVH
+static std::atomic<bool> wideBVHEnabled(WideBVH::Floats::Block::WIDTH > 1);
+
+// the dequantization of WideBVH::intersectChildren
+static float dequantize(float origin, float scale, int step)
+{
+	return origin + (float)step * scale;
+}
+
+// largest step at or below value
+static unsigned char quantizeLower(float origin, float scale, float value)
+{
+	int step = (scale > 0.f) ? (int)std::floor((value - origin) / scale) : 0;
+	step = (step < 0) ? 0 : (step > WIDE_BVH_STEPS) ? WIDE_BVH_STEPS : step;
+	while (step > 0 && dequantize(origin, scale, step) > value) --step;
+	return (unsigned char)step;
+}
+
+// smallest step at or above value
+static unsigned char quantizeUpper(float origin, float scale, float value)
+{
+	int step = (scale > 0.f) ? (int)std::ceil((value - origin) / scale) : 0;
+	step = (step < 0) ? 0 : (step > WIDE_BVH_STEPS) ? WIDE_BVH_STEPS : step;
+	while (step < WIDE_BVH_STEPS && dequantize(origin, scale, step) < value) ++step;
+	return (unsigned char)step;
+}
+
+WideBVH::WideBVH() :
+m_nodes(),
+m_primData(NULL)
+{
+}
+
+void WideBVH::build(const BVH& bvh)
+{
+	clear();
+	if (bvh.isEmpty()) return;
+
+	m_primData = bvh.getPrimitiveIndices();
+	// a binary node has two children, a wide one a few more: about half as many nodes
+	m_nodes.reserve(bvh.getNodeCount() / 2 + 1);
+	collapseNode(bvh, 0);
+}
+
+void WideBVH::clear()
+{
+	m_nodes.clear();
+	m_primData = NULL;
+}
+
+bool WideBVH::isEmpty() const
+{
+	return m_nodes.empty();
+}
+
+int WideBVH::getNodeCount() const
+{
+	return m_nodes.size();
+}
+
+const WideBVHNode& WideBVH::getNode(int i) const
+{
+	assert(i >= 0 && i < (int)m_nodes.size());
+	return m_nodes[i];
+}
+
+void WideBVH::setEnabled(bool enabled)
+{
+	wideBVHEnabled = enabled;
+}
+
+bool WideBVH::isEnabled()
+{
+	return wideBVHEnabled;
+}
+
+int WideBVH::collapseNode(const BVH& bvh, int i)
+{
+	// open the inner child of largest area until the node is full, the children of a leaf root are itself
+	int children[WIDE_BVH_WIDTH];
+	int childCount = 0;
+	const BVHNode& binaryNode = bvh.getNode(i);
+	if (binaryNode.count > 0)
+	{
+		children[childCount++] = i;
+	}
+	else
+	{
+		children[childCount++] = i + 1;
+		children[childCount++] = binaryNode.offset;
+	}
+	while (childCount < WIDE_BVH_WIDTH)
+	{
+		int best = -1;
+		float bestArea = -1.f;
+		for (int k = 0; k < childCount; ++k)
+		{
+			const BVHNode& child = bvh.getNode(children[k]);
+			if (child.count == 0 && child.box.getSurfaceArea() > bestArea)
+			{
+				best = k;
+				bestArea = child.box.getSurfaceArea();
+			}
+		}
+		if (best < 0) break;
+		int opened = children[best];
+		children[best] = opened + 1;
+		children[childCount++] = bvh.getNode(opened).offset;
+	}
+
+	int nodeIndex = m_nodes.size();
+	m_nodes.push_back(WideBVHNode());
+	WideBVHNode node;
+	const BoundingBox& box = binaryNode.box;
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		// the last step must reach the upper side of the box despite rounding
+		float origin = box.getMin()[axis];
+		float scale = (box.getMax()[axis] - origin) / WIDE_BVH_STEPS;
+		while (dequantize(origin, scale, WIDE_BVH_STEPS) < box.getMax()[axis])
+		{
+			scale = std::nextafter(scale, FLT_MAX);
+		}
+		node.origin[axis] = origin;
+		node.scale[axis] = scale;
+	}
+	for (int k = 0; k < WIDE_BVH_WIDTH; ++k)
+	{
+		if (k < childCount)
+		{
+			const BoundingBox& childBox = bvh.getNode(children[k]).box;
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				node.lower[axis][k] = quantizeLower(node.origin[axis], node.scale[axis], childBox.getMin()[axis]);
+				node.upper[axis][k] = quantizeUpper(node.origin[axis], node.scale[axis], childBox.getMax()[axis]);
+			}
+		}
+		else
+		{
+			// never entered, masked out by childCount
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				node.lower[axis][k] = 0;
+				node.upper[axis][k] = 0;
+			}
+		}
+		node.child[k] = 0;
+		node.count[k] = 0;
+	}
+	node.childCount = childCount;
+
+	for (int k = 0; k < childCount; ++k)
+	{
+		const BVHNode& child = bvh.getNode(children[k]);
+		if (child.count > 0)
+		{
+			node.child[k] = child.offset;
+			node.count[k] = child.count;
+		}
+		else
+		{
+			node.child[k] = collapseNode(bvh, children[k]);
+		}
+	}
+	m_nodes[nodeIndex] = node;
+	return nodeIndex;
+}
@@ -32,6 +32,9 @@ Hit::Hit(const Hit& h)
 	m_material = h.m_material;
 	m_normal = h.m_normal;
 	hasTex = h.hasTex;
+	texCoord = h.texCoord;
+	texCoordDx = h.texCoordDx;
+	texCoordDy = h.texCoordDy;
 }
 
 // destructor
@@ -69,6 +72,13 @@ void Hit::set(float _t, Material* m, const Vector3f& n)
 
 void Hit::setTexCoord(const Vector2f & coord) {
 	texCoord = coord;
+	texCoordDx = Vector2f(0.f);
+	texCoordDy = Vector2f(0.f);
 	hasTex = true;
 }
+
+void Hit::setTexCoordDifferentials(const Vector2f & dx, const Vector2f & dy) {
+	texCoordDx = dx;
+	texCoordDy = dy;
+}
 #pragma endregion
\ No newline at end of file
@@ -21,13 +21,14 @@ DirectionalLight::~DirectionalLight()
 
 }
 ///@param p unsed in this function
-///@param distanceToLight not well defined because it's not a point light
+///@param distanceToLight FLT_MAX, the light is at infinity
 void DirectionalLight::getIllumination(const Vector3f& p, Vector3f& dir, Vector3f& col, float& distanceToLight) const
 {
 	// the direction to the light is the opposite of the
 	// direction of the directional light source
 	dir = -m_direction;
 	col = m_color;
+	distanceToLight = FLT_MAX;
 }
 
 Vector3f DirectionalLight::getDirection() const
@@ -54,10 +55,11 @@ void DirectionalLight::setColor(const Vector3f & color)
 // Point Light Implementation
 /////////////////////////////
 
-PointLight::PointLight(const Vector3f& p, const Vector3f& c)
+PointLight::PointLight(const Vector3f& p, const Vector3f& c, float radius)
 {
 	m_position = p;
 	m_color = c;
+	m_radius = radius;
 }
 
 PointLight::~PointLight()
@@ -70,8 +72,26 @@ void PointLight::getIllumination(const Vector3f& p, Vector3f& dir, Vector3f& col
 	// the direction to the light is the opposite of the
 	// direction of the directional light source
 	dir = (m_position - p);
-	dir = dir / dir.abs();
+	distanceToLight = dir.abs();
+	dir = dir / distanceToLight;
 	col = m_color;
+	if (m_radius > 0)
+	{
+		// (1 - (d / r)^4)^2 window: close to 1 for most of the radius, smoothly 0 at the radius
+		float ratio = distanceToLight / m_radius;
+		float window = 1 - ratio * ratio * ratio * ratio;
+		col = (window > 0) ? m_color * (window * window) : Vector3f::ZERO;
+	}
+}
+
+bool PointLight::getBoundingBox(BoundingBox& box) const
+{
+	if (m_radius <= 0)
+	{
+		return false;
+	}
+	box = BoundingBox(m_position - Vector3f(m_radius), m_position + Vector3f(m_radius));
+	return true;
 }
 
 Vector3f PointLight::getPosition() const
@@ -92,4 +112,14 @@ Vector3f PointLight::getColor() const
 void PointLight::setColor(const Vector3f & color)
 {
 	m_color = color;
+}
+
+float PointLight::getRadius() const
+{
+	return m_radius;
+}
+
+void PointLight::setRadius(float radius)
+{
+	m_radius = radius;
 }
\ No newline at end of file
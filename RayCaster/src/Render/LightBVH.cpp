@@ -0,0 +1,72 @@
+#include <atomic>
+#include "LightBVH.h"
+
+////////////////////////////////
+// LightBVH class Implementation
+////////////////////////////////
+
+// rejecting a light by its radius costs less than descending one more level
+#define LIGHT_BVH_MAX_LEAF_SIZE 4
+
+static std::atomic<bool> cullingEnabled(true);
+
+LightBVH::LightBVH(const std::vector<Light*>& lights) :
+m_lights(lights),
+m_unboundedLights(),
+m_bvhLights(),
+m_bvh(),
+m_isDirty(true)
+{
+}
+
+LightBVH::~LightBVH()
+{
+}
+
+void LightBVH::invalidate()
+{
+	m_isDirty = true;
+}
+
+void LightBVH::prepare()
+{
+	if (m_isDirty)
+		build();
+}
+
+int LightBVH::getBoundedLightCount() const
+{
+	return m_bvhLights.size();
+}
+
+void LightBVH::setCullingEnabled(bool enabled)
+{
+	cullingEnabled = enabled;
+}
+
+bool LightBVH::isCullingEnabled()
+{
+	return cullingEnabled;
+}
+
+void LightBVH::build()
+{
+	std::vector<BoundingBox> bounds;
+	m_unboundedLights.clear();
+	m_bvhLights.clear();
+	for (unsigned int i = 0; i < m_lights.size(); ++i)
+	{
+		BoundingBox box;
+		if (m_lights[i]->getBoundingBox(box))
+		{
+			bounds.push_back(box);
+			m_bvhLights.push_back(i);
+		}
+		else
+		{
+			m_unboundedLights.push_back(i);
+		}
+	}
+	m_bvh.build(bounds, LIGHT_BVH_MAX_LEAF_SIZE);
+	m_isDirty = false;
+}
@@ -1,6 +1,8 @@
 #include "Material.h"
+#include <cmath>
 #include "Vector3f.h"
 #include "Hit.h"
+#include "TextureCache.h"
 
 ////////////////////////////////
 // Material class Implementation
@@ -32,7 +34,46 @@ float Material::getShininess() const
 	return m_shininess;
 }
 
+const std::shared_ptr<Texture>& Material::getTexture() const
+{
+	return m_t;
+}
+
+void Material::setDiffuseColor(const Vector3f& color)
+{
+	m_diffuseColor = color;
+}
+
+void Material::setSpecularColor(const Vector3f& color)
+{
+	m_specularColor = color;
+}
+
+void Material::setShininess(float s)
+{
+	m_shininess = s;
+}
+
+void Material::setTexture(const std::shared_ptr<Texture>& texture)
+{
+	m_t = texture;
+}
+
+Vector3f Material::getSurfaceColor(const Hit& hit) const
+{
+	if (!hit.hasTex || !m_t || !m_t->valid())
+	{
+		return m_diffuseColor;
+	}
+	return (*m_t)(hit.texCoord.x(), hit.texCoord.y(), m_t->getLevelOfDetail(hit.texCoordDx, hit.texCoordDy));
+}
+
 Vector3f Material::Shade(const Ray& ray, const Hit& hit, const Vector3f& dirToLight, const Vector3f& lightColor)
+{
+	return Shade(ray, hit, dirToLight, lightColor, getSurfaceColor(hit));
+}
+
+Vector3f Material::Shade(const Ray& ray, const Hit& hit, const Vector3f& dirToLight, const Vector3f& lightColor, const Vector3f& surfaceColor)
 {
 	float d = fmax(Vector3f::dot(dirToLight, hit.getNormal()), 0.f);
 	float s = 0;
@@ -41,10 +82,9 @@ Vector3f Material::Shade(const Ray& ray, const Hit& hit, const Vector3f& dirToLi
 		Vector3f reflection = 2 * Vector3f::dot(dirToLight, hit.getNormal()) * hit.getNormal() - dirToLight;
 		s = pow(fmax(Vector3f::dot(reflection, -ray.getDirection().normalized()), 0.f), m_shininess);
 	}
-	Vector3f matCol = (hit.hasTex && m_t.valid()) ? m_t(hit.texCoord.x(), hit.texCoord.y()) : m_diffuseColor;
-	return d * lightColor * matCol + s * lightColor * m_specularColor;
+	return d * lightColor * surfaceColor + s * lightColor * m_specularColor;
 }
 
 void Material::loadTexture(const char * filename) {
-	m_t.load(filename);
+	m_t = TextureCache::getGlobal().acquire(filename);
 }
\ No newline at end of file
@@ -23,10 +23,23 @@ Ray PerspectiveCamera::generateRay(const Vector2f& point)
 	return Ray(m_center, r);
 }
 
+Ray PerspectiveCamera::generateRay(const Vector2f& point, const Vector2f& pixelSize)
+{
+	Ray ray = generateRay(point);
+	// all rays leave from the center, only the directions differ
+	ray.setDifferentials(m_center, ray.getDirection() + pixelSize.x() * m_horizontal,
+		m_center, ray.getDirection() + m_aspectRatio * pixelSize.y() * m_up);
+	return ray;
+}
+
 float PerspectiveCamera::getTMin() const {
 	return 0.0f;
 }
 
 void PerspectiveCamera::setAngle(float angle) {
 	m_angle = angle;
+}
+
+void PerspectiveCamera::setAspectRatio(float aspectRatio) {
+	m_aspectRatio = aspectRatio;
 }
\ No newline at end of file
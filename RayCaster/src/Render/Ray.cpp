@@ -1,4 +1,5 @@
 #include "Ray.h"
+#include <cstring>
 
 ///////////////////////////
 // Ray class Implementation
@@ -15,12 +16,18 @@ Ray::Ray(const Vector3f& orig, const Vector3f& dir)
 {
 	m_origin = orig;
 	m_direction = dir;
+	m_hasDifferentials = false;
 }
 
 Ray::Ray(const Ray& r)
 {
 	m_origin = r.m_origin;
 	m_direction = r.m_direction;
+	m_hasDifferentials = r.m_hasDifferentials;
+	if (m_hasDifferentials)
+	{
+		memcpy(m_differentials, r.m_differentials, sizeof(m_differentials));
+	}
 }
 #pragma endregion
 //////////
@@ -42,4 +49,53 @@ Vector3f Ray::pointAtParameter(float t) const
 {
 	return m_origin + m_direction * t;
 }
+
+void Ray::setDifferentials(const Vector3f& dxOrigin, const Vector3f& dxDirection, const Vector3f& dyOrigin, const Vector3f& dyDirection)
+{
+	m_hasDifferentials = true;
+	const Vector3f* differentials[4] = { &dxOrigin, &dxDirection, &dyOrigin, &dyDirection };
+	for (int i = 0; i < 4; ++i)
+	{
+		for (int j = 0; j < 3; ++j)
+		{
+			m_differentials[i][j] = (*differentials[i])[j];
+		}
+	}
+}
+
+void Ray::setDifferentials(const float* differentials)
+{
+	m_hasDifferentials = true;
+	memcpy(m_differentials, differentials, sizeof(m_differentials));
+}
+
+bool Ray::hasDifferentials() const
+{
+	return m_hasDifferentials;
+}
+
+const float* Ray::getDifferentials() const
+{
+	return &m_differentials[0][0];
+}
+
+Vector3f Ray::getDxOrigin() const
+{
+	return Vector3f(m_differentials[0][0], m_differentials[0][1], m_differentials[0][2]);
+}
+
+Vector3f Ray::getDxDirection() const
+{
+	return Vector3f(m_differentials[1][0], m_differentials[1][1], m_differentials[1][2]);
+}
+
+Vector3f Ray::getDyOrigin() const
+{
+	return Vector3f(m_differentials[2][0], m_differentials[2][1], m_differentials[2][2]);
+}
+
+Vector3f Ray::getDyDirection() const
+{
+	return Vector3f(m_differentials[3][0], m_differentials[3][1], m_differentials[3][2]);
+}
 #pragma endregion
\ No newline at end of file
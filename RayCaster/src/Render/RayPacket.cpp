@@ -0,0 +1,190 @@
+#include "RayPacket.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+////////////////////////////////
+// RayPacket class Implementation
+////////////////////////////////
+
+///////////////
+// Constructors
+///////////////
+#pragma region Constructors
+
+RayPacket::RayPacket() :
+m_lanes(0),
+m_differentialLanes(0),
+m_rayLanes(0),
+m_planeCount(0)
+{
+}
+#pragma endregion
+//////////
+// Utility
+//////////
+#pragma region Utility
+
+void RayPacket::setRay(int i, const Ray& r, Hit* hit, float tmin)
+{
+	// normalized by prepare, a whole group at a time
+	for (int k = 0; k < 3; ++k)
+	{
+		m_origins[k][i] = r.getOrigin()[k];
+		m_directions[k][i] = r.getDirection()[k];
+	}
+	m_rayLanes |= (RayMask)1 << i;
+	m_tmin[i] = tmin;
+	m_tmax[i] = hit->getT();
+	setLane(i, hit, r.hasDifferentials() ? r.getDifferentials() : NULL);
+}
+
+void RayPacket::setGroup(int g, const Vectors& origins, const Vectors& directions, const Floats& tmin, const Floats& tmax)
+{
+	int first = g * RAY_PACKET_WIDTH;
+	Vectors unitDirs = directions.normalized();
+	Vectors invDirs = unitDirs.reciprocal();
+	for (int k = 0; k < 3; ++k)
+	{
+		origins[k].store(m_origins[k] + first);
+		directions[k].store(m_directions[k] + first);
+		unitDirs[k].store(m_unitDirections[k] + first);
+		invDirs[k].store(m_invDirections[k] + first);
+	}
+	tmin.store(m_tmin + first);
+	tmax.store(m_tmax + first);
+}
+
+void RayPacket::setLane(int i, Hit* hit, const float* differentials)
+{
+	m_hits[i] = hit;
+	m_lanes |= (RayMask)1 << i;
+	if (differentials != NULL)
+	{
+		memcpy(m_differentials[i], differentials, sizeof(m_differentials[i]));
+		m_differentialLanes |= (RayMask)1 << i;
+	}
+	else
+	{
+		m_differentialLanes &= ~((RayMask)1 << i);
+	}
+}
+
+Ray RayPacket::getRay(int i) const
+{
+	Ray r(getOrigin(i), Vector3f(m_directions[0][i], m_directions[1][i], m_directions[2][i]));
+	if (hasDifferentials(i))
+	{
+		r.setDifferentials(m_differentials[i]);
+	}
+	return r;
+}
+
+void RayPacket::prepare()
+{
+	m_planeCount = 0;
+	if (m_lanes == 0) return;
+
+	// the lanes left out of a group go through its SIMD tests too: give them
+	// the ray of a set lane rather than garbage that could be denormal
+	for (int g = 0; g < RAY_PACKET_GROUPS; ++g)
+	{
+		unsigned int groupLanes = getGroupLanes(m_lanes, g);
+		if (groupLanes == 0 || groupLanes == (1u << RAY_PACKET_WIDTH) - 1) continue;
+		int source = g * RAY_PACKET_WIDTH + getFirstLane(groupLanes);
+		for (int i = g * RAY_PACKET_WIDTH; i < (g + 1) * RAY_PACKET_WIDTH; ++i)
+		{
+			if ((m_lanes >> i) & 1) continue;
+			for (int k = 0; k < 3; ++k)
+			{
+				m_origins[k][i] = m_origins[k][source];
+				m_directions[k][i] = m_directions[k][source];
+				m_unitDirections[k][i] = m_unitDirections[k][source];
+				m_invDirections[k][i] = m_invDirections[k][source];
+			}
+			m_tmin[i] = m_tmin[source];
+			m_tmax[i] = m_tmax[source];
+		}
+	}
+
+	// the normalized direction of Group::intersect and of every primitive, for the lanes of setRay
+	for (int g = 0; g < RAY_PACKET_GROUPS; ++g)
+	{
+		if (getGroupLanes(m_rayLanes, g) == 0) continue;
+		int first = g * RAY_PACKET_WIDTH;
+		Vectors directions(Floats::load(m_directions[0] + first), Floats::load(m_directions[1] + first), Floats::load(m_directions[2] + first));
+		Vectors unitDirs = directions.normalized();
+		Vectors invDirs = unitDirs.reciprocal();
+		for (int k = 0; k < 3; ++k)
+		{
+			unitDirs[k].store(m_unitDirections[k] + first);
+			invDirs[k].store(m_invDirections[k] + first);
+		}
+	}
+	m_rayLanes = 0;
+
+	// a frustum needs a shared origin, and rays that don't go backwards from it.
+	// Every lane of a group holding a ray is one now, so whole groups are tested
+	int first = getFirstLane(m_lanes);
+	Vectors origin(getOrigin(first));
+	Vectors sum(0.f);
+	Floats zero(0.f);
+	for (int g = 0; g < RAY_PACKET_GROUPS; ++g)
+	{
+		if (getGroupLanes(m_lanes, g) == 0) continue;
+		Vectors o = getOrigins(g);
+		if (!((o[0] == origin[0]) & (o[1] == origin[1]) & (o[2] == origin[2]) & (getTMins(g) >= zero)).all())
+			return;
+		sum += getUnitDirections(g);
+	}
+	Vector3f direction(0.f);
+	for (int i = 0; i < RAY_PACKET_WIDTH; ++i)
+	{
+		direction += sum.get(i);
+	}
+
+	// the rays cross the plane orthogonal to their main axis k:
+	// bound the coordinates a and b of those crossings, (a / k) and (b / k) along the rays
+	int k = (std::fabs(direction[0]) > std::fabs(direction[1])) ? 0 : 1;
+	k = (std::fabs(direction[2]) > std::fabs(direction[k])) ? 2 : k;
+	int a = (k + 1) % 3, b = (k + 2) % 3;
+	float sign = (direction[k] < 0) ? -1.f : 1.f;
+	Floats aMin(FLT_MAX), aMax(-FLT_MAX), bMin(FLT_MAX), bMax(-FLT_MAX);
+	for (int g = 0; g < RAY_PACKET_GROUPS; ++g)
+	{
+		if (getGroupLanes(m_lanes, g) == 0) continue;
+		Vectors dir = getUnitDirections(g);
+		if (!(dir[k] * sign > zero).all())
+			return;
+		Floats da = dir[a] / dir[k], db = dir[b] / dir[k];
+		aMin = Floats::min(da, aMin);
+		aMax = Floats::max(da, aMax);
+		bMin = Floats::min(db, bMin);
+		bMax = Floats::max(db, bMax);
+	}
+	float bounds[4] = { aMin[0], -aMax[0], bMin[0], -bMax[0] };
+	for (int i = 1; i < RAY_PACKET_WIDTH; ++i)
+	{
+		bounds[0] = std::min(bounds[0], aMin[i]);
+		bounds[1] = std::min(bounds[1], -aMax[i]);
+		bounds[2] = std::min(bounds[2], bMin[i]);
+		bounds[3] = std::min(bounds[3], -bMax[i]);
+	}
+
+	// dot(normal, t * dir) = t * dir[k] * sign * (dir[a] / dir[k] - aMin) >= 0 for the first plane, and so on
+	m_frustumOrigin = getOrigin(first);
+	const int axes[4] = { a, a, b, b };
+	for (int p = 0; p < 4; ++p)
+	{
+		Vector3f normal(0.f);
+		float side = (p % 2 == 0) ? 1.f : -1.f;
+		normal[axes[p]] = sign * side;
+		normal[k] = -sign * bounds[p];
+		m_planeNormals[p] = normal;
+	}
+	// nothing behind the origin
+	m_planeNormals[4] = Vector3f(0.f);
+	m_planeNormals[4][k] = sign;
+	m_planeCount = 5;
+}
+#pragma endregion
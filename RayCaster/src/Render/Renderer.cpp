@@ -0,0 +1,452 @@
+#include "Renderer.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <float.h>
+
+////////////////////////////////
+// Renderer class Implementation
+////////////////////////////////
+
+///////////////
+// Constructors
+///////////////
+#pragma region Constructors
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static std::atomic<bool> packetsEnabled(true);
+
+Renderer::Renderer(int threadCount, int tileSize) :
+m_threadCount(0),
+m_tileSize(tileSize > 0 ? tileSize : 32),
+m_pool(NULL),
+m_stats(),
+m_display(NULL),
+m_isCancelled(false),
+m_tilesDone(0),
+m_tileCount(0),
+m_traceNanoseconds(0),
+m_shadeNanoseconds(0),
+m_nodeVisits(0),
+m_intersectionTests(0),
+m_pixelCosts(),
+m_costWidth(0),
+m_costHeight(0)
+{
+	setThreadCount(threadCount);
+}
+
+Renderer::~Renderer()
+{
+	delete m_pool;
+}
+#pragma endregion
+//////////
+// Utility
+//////////
+#pragma region Utility
+
+int Renderer::getThreadCount() const
+{
+	return m_threadCount;
+}
+
+void Renderer::setThreadCount(int threadCount)
+{
+	if (threadCount <= 0)
+	{
+		threadCount = std::thread::hardware_concurrency();
+		if (threadCount <= 0) threadCount = 1;
+	}
+	if (m_pool != NULL && threadCount == m_threadCount) return;
+
+	// the pool is kept alive between renders, only rebuilt when the count changes
+	delete m_pool;
+	m_pool = NULL;
+	m_threadCount = threadCount;
+	if (m_threadCount > 1)
+	{
+		m_pool = new ThreadPool(m_threadCount);
+	}
+}
+
+void Renderer::setDisplayBuffer(DisplayBuffer* display)
+{
+	m_display = display;
+}
+
+DisplayBuffer* Renderer::getDisplayBuffer() const
+{
+	return m_display;
+}
+
+void Renderer::cancel()
+{
+	m_isCancelled = true;
+}
+
+void Renderer::resetCancel()
+{
+	m_isCancelled = false;
+}
+
+float Renderer::getProgress() const
+{
+	int tileCount = m_tileCount;
+	return (tileCount > 0) ? (float)m_tilesDone / tileCount : 0.f;
+}
+
+const RenderStats& Renderer::getLastStats() const
+{
+	return m_stats;
+}
+
+int Renderer::getTileSize() const
+{
+	return m_tileSize;
+}
+
+void Renderer::setTileSize(int tileSize)
+{
+	m_tileSize = (tileSize > 0) ? tileSize : 1;
+}
+
+std::vector<RenderTile> Renderer::makeTiles(int width, int height, int tileSize)
+{
+	std::vector<RenderTile> tiles;
+	for (int y = 0; y < height; y += tileSize)
+	{
+		for (int x = 0; x < width; x += tileSize)
+		{
+			RenderTile tile;
+			tile.x0 = x;
+			tile.y0 = y;
+			tile.x1 = (x + tileSize < width) ? x + tileSize : width;
+			tile.y1 = (y + tileSize < height) ? y + tileSize : height;
+			tiles.push_back(tile);
+		}
+	}
+	return tiles;
+}
+
+void Renderer::setPacketsEnabled(bool enabled)
+{
+	packetsEnabled = enabled;
+}
+
+bool Renderer::arePacketsEnabled()
+{
+	return packetsEnabled;
+}
+
+bool Renderer::hasCounters()
+{
+#ifdef RAYCASTER_COUNTERS
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool Renderer::getHeatmap(Image& heatmap) const
+{
+	if (!hasCounters() || m_pixelCosts.empty()) return false;
+	if (heatmap.Width() != m_costWidth || heatmap.Height() != m_costHeight) return false;
+
+	int maxCost = 1;
+	for (unsigned int i = 0; i < m_pixelCosts.size(); ++i)
+	{
+		if (m_pixelCosts[i] > maxCost) maxCost = m_pixelCosts[i];
+	}
+	for (int y = 0; y < m_costHeight; ++y)
+	{
+		for (int x = 0; x < m_costWidth; ++x)
+		{
+			heatmap.SetPixel(x, y, heatColor((float)m_pixelCosts[y * m_costWidth + x] / maxCost));
+		}
+	}
+	return true;
+}
+
+Vector3f Renderer::heatColor(float cost)
+{
+	// blue -> cyan -> green -> yellow -> red
+	static const Vector3f ramp[5] = {
+		Vector3f(0.f, 0.f, 1.f), Vector3f(0.f, 1.f, 1.f), Vector3f(0.f, 1.f, 0.f), Vector3f(1.f, 1.f, 0.f), Vector3f(1.f, 0.f, 0.f) };
+	cost = (cost < 0.f) ? 0.f : (cost > 1.f ? 1.f : cost) * 4.f;
+	int i = (cost >= 4.f) ? 3 : (int)cost;
+	float f = cost - i;
+	return ramp[i] * (1.f - f) + ramp[i + 1] * f;
+}
+#pragma endregion
+/////////
+// Render
+/////////
+#pragma region Render
+
+bool Renderer::render(const Scene& scene, Image& image, const TileCallback& onTileDone)
+{
+	Clock::time_point start = Clock::now();
+	m_tilesDone = 0;
+	m_traceNanoseconds = 0;
+	m_shadeNanoseconds = 0;
+	m_nodeVisits = 0;
+	m_intersectionTests = 0;
+#ifdef RAYCASTER_COUNTERS
+	m_costWidth = image.Width();
+	m_costHeight = image.Height();
+	m_pixelCosts.assign(m_costWidth * m_costHeight, 0);
+#endif
+
+	assert(m_display == NULL || (m_display->Width() == image.Width() && m_display->Height() == image.Height()));
+
+	// lazy structures must be built before several threads start reading them
+	scene.getGroup()->prepare();
+	scene.getLightBVH()->prepare();
+
+	std::vector<RenderTile> tiles = makeTiles(image.Width(), image.Height(), m_tileSize);
+	m_tileCount = tiles.size();
+	if (m_pool == NULL)
+	{
+		for (unsigned int i = 0; i < tiles.size(); ++i)
+		{
+			renderTile(scene, image, tiles[i], onTileDone);
+		}
+	}
+	else
+	{
+		m_pool->parallelFor(tiles.size(), [&](int i)
+		{
+			renderTile(scene, image, tiles[i], onTileDone);
+		});
+	}
+
+	m_stats.wallSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+	m_stats.traceSeconds = m_traceNanoseconds * 1e-9;
+	m_stats.shadeSeconds = m_shadeNanoseconds * 1e-9;
+	m_stats.primaryRays = (long long)image.Width() * image.Height();
+	m_stats.nodeVisits = m_nodeVisits;
+	m_stats.intersectionTests = m_intersectionTests;
+	return !m_isCancelled;
+}
+
+void Renderer::renderTile(const Scene& scene, Image& image, const RenderTile& tile, const TileCallback& onTileDone)
+{
+	// queued tiles are still handed out after a cancel, they just return
+	if (m_isCancelled) return;
+
+	// trace the whole tile first, then shade it, so both phases can be timed
+	bool usePackets = packetsEnabled;
+	int tileWidth = tile.x1 - tile.x0;
+	int pixelCount = tileWidth * (tile.y1 - tile.y0);
+	std::vector<Ray> rays;
+	std::vector<Hit> hits(pixelCount);
+	rays.reserve(pixelCount);
+
+#ifdef RAYCASTER_COUNTERS
+	long long tileNodeVisits = 0;
+	long long tileIntersectionTests = 0;
+#endif
+
+	Clock::time_point t0 = Clock::now();
+	float tmin = scene.getCamera()->getTMin();
+	if (usePackets)
+	{
+		for (int y = tile.y0; y < tile.y1; ++y)
+		{
+			for (int x = tile.x0; x < tile.x1; ++x)
+			{
+				rays.push_back(generatePrimaryRay(scene, x, y, image.Width(), image.Height()));
+			}
+		}
+		// one packet per block of pixels, a row of the block per SIMD group
+		for (int by = tile.y0; by < tile.y1; by += RENDERER_PACKET_BLOCK_SIZE)
+		{
+			for (int bx = tile.x0; bx < tile.x1; bx += RENDERER_PACKET_BLOCK_SIZE)
+			{
+				int blockWidth = std::min(RENDERER_PACKET_BLOCK_SIZE, tile.x1 - bx);
+				int blockHeight = std::min(RENDERER_PACKET_BLOCK_SIZE, tile.y1 - by);
+				RayPacket packet;
+				for (int j = 0; j < blockHeight; ++j)
+				{
+					for (int i = 0; i < blockWidth; ++i)
+					{
+						int pixel = (by - tile.y0 + j) * tileWidth + bx - tile.x0 + i;
+						packet.setRay(j * RENDERER_PACKET_BLOCK_SIZE + i, rays[pixel], &hits[pixel], tmin);
+					}
+				}
+				packet.prepare();
+#ifdef RAYCASTER_COUNTERS
+				RayCounters& counters = RayCounters::local();
+				counters.reset();
+#endif
+				scene.getGroup()->intersect(packet, packet.getLanes());
+#ifdef RAYCASTER_COUNTERS
+				// the packet visits nodes for all its rays, share its cost evenly
+				int pixelCost = (int)(counters.getTotal() / (blockWidth * blockHeight));
+				for (int j = 0; j < blockHeight; ++j)
+				{
+					for (int i = 0; i < blockWidth; ++i)
+					{
+						m_pixelCosts[(by + j) * m_costWidth + bx + i] = pixelCost;
+					}
+				}
+				tileNodeVisits += counters.nodeVisits;
+				tileIntersectionTests += counters.intersectionTests;
+#endif
+			}
+		}
+	}
+	else
+	{
+		for (int y = tile.y0; y < tile.y1; ++y)
+		{
+			for (int x = tile.x0; x < tile.x1; ++x)
+			{
+				rays.push_back(generatePrimaryRay(scene, x, y, image.Width(), image.Height()));
+#ifdef RAYCASTER_COUNTERS
+				RayCounters& counters = RayCounters::local();
+				counters.reset();
+#endif
+				scene.getGroup()->intersect(rays.back(), hits[rays.size() - 1], tmin);
+#ifdef RAYCASTER_COUNTERS
+				// tiles don't overlap, each pixel is written by a single thread
+				m_pixelCosts[y * m_costWidth + x] = (int)counters.getTotal();
+				tileNodeVisits += counters.nodeVisits;
+				tileIntersectionTests += counters.intersectionTests;
+#endif
+			}
+		}
+	}
+	Clock::time_point t1 = Clock::now();
+	std::vector<Vector3f> surfaceColors;
+	getSurfaceColors(hits, surfaceColors);
+	for (int i = 0; i < pixelCount; ++i)
+	{
+		image.SetPixel(tile.x0 + i % tileWidth, tile.y0 + i / tileWidth, shade(scene, rays[i], hits[i], surfaceColors[i]));
+	}
+	Clock::time_point t2 = Clock::now();
+
+	m_traceNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+	m_shadeNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count();
+#ifdef RAYCASTER_COUNTERS
+	m_nodeVisits += tileNodeVisits;
+	m_intersectionTests += tileIntersectionTests;
+#endif
+	if (m_display != NULL) m_display->Convert(image, tile.x0, tile.y0, tile.x1, tile.y1);
+	m_tilesDone++;
+	if (onTileDone) onTileDone(tile);
+}
+
+Vector3f Renderer::renderPixel(const Scene& scene, int x, int y, int width, int height)
+{
+	Hit hit;
+	Ray ray = generatePrimaryRay(scene, x, y, width, height);
+	scene.getGroup()->intersect(ray, hit, scene.getCamera()->getTMin());
+	return shade(scene, ray, hit);
+}
+
+Ray Renderer::generatePrimaryRay(const Scene& scene, int x, int y, int width, int height)
+{
+	float fx = (float)x;
+	float fy = (float)y;
+	Vector2f pixelSize(2.f / (width - 1), 2.f / (height - 1));
+	return scene.getCamera()->generateRay(Vector2f(2 * fx / (width - 1) - 1, 2 * fy / (height - 1) - 1), pixelSize);
+}
+
+Vector3f Renderer::shade(const Scene& scene, const Ray& ray, const Hit& hit)
+{
+	if (hit.getT() < FLT_MAX)
+	{
+		return shade(scene, ray, hit, hit.getMaterial()->getSurfaceColor(hit));
+	}
+	return scene.getBackgroundColor();
+}
+
+void Renderer::getSurfaceColors(const std::vector<Hit>& hits, std::vector<Vector3f>& colors)
+{
+	// pixels of each texture, a tile rarely sees more than a few textures
+	std::vector<const Texture*> textures;
+	std::vector<std::vector<int> > texturePixels;
+	colors.resize(hits.size());
+	for (unsigned int i = 0; i < hits.size(); ++i)
+	{
+		const Hit& hit = hits[i];
+		if (hit.getT() == FLT_MAX) continue;
+		const Texture* texture = hit.getMaterial()->getTexture().get();
+		if (!hit.hasTex || texture == NULL || !texture->valid())
+		{
+			colors[i] = hit.getMaterial()->getDiffuseColor();
+			continue;
+		}
+		unsigned int t = 0;
+		while (t < textures.size() && textures[t] != texture) ++t;
+		if (t == textures.size())
+		{
+			textures.push_back(texture);
+			texturePixels.push_back(std::vector<int>());
+		}
+		texturePixels[t].push_back(i);
+	}
+
+	std::vector<float> u, v, lod;
+	std::vector<Vector3f> texels;
+	for (unsigned int t = 0; t < textures.size(); ++t)
+	{
+		const std::vector<int>& pixels = texturePixels[t];
+		u.resize(pixels.size());
+		v.resize(pixels.size());
+		lod.resize(pixels.size());
+		texels.resize(pixels.size());
+		for (unsigned int k = 0; k < pixels.size(); ++k)
+		{
+			const Hit& hit = hits[pixels[k]];
+			u[k] = hit.texCoord.x();
+			v[k] = hit.texCoord.y();
+			lod[k] = textures[t]->getLevelOfDetail(hit.texCoordDx, hit.texCoordDy);
+		}
+		textures[t]->sample(&u[0], &v[0], &lod[0], pixels.size(), &texels[0]);
+		for (unsigned int k = 0; k < pixels.size(); ++k)
+		{
+			colors[pixels[k]] = texels[k];
+		}
+	}
+}
+
+Vector3f Renderer::shade(const Scene& scene, const Ray& ray, const Hit& hit, const Vector3f& surfaceColor)
+{
+	Vector3f dirToLight;
+	Vector3f lightCol;
+	float distToLight;
+
+	Vector3f pixCol(0.f, 0.f, 0.f);
+	if (hit.getT() < FLT_MAX)
+	{
+		// hits are measured along the normalized direction
+		Vector3f point = ray.getOrigin() + ray.getDirection().normalized() * hit.getT();
+		float shadowTMin = RENDERER_SHADOW_EPSILON * (1.f + std::max(std::fabs(point[0]), std::max(std::fabs(point[1]), std::fabs(point[2]))));
+		// only the lights whose radius reaches the point, unbounded ones first in scene order
+		auto shadeLight = [&](const Light* light)
+		{
+			light->getIllumination(point, dirToLight, lightCol, distToLight);
+			// beyond the radius or black: no need for a shadow ray
+			if (lightCol[0] == 0 && lightCol[1] == 0 && lightCol[2] == 0)
+				return;
+			// any blocker is enough, no need for the closest one
+			if (scene.areShadowsEnabled() && scene.getGroup()->occluded(Ray(point, dirToLight), shadowTMin, distToLight))
+				return;
+			pixCol += hit.getMaterial()->Shade(ray, hit, dirToLight, lightCol, surfaceColor);
+		};
+		scene.getLightBVH()->visit(point, shadeLight);
+
+		pixCol += scene.getAmbientLight() * hit.getMaterial()->getDiffuseColor();
+	}
+	else
+	{
+		pixCol = scene.getBackgroundColor();
+	}
+	return pixCol;
+}
+#pragma endregion
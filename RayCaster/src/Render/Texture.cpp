@@ -1,63 +1,363 @@
 #include "Texture.h"
 #include "bitmap_image.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEXTURE_SSE2
+#include <emmintrin.h>
+#endif
 
 ///////////////////////////
 // Texture Implementation
 //
 // Nicolas Bordes - 10/2016
 ///////////////////////////
-void Texture::load(const char * filename)
+
+// the four texels of a bilinear footprint and their weights
+struct TexelFootprint {
+	unsigned int texel[4];
+	float weight[4];
+};
+
+// ((1 - a)(1 - b), a(1 - b), (1 - a)b, ab) weighted sum of the four texels, in [0, 1]
+static inline void filter(const TexelFootprint& f, Vector3f& color)
 {
-	bimg = new bitmap_image(filename);
-	height = bimg->height();
-	width = bimg->width();
+#ifdef TEXTURE_SSE2
+	// one texel per register, r g b a in the four lanes
+	const __m128i zero = _mm_setzero_si128();
+	__m128 sum = _mm_setzero_ps();
+	for (int kk = 0; kk < 4; kk++) {
+		__m128i t = _mm_cvtsi32_si128((int)f.texel[kk]);
+		t = _mm_unpacklo_epi16(_mm_unpacklo_epi8(t, zero), zero);
+		__m128 term = _mm_mul_ps(_mm_set1_ps(f.weight[kk]), _mm_cvtepi32_ps(t));
+		sum = (kk == 0) ? term : _mm_add_ps(sum, term);
+	}
+	float lanes[4];
+	_mm_storeu_ps(lanes, _mm_div_ps(sum, _mm_set1_ps(255.f)));
+	color = Vector3f(lanes[0], lanes[1], lanes[2]);
+#else
+	for (int ii = 0; ii < 3; ii++) {
+		float sum = f.weight[0] * ((f.texel[0] >> (8 * ii)) & 0xFF);
+		for (int kk = 1; kk < 4; kk++) {
+			sum += f.weight[kk] * ((f.texel[kk] >> (8 * ii)) & 0xFF);
+		}
+		color[ii] = sum / 255;
+	}
+#endif
 }
 
+static std::atomic<bool> mipmapsEnabled(true);
 
-void Texture::operator()(int x, int y, unsigned char * color)
+void Texture::setMipmapsEnabled(bool enabled)
+{
+	mipmapsEnabled = enabled;
+}
+
+bool Texture::areMipmapsEnabled()
+{
+	return mipmapsEnabled;
+}
+
+bool Texture::load(const char * filename)
+{
+	texels.clear();
+	levels.clear();
+	width = 0;
+	height = 0;
+	bitmap_image bimg(filename);
+	if (bimg.width() == 0 || bimg.height() == 0) {
+		return false;
+	}
+	width = bimg.width();
+	height = bimg.height();
+
+	addLevel(width, height);
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			unsigned char r, g, b;
+			bimg.get_pixel(x, y, r, g, b);
+			texels[getTexelIndex(0, x, y)] = r | (g << 8) | (b << 16) | 0xFF000000u;
+		}
+	}
+
+	// each level averages 2x2 texels of the previous one, an odd last row or column is dropped
+	while (levels.back().width > 1 || levels.back().height > 1) {
+		int prev = (int)levels.size() - 1;
+		int prevWidth = levels[prev].width, prevHeight = levels[prev].height;
+		addLevel(prevWidth > 1 ? prevWidth / 2 : 1, prevHeight > 1 ? prevHeight / 2 : 1);
+		const MipLevel& level = levels.back();
+		for (int y = 0; y < level.height; y++) {
+			int y0 = 2 * y, y1 = (2 * y + 1 < prevHeight) ? 2 * y + 1 : 2 * y;
+			for (int x = 0; x < level.width; x++) {
+				int x0 = 2 * x, x1 = (2 * x + 1 < prevWidth) ? 2 * x + 1 : 2 * x;
+				unsigned int quad[4] = {
+					texels[getTexelIndex(prev, x0, y0)], texels[getTexelIndex(prev, x1, y0)],
+					texels[getTexelIndex(prev, x0, y1)], texels[getTexelIndex(prev, x1, y1)] };
+				unsigned int texel = 0;
+				for (int ii = 0; ii < 4; ii++) {
+					unsigned int sum = 2;
+					for (int kk = 0; kk < 4; kk++) {
+						sum += (quad[kk] >> (8 * ii)) & 0xFF;
+					}
+					texel |= (sum / 4) << (8 * ii);
+				}
+				texels[getTexelIndex(prev + 1, x, y)] = texel;
+			}
+		}
+	}
+	return true;
+}
+
+void Texture::addLevel(int w, int h)
+{
+	// padded to whole tiles, the padding is never read since lookups clamp to the level
+	int tileCountX = (w + TEXTURE_TILE_SIZE - 1) / TEXTURE_TILE_SIZE;
+	int tileCountY = (h + TEXTURE_TILE_SIZE - 1) / TEXTURE_TILE_SIZE;
+	const int tileTexels = TEXTURE_TILE_SIZE * TEXTURE_TILE_SIZE;
+	int base = (int)texels.size();
+	texels.resize(texels.size() + (size_t)tileCountX * tileCountY * tileTexels, 0);
+
+	levels.push_back(MipLevel());
+	MipLevel& level = levels.back();
+	level.width = w;
+	level.height = h;
+	level.rowOffsets.resize(h);
+	for (int y = 0; y < h; y++) {
+		level.rowOffsets[y] = base + (y / TEXTURE_TILE_SIZE) * tileCountX * tileTexels + (y % TEXTURE_TILE_SIZE) * TEXTURE_TILE_SIZE;
+	}
+	level.columnOffsets.resize(w);
+	for (int x = 0; x < w; x++) {
+		level.columnOffsets[x] = (x / TEXTURE_TILE_SIZE) * tileTexels + x % TEXTURE_TILE_SIZE;
+	}
+}
+
+int Texture::getTexelIndex(int level, int x, int y) const
+{
+	return levels[level].rowOffsets[y] + levels[level].columnOffsets[x];
+}
+
+void Texture::operator()(int x, int y, unsigned char * color) const
 {
 	x = clamp(x, 0, width - 1);
 	y = clamp(y, 0, height - 1);
-	bimg->get_pixel(x, y, color[0], color[1], color[2]);
+	unsigned int texel = texels[getTexelIndex(0, x, y)];
+	color[0] = texel & 0xFF;
+	color[1] = (texel >> 8) & 0xFF;
+	color[2] = (texel >> 16) & 0xFF;
+}
+
+bool Texture::valid() const
+{
+	return !texels.empty();
+}
+
+size_t Texture::getMemorySize() const
+{
+	size_t size = texels.size() * sizeof(unsigned int);
+	for (unsigned int i = 0; i < levels.size(); i++) {
+		size += (levels[i].rowOffsets.size() + levels[i].columnOffsets.size()) * sizeof(int);
+	}
+	return size;
+}
+
+int Texture::getWidth() const
+{
+	return width;
 }
-bool Texture::valid()
+
+int Texture::getHeight() const
+{
+	return height;
+}
+
+int Texture::getLevelCount() const
 {
-	return bimg != 0;
+	return (int)levels.size();
 }
+
+float Texture::getLevelOfDetail(const Vector2f& dx, const Vector2f& dy) const
+{
+	// longest side of the pixel footprint, in texels of the full resolution level
+	Vector2f size((float)width, (float)height);
+	float footprint = std::max((dx * size).absSquared(), (dy * size).absSquared());
+	return (footprint > 1.f) ? 0.5f * std::log2(footprint) : 0.f;
+}
+
 ///@param x assumed to be between 0 and 1
+Vector3f Texture::operator()(float x, float y) const
+{
+	Vector3f color;
+	sample(&x, &y, 1, &color);
+	return color;
+}
 
-Vector3f Texture::operator()(float x, float y)
+Vector3f Texture::operator()(float x, float y, float lod) const
 {
 	Vector3f color;
-	int ix, iy;
-	x = x*width;
-	y = (1 - y)*height;
-	ix = (int)x;
-	iy = (int)y;
-	unsigned char pixels[4][3];
-	float alpha = x - ix;
-	float beta = y - iy;
-	operator()(ix, iy, pixels[0]);
-	operator()(ix + 1, iy, pixels[1]);
-	operator()(ix, iy + 1, pixels[2]);
-	operator()(ix + 1, iy + 1, pixels[3]);
-	for (int ii = 0;ii<3;ii++) {
-		color[ii] = (1 - alpha)*(1 - beta)*pixels[0][ii]
-			+ alpha *(1 - beta)*pixels[1][ii]
-			+ (1 - alpha)*   beta *pixels[2][ii]
-			+ alpha *   beta *pixels[3][ii];
-	}
-	return color / 255;
+	sample(&x, &y, &lod, 1, &color);
+	return color;
 }
 
-Texture::~Texture()
+void Texture::sample(const float * x, const float * y, int count, Vector3f * colors) const
 {
-	if (bimg != 0) {
-		delete bimg;
+	sampleLevel(0, x, y, count, colors);
+}
+
+void Texture::sample(const float * x, const float * y, const float * lod, int count, Vector3f * colors) const
+{
+	int levelCount = (int)levels.size();
+	if (!mipmapsEnabled || levelCount <= 1) {
+		sampleLevel(0, x, y, count, colors);
+		return;
+	}
+
+	// each lookup reads the two levels around its lod: the reads of a chunk are sorted
+	// by level so every level is filtered in one batch, then blended into colors
+	const int chunkSize = 64;
+	int levelStart[TEXTURE_MAX_LEVELS + 2];
+	int lookups[2 * chunkSize];
+	float weights[2 * chunkSize], xs[2 * chunkSize], ys[2 * chunkSize];
+	Vector3f levelColors[2 * chunkSize];
+	int lower[chunkSize];
+	float fraction[chunkSize];
+	for (int first = 0; first < count; first += chunkSize) {
+		int n = std::min(chunkSize, count - first);
+		int minLevel = levelCount, maxLevel = 0;
+		for (int ii = 0; ii < n; ii++) {
+			float l = std::min(std::max(lod[first + ii], 0.f), (float)(levelCount - 1));
+			lower[ii] = (int)l;
+			fraction[ii] = l - lower[ii];
+			int upper = (fraction[ii] > 0) ? lower[ii] + 1 : lower[ii];
+			minLevel = std::min(minLevel, lower[ii]);
+			maxLevel = std::max(maxLevel, upper);
+		}
+		if (minLevel == maxLevel) {
+			// a single level, no blending
+			sampleLevel(minLevel, x + first, y + first, n, colors + first);
+			continue;
+		}
+
+		for (int l = minLevel; l <= maxLevel + 1; l++) {
+			levelStart[l] = 0;
+		}
+		for (int ii = 0; ii < n; ii++) {
+			levelStart[lower[ii] + 1]++;
+			if (fraction[ii] > 0) levelStart[lower[ii] + 2]++;
+		}
+		for (int l = minLevel; l <= maxLevel; l++) {
+			levelStart[l + 1] += levelStart[l];
+		}
+		int next[TEXTURE_MAX_LEVELS + 1];
+		for (int l = minLevel; l <= maxLevel; l++) {
+			next[l] = levelStart[l];
+		}
+		for (int ii = 0; ii < n; ii++) {
+			int k = next[lower[ii]]++;
+			lookups[k] = ii;
+			weights[k] = 1 - fraction[ii];
+			xs[k] = x[first + ii];
+			ys[k] = y[first + ii];
+			if (fraction[ii] > 0) {
+				k = next[lower[ii] + 1]++;
+				lookups[k] = ii;
+				weights[k] = fraction[ii];
+				xs[k] = x[first + ii];
+				ys[k] = y[first + ii];
+			}
+			colors[first + ii] = Vector3f(0.f);
+		}
+		for (int l = minLevel; l <= maxLevel; l++) {
+			int start = levelStart[l];
+			if (levelStart[l + 1] > start) {
+				sampleLevel(l, xs + start, ys + start, levelStart[l + 1] - start, levelColors + start);
+			}
+		}
+		for (int k = 0; k < levelStart[maxLevel + 1]; k++) {
+			colors[first + lookups[k]] += weights[k] * levelColors[k];
+		}
+	}
+}
+
+void Texture::sampleLevel(int level, const float * x, const float * y, int count, Vector3f * colors) const
+{
+	const MipLevel& mip = levels[level];
+	TexelFootprint f;
+	int ii = 0;
+#ifdef TEXTURE_SSE2
+	// coordinates, weights and clamped texel positions of 4 lookups at once
+	const __m128 w = _mm_set1_ps((float)mip.width);
+	const __m128 h = _mm_set1_ps((float)mip.height);
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i oneI = _mm_set1_epi32(1);
+	const __m128i maxX = _mm_set1_epi32(mip.width - 1);
+	const __m128i maxY = _mm_set1_epi32(mip.height - 1);
+	for (; ii + 4 <= count; ii += 4) {
+		__m128 fx = _mm_mul_ps(_mm_loadu_ps(x + ii), w);
+		__m128 fy = _mm_mul_ps(_mm_sub_ps(one, _mm_loadu_ps(y + ii)), h);
+		__m128i ix = _mm_cvttps_epi32(fx);
+		__m128i iy = _mm_cvttps_epi32(fy);
+		__m128 alpha = _mm_sub_ps(fx, _mm_cvtepi32_ps(ix));
+		__m128 beta = _mm_sub_ps(fy, _mm_cvtepi32_ps(iy));
+		__m128 alpha1 = _mm_sub_ps(one, alpha);
+		__m128 beta1 = _mm_sub_ps(one, beta);
+		float weights[4][4];
+		_mm_storeu_ps(weights[0], _mm_mul_ps(alpha1, beta1));
+		_mm_storeu_ps(weights[1], _mm_mul_ps(alpha, beta1));
+		_mm_storeu_ps(weights[2], _mm_mul_ps(alpha1, beta));
+		_mm_storeu_ps(weights[3], _mm_mul_ps(alpha, beta));
+
+		// clamp to the edges, SSE2 has no 32 bit min max
+		__m128i positions[4] = { ix, _mm_add_epi32(ix, oneI), iy, _mm_add_epi32(iy, oneI) };
+		int clamped[4][4];
+		for (int kk = 0; kk < 4; kk++) {
+			__m128i p = positions[kk];
+			__m128i hi = (kk < 2) ? maxX : maxY;
+			__m128i above = _mm_cmpgt_epi32(p, hi);
+			p = _mm_or_si128(_mm_and_si128(above, hi), _mm_andnot_si128(above, p));
+			p = _mm_andnot_si128(_mm_cmplt_epi32(p, zero), p);
+			_mm_storeu_si128((__m128i*)clamped[kk], p);
+		}
+
+		for (int jj = 0; jj < 4; jj++) {
+			f.texel[0] = texels[getTexelIndex(level, clamped[0][jj], clamped[2][jj])];
+			f.texel[1] = texels[getTexelIndex(level, clamped[1][jj], clamped[2][jj])];
+			f.texel[2] = texels[getTexelIndex(level, clamped[0][jj], clamped[3][jj])];
+			f.texel[3] = texels[getTexelIndex(level, clamped[1][jj], clamped[3][jj])];
+			for (int kk = 0; kk < 4; kk++) {
+				f.weight[kk] = weights[kk][jj];
+			}
+			filter(f, colors[ii + jj]);
+		}
+	}
+#endif
+	for (; ii < count; ii++) {
+		float fx = x[ii] * mip.width;
+		float fy = (1 - y[ii]) * mip.height;
+		int ix = (int)fx;
+		int iy = (int)fy;
+		float alpha = fx - ix;
+		float beta = fy - iy;
+		int x0 = clamp(ix, 0, mip.width - 1), x1 = clamp(ix + 1, 0, mip.width - 1);
+		int y0 = clamp(iy, 0, mip.height - 1), y1 = clamp(iy + 1, 0, mip.height - 1);
+		f.texel[0] = texels[getTexelIndex(level, x0, y0)];
+		f.texel[1] = texels[getTexelIndex(level, x1, y0)];
+		f.texel[2] = texels[getTexelIndex(level, x0, y1)];
+		f.texel[3] = texels[getTexelIndex(level, x1, y1)];
+		f.weight[0] = (1 - alpha) * (1 - beta);
+		f.weight[1] = alpha * (1 - beta);
+		f.weight[2] = (1 - alpha) * beta;
+		f.weight[3] = alpha * beta;
+		filter(f, colors[ii]);
 	}
 }
 
-Texture::Texture() :bimg(0), width(0), height(0)
+Texture::~Texture()
 {
 }
 
+Texture::Texture() :texels(), levels(), width(0), height(0)
+{
+}
@@ -0,0 +1,132 @@
+#include "TextureCache.h"
+#include "MappedFile.h"
+
+////////////////////////////////////
+// TextureCache class Implementation
+////////////////////////////////////
+
+TextureCache::TextureCache(size_t budget) :
+m_entries(),
+m_lru(),
+m_budget(budget),
+m_stats()
+{
+}
+
+TextureCache::~TextureCache()
+{
+}
+
+TextureCache& TextureCache::getGlobal()
+{
+	static TextureCache cache;
+	return cache;
+}
+
+std::shared_ptr<Texture> TextureCache::acquire(const std::string& filename)
+{
+	unsigned long long fileSize = 0;
+	long long fileTime = 0;
+	bool exists = MappedFile::getFileStatus(filename.c_str(), fileSize, fileTime);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	std::map<std::string, Entry>::iterator it = m_entries.find(filename);
+	if (it != m_entries.end())
+	{
+		if (exists && it->second.fileSize == fileSize && it->second.fileTime == fileTime)
+		{
+			m_stats.hits++;
+			m_lru.splice(m_lru.begin(), m_lru, it->second.lruPosition);
+			return it->second.texture;
+		}
+		// modified or deleted on disk
+		erase(it);
+	}
+
+	m_stats.misses++;
+	std::shared_ptr<Texture> texture = std::make_shared<Texture>();
+	if (!texture->load(filename.c_str()))
+	{
+		return std::shared_ptr<Texture>();
+	}
+
+	Entry& entry = m_entries[filename];
+	entry.texture = texture;
+	entry.fileSize = fileSize;
+	entry.fileTime = fileTime;
+	entry.bytes = texture->getMemorySize();
+	m_lru.push_front(filename);
+	entry.lruPosition = m_lru.begin();
+	m_stats.residentBytes += entry.bytes;
+	m_stats.residentCount++;
+
+	evict(m_budget);
+	return texture;
+}
+
+void TextureCache::setBudget(size_t budget)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_budget = budget;
+	evict(m_budget);
+}
+
+size_t TextureCache::getBudget() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_budget;
+}
+
+void TextureCache::trim()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	evict(m_budget);
+}
+
+void TextureCache::releaseUnused()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	evict(0);
+}
+
+TextureCacheStats TextureCache::getStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	TextureCacheStats stats = m_stats;
+	stats.budget = m_budget;
+	return stats;
+}
+
+void TextureCache::resetStats()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_stats.hits = 0;
+	m_stats.misses = 0;
+	m_stats.evictions = 0;
+}
+
+void TextureCache::evict(size_t budget)
+{
+	std::list<std::string>::iterator name = m_lru.end();
+	while (m_stats.residentBytes > budget && name != m_lru.begin())
+	{
+		--name;
+		std::map<std::string, Entry>::iterator it = m_entries.find(*name);
+		// the cache holds the only reference of an unused texture
+		if (it->second.texture.use_count() > 1) continue;
+		// erasing invalidates name: step back to its successor, the loop then moves to its predecessor
+		std::list<std::string>::iterator next = name;
+		++next;
+		erase(it);
+		m_stats.evictions++;
+		name = next;
+	}
+}
+
+void TextureCache::erase(std::map<std::string, Entry>::iterator it)
+{
+	m_stats.residentBytes -= it->second.bytes;
+	m_stats.residentCount--;
+	m_lru.erase(it->second.lruPosition);
+	m_entries.erase(it);
+}
@@ -16,16 +16,28 @@
 /////////////////////////////
 
 #define DegreesToRadians(x) ((M_PI * x) / 180.0f)
+#define RENDER_DISPLAY_INTERVAL_MS 50
 
 float coloritof(int i);
 int colorftoi(float f);
 
 RayCaster::RayCaster(QWidget *parent)
 	: QMainWindow(parent),
-	m_ui(Ui::RayCasterClass())
+	m_ui(Ui::RayCasterClass()),
+	m_isRendering(false),
+	m_isRenderCancelled(false),
+	m_displayedProgress(0.f),
+	m_renderImage(NULL),
+	m_renderDisplay(NULL),
+	m_renderItem(NULL)
 {
 	m_isLoading = false;
 	m_ui.setupUi(this);
+	// cancel sits next to the render button, only shown while rendering
+	m_ui.m_BtnCancelRender->setHidden(true);
+	// display updates are throttled to a fixed rate instead of following each tile
+	m_renderTimer = new QTimer(this);
+	m_renderTimer->setInterval(RENDER_DISPLAY_INTERVAL_MS);
 
 	// init camera
 	updateCam();
@@ -148,9 +160,27 @@ RayCaster::RayCaster(QWidget *parent)
 	// Render
 	///
 	connect(m_ui.m_BtnRender, SIGNAL(clicked(bool)), this, SLOT(slotRender(bool)));
+	connect(m_ui.m_BtnCancelRender, &QPushButton::clicked, this, [this]() { cancelRender(); });
+	connect(m_renderTimer, &QTimer::timeout, this, [this]() { updateRenderDisplay(); });
 	///
 }
 
+RayCaster::~RayCaster()
+{
+	if (m_renderThread.joinable())
+	{
+		m_renderer.cancel();
+		m_renderThread.join();
+	}
+	if (m_saveThread.joinable())
+	{
+		m_saveThread.join();
+	}
+	m_renderer.setDisplayBuffer(NULL);
+	delete m_renderImage;
+	delete m_renderDisplay;
+}
+
 void RayCaster::updateCam()
 {
 	Vector3f pos(m_ui.m_dSBoxCamPosX->value(), m_ui.m_dSBoxCamPosY->value(), m_ui.m_dSBoxCamPosZ->value());
@@ -180,7 +210,10 @@ void RayCaster::updateLight()
 
 	if (m_ui.m_rBtnPointLight->isChecked())
 	{
-		m_scene.modifyLight(currLight, new PointLight(dirPos, color));
+		// the radius has no widget, keep the one of the scene file
+		PointLight* previous = dynamic_cast<PointLight*>(m_scene.getLight(currLight));
+		float radius = (previous != NULL) ? previous->getRadius() : 0.f;
+		m_scene.modifyLight(currLight, new PointLight(dirPos, color, radius));
 	}
 	else
 	{
@@ -230,7 +263,8 @@ void RayCaster::updateObject()
 		struct stat buffer;
 		if (stat(m_ui.m_LEMeshFile->text().toStdString().c_str(), &buffer) == 0) // check file existence
 		{
-			object = new Mesh(m_ui.m_LEMeshFile->text().toStdString().c_str(), selectedMat);
+			// the geometry is shared: editing a transform doesn't read the file again
+			object = new Mesh(m_scene.getAssets().getMesh(m_ui.m_LEMeshFile->text().toStdString()), selectedMat);
 		}
 	}
 
@@ -250,6 +284,7 @@ void RayCaster::updateObject()
 		object = new Transform(mat, object);
 	}
 
+	// deletes the previous object
 	m_scene.getGroup()->modifyObject(currObj, object);
 
 	m_ui.m_objList->item(currObj)->setText(m_ui.m_LEObjName->text());
@@ -272,17 +307,21 @@ void RayCaster::updateMaterial()
 	Vector3f specColor = (isSpecChecked) ? Vector3f(coloritof(m_ui.m_SBoxSpecColR->value()), coloritof(m_ui.m_SBoxSpecColG->value()), coloritof(m_ui.m_SBoxSpecColB->value())) : Vector3f::ZERO;
 	float shininess = (isSpecChecked) ? m_ui.m_SBoxShininess->value() : 0;
 
-	Material * newmat = new Material(difColor, specColor, shininess);
+	// edited in place: the objects keep their pointer and see the change
+	Material * material = m_scene.getMaterial(currMat);
+	material->setDiffuseColor(difColor);
+	material->setSpecularColor(specColor);
+	material->setShininess(shininess);
 
-	// add texture if defined
+	// add texture if defined, loaded once per file
+	std::shared_ptr<Texture> texture;
 	std::string filename = m_ui.m_LETextureFile->text().toStdString();
 	struct stat buffer;
 	if (filename != "" && stat(filename.c_str(), &buffer) == 0) // check file existence
 	{
-		newmat->loadTexture(filename.c_str());
+		texture = m_scene.getAssets().getTexture(filename);
 	}
-
-	m_scene.modifyMaterial(currMat, newmat);
+	material->setTexture(texture);
 
 	m_ui.m_materialsList->item(currMat)->setText(m_ui.m_LEMaterialName->text());
 	m_ui.m_comboMaterial->setItemText(currMat, m_ui.m_LEMaterialName->text());
@@ -405,7 +444,7 @@ void RayCaster::slotObjectAdd(bool clicked)
 		struct stat buffer;
 		if (stat(m_ui.m_LEMeshFile->text().toStdString().c_str(), &buffer) == 0) // check file existence
 		{
-			object = new Mesh(m_ui.m_LEMeshFile->text().toStdString().c_str(), selectedMat);
+			object = new Mesh(m_scene.getAssets().getMesh(m_ui.m_LEMeshFile->text().toStdString()), selectedMat);
 		}
 	}
 	//Sphere* newObj = new Sphere(Vector3f(0), 1, m_scene.getMaterial());
@@ -419,6 +458,7 @@ void RayCaster::slotObjectRemove(bool clicked)
 	qDeleteAll(m_ui.m_objList->selectedItems());
 	int currRow = m_ui.m_objList->currentRow();
 	(currRow < 0) ? m_scene.getGroup()->removeObject(0) : m_scene.getGroup()->removeObject(currRow);
+	m_scene.getAssets().releaseUnused();
 	m_ui.m_objList->setCurrentRow(m_ui.m_objList->count() - 1);
 }
 
@@ -604,59 +644,100 @@ void RayCaster::slotMaterialBrowseTextFile(bool clicked)
 /////////
 void RayCaster::slotRender(bool clicked)
 {
-	QApplication::setOverrideCursor(Qt::WaitCursor);
+	if (m_renderThread.joinable()) return;
+
 	int width = m_ui.m_SBoxImgW->value();
 	int height = m_ui.m_SBoxImgH->value();
 	m_scene.setBackgroundColor(Vector3f(coloritof(m_ui.m_SBoxBackColR->value()), coloritof(m_ui.m_SBoxBackColG->value()), coloritof(m_ui.m_SBoxBackColB->value())));
 	m_scene.setAmbientLight(Vector3f(coloritof(m_ui.m_SBoxAmbLightR->value()), coloritof(m_ui.m_SBoxAmbLightG->value()), coloritof(m_ui.m_SBoxAmbLightB->value())));
-	Image image(width, height);
+
+	m_grScene->clear();
+	delete m_renderImage;
+	delete m_renderDisplay;
+	m_renderImage = new Image(width, height);
+	m_renderDisplay = new DisplayBuffer(width, height);
+	m_renderQImage = QImage(width, height, QImage::Format_RGB32);
+	m_renderDisplay->CopyDirty(m_renderQImage.bits(), m_renderQImage.bytesPerLine());
+	m_renderItem = m_grScene->addPixmap(QPixmap::fromImage(m_renderQImage));
+	m_ui.m_graphicView->show();
+	m_renderer.setDisplayBuffer(m_renderDisplay);
+	m_displayedProgress = 0.f;
+
+	// the scene must not change while the worker reads it
+	m_ui.m_tabScene->setEnabled(false);
+	m_ui.m_BtnRender->setEnabled(false);
+	m_ui.m_BtnCancelRender->setHidden(false);
 	m_ui.m_pBarRendering->setHidden(false);
+	m_ui.m_pBarRendering->setValue(0);
 
-	//float currt;
-	//float minT = FLT_MAX;
-	//float maxT = -FLT_MAX;
+	m_isRenderCancelled = false;
+	m_renderer.resetCancel();
+	m_isRendering = true;
+	m_renderThread = std::thread([this]()
+	{
+		m_renderer.render(m_scene, *m_renderImage);
+		m_isRendering = false;
+	});
+	m_renderTimer->start();
+}
 
-	Vector3f dirToLight;
-	Vector3f lightCol;
-	float distToLight;
+void RayCaster::cancelRender()
+{
+	m_isRenderCancelled = true;
+	m_renderer.cancel();
+}
 
-	for (float x = 0.f; x < width; ++x)
+void RayCaster::updateRenderDisplay()
+{
+	bool isDone = !m_isRendering;
+	// only the tiles converted so far are copied, the ones being written show at a later update
+	if (m_renderDisplay->CopyDirty(m_renderQImage.bits(), m_renderQImage.bytesPerLine()))
 	{
-		for (float y = 0.f; y < height; ++y)
-		{
-			Hit hit;
-			Ray ray = m_scene.getCamera()->generateRay(Vector2f(2 * x / (width - 1) - 1, 2 * y / (height - 1) - 1));
-			m_scene.getGroup()->intersect(ray, hit, m_scene.getCamera()->getTMin());
-			Vector3f pixCol(0.f, 0.f, 0.f);
-			if (hit.getT() < FLT_MAX)
-			{
-				for (int i = 0; i < m_scene.getNumLights(); ++i)
-				{
-					m_scene.getLight(i)->getIllumination(ray.pointAtParameter(hit.getT()), dirToLight, lightCol, distToLight);
-					pixCol += hit.getMaterial()->Shade(ray, hit, dirToLight, lightCol);
-				}
-
-				pixCol += m_scene.getAmbientLight() * hit.getMaterial()->getDiffuseColor();
-			}
-			else
-			{
-				pixCol = m_scene.getBackgroundColor();
-			}
-
-			image.SetPixel(x, y, pixCol);
-			m_ui.m_pBarRendering->setValue((int)((x * height + y) * 100) / (width * height));
-		}
+		m_renderItem->setPixmap(QPixmap::fromImage(m_renderQImage));
 	}
-	m_ui.m_pBarRendering->setValue(100);
-	image.SaveImage(m_ui.m_LEImgFilename->text().toStdString().c_str());
-	QImage qimage(m_ui.m_LEImgFilename->text());
-	//QGraphicsPixmapItem* item = new QGraphicsPixmapItem(QPixmap::fromImage(qimage));
-	m_grScene->clear();
-	m_grScene->addPixmap(QPixmap::fromImage(qimage));
-	m_ui.m_graphicView->show();
+	float progress = m_renderer.getProgress();
+	if (progress != m_displayedProgress || isDone)
+	{
+		m_ui.m_pBarRendering->setValue((int)(100 * progress));
+		m_displayedProgress = progress;
+	}
+
+	if (isDone)
+	{
+		finishRender();
+	}
+}
+
+void RayCaster::finishRender()
+{
+	m_renderTimer->stop();
+	m_renderThread.join();
+	if (!m_isRenderCancelled && !m_ui.m_LEImgFilename->text().isEmpty())
+	{
+		saveRender(m_renderImage);
+		m_renderImage = NULL;
+	}
+
+	m_ui.m_BtnCancelRender->setHidden(true);
 	m_ui.m_pBarRendering->setValue(0);
 	m_ui.m_pBarRendering->setHidden(true);
-	QApplication::restoreOverrideCursor();
+	m_ui.m_BtnRender->setEnabled(true);
+	m_ui.m_tabScene->setEnabled(true);
+}
+
+void RayCaster::saveRender(Image* image)
+{
+	// the display is already up to date, writing the file happens on its own thread
+	if (m_saveThread.joinable())
+	{
+		m_saveThread.join();
+	}
+	std::string filename = m_ui.m_LEImgFilename->text().toStdString();
+	m_saveThread = std::thread([image, filename]()
+	{
+		image->SaveImage(filename.c_str());
+		delete image;
+	});
 }
 #pragma endregion
 
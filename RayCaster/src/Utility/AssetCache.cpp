@@ -0,0 +1,54 @@
+#include "AssetCache.h"
+
+//////////////////////////////////
+// AssetCache class Implementation
+//////////////////////////////////
+
+AssetCache::AssetCache() :
+m_meshes()
+{
+}
+
+AssetCache::~AssetCache()
+{
+}
+
+std::shared_ptr<const MeshGeometry> AssetCache::getMesh(const std::string& filename)
+{
+	// the registry returns the living geometry unless the file changed on disk
+	std::shared_ptr<const MeshGeometry> geometry = MeshGeometry::load(filename.c_str());
+	if (!geometry)
+	{
+		m_meshes.erase(filename);
+		return geometry;
+	}
+	m_meshes[filename] = geometry;
+	return geometry;
+}
+
+std::shared_ptr<Texture> AssetCache::getTexture(const std::string& filename)
+{
+	return TextureCache::getGlobal().acquire(filename);
+}
+
+void AssetCache::releaseUnused()
+{
+	// the cache holds the only reference of an unused mesh
+	for (std::map<std::string, std::shared_ptr<const MeshGeometry> >::iterator it = m_meshes.begin(); it != m_meshes.end();)
+	{
+		if (it->second.use_count() == 1) it = m_meshes.erase(it);
+		else ++it;
+	}
+	// unused textures stay resident for other scenes within the budget
+	TextureCache::getGlobal().trim();
+}
+
+void AssetCache::clear()
+{
+	m_meshes.clear();
+}
+
+int AssetCache::getMeshCount() const
+{
+	return m_meshes.size();
+}
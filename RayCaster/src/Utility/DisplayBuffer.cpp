@@ -0,0 +1,164 @@
+#include "DisplayBuffer.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DISPLAY_BUFFER_SSE2
+#include <emmintrin.h>
+#endif
+
+/////////////////////////////////////
+// DisplayBuffer class Implementation
+/////////////////////////////////////
+
+// pixels are read straight from the Image storage as packed float triplets
+static_assert(sizeof(Vector3f) == 3 * sizeof(float), "Vector3f must be three packed floats");
+
+// same rounding and clamping as the image file writers
+static inline unsigned int toDisplayChannel(float c)
+{
+	int tmp = int(c * 255);
+	return (tmp < 0) ? 0 : ((tmp > 255) ? 255 : tmp);
+}
+
+static inline unsigned int toDisplayPixel(const Vector3f& color)
+{
+	return 0xFF000000u | (toDisplayChannel(color[0]) << 16) | (toDisplayChannel(color[1]) << 8) | toDisplayChannel(color[2]);
+}
+
+///////////////
+// Constructors
+///////////////
+#pragma region Constructors
+
+DisplayBuffer::DisplayBuffer(int w, int h) :
+m_width(w),
+m_height(h),
+m_data(new unsigned int[w * h]),
+m_dirtyMutex(),
+m_dirty()
+{
+	Clear(0, 0, 0);
+}
+
+DisplayBuffer::~DisplayBuffer()
+{
+	delete[] m_data;
+}
+#pragma endregion
+//////////
+// Utility
+//////////
+#pragma region Utility
+
+int DisplayBuffer::Width() const
+{
+	return m_width;
+}
+
+int DisplayBuffer::Height() const
+{
+	return m_height;
+}
+
+int DisplayBuffer::BytesPerLine() const
+{
+	return m_width * sizeof(unsigned int);
+}
+
+unsigned char* DisplayBuffer::Data()
+{
+	return (unsigned char*)m_data;
+}
+
+const unsigned char* DisplayBuffer::Data() const
+{
+	return (const unsigned char*)m_data;
+}
+
+void DisplayBuffer::Clear(unsigned char r, unsigned char g, unsigned char b)
+{
+	unsigned int pixel = 0xFF000000u | (r << 16) | (g << 8) | b;
+	for (int i = 0; i < m_width * m_height; ++i)
+	{
+		m_data[i] = pixel;
+	}
+	markDirty(0, 0, m_width, m_height);
+}
+
+void DisplayBuffer::Convert(const Image& image)
+{
+	Convert(image, 0, 0, m_width, m_height);
+}
+
+void DisplayBuffer::Convert(const Image& image, int x0, int y0, int x1, int y1)
+{
+	assert(image.Width() == m_width && image.Height() == m_height);
+	int pixelCount = m_width * m_height;
+	for (int y = y0; y < y1; ++y)
+	{
+		// Image rows go bottom up
+		unsigned int* dst = m_data + (m_height - 1 - y) * m_width;
+		int x = x0;
+#ifdef DISPLAY_BUFFER_SSE2
+		const __m128 scale = _mm_set1_ps(255.f);
+		const __m128i alpha = _mm_set1_epi32(0xFF000000);
+		// 4 pixels per step, each loaded as r g b + the next pixel's r.
+		// The step is skipped when that extra float would be past the end of the image.
+		for (; x + 4 <= x1 && y * m_width + x + 4 < pixelCount; x += 4)
+		{
+			const float* src = &image.GetPixel(x, y)[0];
+			__m128 p0 = _mm_loadu_ps(src);
+			__m128 p1 = _mm_loadu_ps(src + 3);
+			__m128 p2 = _mm_loadu_ps(src + 6);
+			__m128 p3 = _mm_loadu_ps(src + 9);
+			// r g b x -> b g r x, the byte order of a little endian 0xAARRGGBB
+			p0 = _mm_shuffle_ps(p0, p0, _MM_SHUFFLE(3, 0, 1, 2));
+			p1 = _mm_shuffle_ps(p1, p1, _MM_SHUFFLE(3, 0, 1, 2));
+			p2 = _mm_shuffle_ps(p2, p2, _MM_SHUFFLE(3, 0, 1, 2));
+			p3 = _mm_shuffle_ps(p3, p3, _MM_SHUFFLE(3, 0, 1, 2));
+			// truncate like int(), then the saturating packs clamp to [0, 255]
+			__m128i i0 = _mm_cvttps_epi32(_mm_mul_ps(p0, scale));
+			__m128i i1 = _mm_cvttps_epi32(_mm_mul_ps(p1, scale));
+			__m128i i2 = _mm_cvttps_epi32(_mm_mul_ps(p2, scale));
+			__m128i i3 = _mm_cvttps_epi32(_mm_mul_ps(p3, scale));
+			__m128i bytes = _mm_packus_epi16(_mm_packs_epi32(i0, i1), _mm_packs_epi32(i2, i3));
+			_mm_storeu_si128((__m128i*)(dst + x), _mm_or_si128(bytes, alpha));
+		}
+#endif
+		for (; x < x1; ++x)
+		{
+			dst[x] = toDisplayPixel(image.GetPixel(x, y));
+		}
+	}
+	markDirty(x0, m_height - y1, x1, m_height - y0);
+}
+
+bool DisplayBuffer::CopyDirty(unsigned char* dst, int dstBytesPerLine)
+{
+	// a region is listed once its conversion is done and isn't written again during the render,
+	// so its pixels can be read outside of the lock
+	std::vector<Region> dirty;
+	{
+		std::lock_guard<std::mutex> lock(m_dirtyMutex);
+		dirty.swap(m_dirty);
+	}
+	for (unsigned int i = 0; i < dirty.size(); ++i)
+	{
+		const Region& region = dirty[i];
+		for (int y = region.y0; y < region.y1; ++y)
+		{
+			memcpy(dst + y * dstBytesPerLine + region.x0 * sizeof(unsigned int), m_data + y * m_width + region.x0,
+				(region.x1 - region.x0) * sizeof(unsigned int));
+		}
+	}
+	return !dirty.empty();
+}
+
+void DisplayBuffer::markDirty(int x0, int y0, int x1, int y1)
+{
+	if (x0 >= x1 || y0 >= y1) return;
+	Region region = { x0, y0, x1, y1 };
+	std::lock_guard<std::mutex> lock(m_dirtyMutex);
+	m_dirty.push_back(region);
+}
+#pragma endregion
@@ -96,7 +96,7 @@ void Image::SaveTGA(const char* filename) const
 	const char* ext = &filename[strlen(filename) - 4];
 	assert(!strcmp(ext, ".tga"));
 	FILE* file;
-	fopen_s(&file, filename, "wb");
+	file = fopen(filename, "wb");
 	// misc header information
 	for (int i = 0; i < 18; i++)
 	{
@@ -109,19 +109,22 @@ void Image::SaveTGA(const char* filename) const
 		else if (i == 17) WriteByte(file, 32);
 		else WriteByte(file, 0);
 	}
-	// the data
+	// the data, written one line at a time
 	// flip y so that (0,0) is bottom left corner
+	unsigned char* line = new unsigned char[3 * m_width];
 	for (int y = m_height - 1; y >= 0; y--)
 	{
 		for (int x = 0; x < m_width; x++)
 		{
-			Vector3f v = GetPixel(x, y);
+			const Vector3f& v = GetPixel(x, y);
 			// note reversed order: b, g, r
-			WriteByte(file, ClampColorComponent(v[2]));
-			WriteByte(file, ClampColorComponent(v[1]));
-			WriteByte(file, ClampColorComponent(v[0]));
+			line[3 * x] = ClampColorComponent(v[2]);
+			line[3 * x + 1] = ClampColorComponent(v[1]);
+			line[3 * x + 2] = ClampColorComponent(v[0]);
 		}
+		fwrite(line, 3 * m_width, 1, file);
 	}
+	delete[] line;
 	fclose(file);
 }
 
@@ -131,7 +134,7 @@ Image* Image::LoadTGA(const char *filename) {
 	const char *ext = &filename[strlen(filename) - 4];
 	assert(!strcmp(ext, ".tga"));
 	FILE *file;
-	fopen_s(&file, filename, "rb");
+	file = fopen(filename, "rb");
 	// misc header information
 	int width = 0;
 	int height = 0;
@@ -174,23 +177,26 @@ void Image::SavePPM(const char *filename) const {
 	const char *ext = &filename[strlen(filename) - 4];
 	assert(!strcmp(ext, ".ppm"));
 	FILE *file;
-	fopen_s(&file, filename, "w");
+	file = fopen(filename, "w");
 	// misc header information
 	assert(file != NULL);
 	fprintf(file, "P6\n");
 	fprintf(file, "# Creator: Image::SavePPM()\n");
 	fprintf(file, "%d %d\n", m_width, m_height);
 	fprintf(file, "255\n");
-	// the data
+	// the data, written one line at a time
 	// flip y so that (0,0) is bottom left corner
+	unsigned char* line = new unsigned char[3 * m_width];
 	for (int y = m_height - 1; y >= 0; y--) {
 		for (int x = 0; x<m_width; x++) {
-			Vector3f v = GetPixel(x, y);
-			fputc(ClampColorComponent(v[0]), file);
-			fputc(ClampColorComponent(v[1]), file);
-			fputc(ClampColorComponent(v[2]), file);
+			const Vector3f& v = GetPixel(x, y);
+			line[3 * x] = ClampColorComponent(v[0]);
+			line[3 * x + 1] = ClampColorComponent(v[1]);
+			line[3 * x + 2] = ClampColorComponent(v[2]);
 		}
+		fwrite(line, 3 * m_width, 1, file);
 	}
+	delete[] line;
 	fclose(file);
 }
 
@@ -200,7 +206,7 @@ Image* Image::LoadPPM(const char *filename) {
 	const char *ext = &filename[strlen(filename) - 4];
 	assert(!strcmp(ext, ".ppm"));
 	FILE *file;
-	fopen_s(&file, filename, "rb");
+	file = fopen(filename, "rb");
 	// misc header information
 	int width = 0;
 	int height = 0;
@@ -210,7 +216,7 @@ Image* Image::LoadPPM(const char *filename) {
 	fgets(tmp, 100, file);
 	assert(tmp[0] == '#');
 	fgets(tmp, 100, file);
-	sscanf_s(tmp, "%d %d", &width, &height);
+	sscanf(tmp, "%d %d", &width, &height);
 	fgets(tmp, 100, file);
 	assert(strstr(tmp, "255"));
 	// the data
@@ -306,7 +312,7 @@ Image::SaveBMP(const char *filename)
 
 	bytesPerLine = (3 * (m_width + 1) / 4) * 4;
 
-	strcpy_s(bmph.bfType, "BM");
+	strcpy(bmph.bfType, "BM");
 	bmph.bfOffBits = 54;
 	bmph.bfSize = bmph.bfOffBits + bytesPerLine * m_height;
 	bmph.bfReserved = 0;
@@ -322,7 +328,7 @@ Image::SaveBMP(const char *filename)
 	bmph.biClrUsed = 0;
 	bmph.biClrImportant = 0;
 
-	fopen_s(&file, filename, "wb");
+	file = fopen(filename, "wb");
 	if (file == NULL) return(0);
 
 	fwrite(&bmph.bfType, 2, 1, file);
@@ -0,0 +1,164 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//////////////////////////////////
+// MappedFile class Implementation
+//////////////////////////////////
+
+MappedFile::MappedFile() :
+m_data(NULL),
+m_size(0),
+m_isOpen(false)
+#ifdef _WIN32
+, m_file(INVALID_HANDLE_VALUE),
+m_mapping(NULL)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::isOpen() const
+{
+	return m_isOpen;
+}
+
+const char* MappedFile::getData() const
+{
+	return m_data;
+}
+
+size_t MappedFile::getSize() const
+{
+	return m_size;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const char* filename, MappedFileAccess access)
+{
+	close();
+	DWORD flags = (access == MAPPED_FILE_SEQUENTIAL) ? FILE_FLAG_SEQUENTIAL_SCAN
+		: (access == MAPPED_FILE_RANDOM) ? FILE_FLAG_RANDOM_ACCESS : FILE_ATTRIBUTE_NORMAL;
+	m_file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, flags, NULL);
+	if (m_file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_file, &size))
+	{
+		close();
+		return false;
+	}
+	m_size = (size_t)size.QuadPart;
+	m_isOpen = true;
+	// a zero length file can't be mapped
+	if (m_size == 0) return true;
+
+	m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (m_mapping == NULL)
+	{
+		close();
+		return false;
+	}
+	m_data = (const char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+	if (m_data == NULL)
+	{
+		close();
+		return false;
+	}
+	return true;
+}
+
+bool MappedFile::getFileStatus(const char* filename, unsigned long long& size, long long& modificationTime)
+{
+	WIN32_FILE_ATTRIBUTE_DATA info;
+	if (!GetFileAttributesExA(filename, GetFileExInfoStandard, &info)) return false;
+	size = ((unsigned long long)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+	// FILETIME counts 100ns intervals
+	modificationTime = (long long)((((unsigned long long)info.ftLastWriteTime.dwHighDateTime << 32) | info.ftLastWriteTime.dwLowDateTime) * 100);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_data != NULL) UnmapViewOfFile(m_data);
+	if (m_mapping != NULL) CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+	m_data = NULL;
+	m_mapping = NULL;
+	m_file = INVALID_HANDLE_VALUE;
+	m_size = 0;
+	m_isOpen = false;
+}
+
+#else
+
+bool MappedFile::open(const char* filename, MappedFileAccess access)
+{
+	close();
+	int fd = ::open(filename, O_RDONLY);
+	if (fd < 0) return false;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0)
+	{
+		::close(fd);
+		return false;
+	}
+	m_size = (size_t)info.st_size;
+	if (m_size > 0)
+	{
+		void* data = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED)
+		{
+			::close(fd);
+			m_size = 0;
+			return false;
+		}
+		if (access != MAPPED_FILE_NORMAL)
+		{
+			madvise(data, m_size, (access == MAPPED_FILE_SEQUENTIAL) ? MADV_SEQUENTIAL : MADV_RANDOM);
+		}
+		m_data = (const char*)data;
+	}
+	// the mapping stays valid once the descriptor is closed
+	::close(fd);
+	m_isOpen = true;
+	return true;
+}
+
+bool MappedFile::getFileStatus(const char* filename, unsigned long long& size, long long& modificationTime)
+{
+	struct stat info;
+	if (stat(filename, &info) != 0) return false;
+	size = (unsigned long long)info.st_size;
+#if defined(__APPLE__)
+	modificationTime = (long long)info.st_mtimespec.tv_sec * 1000000000LL + info.st_mtimespec.tv_nsec;
+#else
+	modificationTime = (long long)info.st_mtim.tv_sec * 1000000000LL + info.st_mtim.tv_nsec;
+#endif
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (m_data != NULL) munmap((void*)m_data, m_size);
+	m_data = NULL;
+	m_size = 0;
+	m_isOpen = false;
+}
+
+#endif
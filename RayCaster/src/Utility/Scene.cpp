@@ -32,9 +32,11 @@
 Scene::Scene()
 {
 	m_group = new Group();
+	m_lightBVH = new LightBVH(m_lights);
 	m_camera = NULL;
 	m_background_color = Vector3f(0.5, 0.5, 0.5);
 	m_ambientLight = Vector3f(0, 0, 0);
+	m_shadowsEnabled = true;
 	m_lights = std::vector<Light*>();
 	m_materials = std::vector<Material*>();
 	m_currentMaterial = NULL;
@@ -43,6 +45,7 @@ Scene::Scene()
 Scene::~Scene() {
 	if (m_group != NULL)
 		delete m_group;
+	delete m_lightBVH;
 	if (m_camera != NULL)
 		delete m_camera;
 	int i;
@@ -67,6 +70,7 @@ bool Scene::loadScene(const char* filename) {
 	m_background_color = Vector3f(0.5, 0.5, 0.5);
 	m_ambientLight = Vector3f(0, 0, 0);
 	m_lights = std::vector<Light*>();
+	m_lightBVH->invalidate();
 	m_materials = std::vector<Material*>();
 	m_currentMaterial = NULL;
 
@@ -78,18 +82,19 @@ bool Scene::loadScene(const char* filename) {
 		printf("wrong file name extension\n");
 		exit(0);
 	}
-	fopen_s(&m_file, filename, "r");
+	m_file = fopen(filename, "r");
 	//m_fileParser = new std::ifstream(filename);
 
 	if (m_file == NULL) {
 		//if (m_fileParser == NULL) {
 		printf("cannot open scene file\n");
-		exit(0);
+		return false;
 	}
 	parseFile();
 	//m_fileParser->close();
 	fclose(m_file);
 	m_file = NULL;
+	return true;
 }
 
 Camera* Scene::getCamera() const
@@ -122,6 +127,16 @@ void Scene::setAmbientLight(const Vector3f & color)
 	m_ambientLight = color;
 }
 
+void Scene::setShadowsEnabled(bool enabled)
+{
+	m_shadowsEnabled = enabled;
+}
+
+bool Scene::areShadowsEnabled() const
+{
+	return m_shadowsEnabled;
+}
+
 int Scene::getNumLights() const
 {
 	return m_lights.size();
@@ -136,18 +151,21 @@ Light* Scene::getLight(int i) const
 void Scene::addLight(Light* newLight)
 {
 	m_lights.push_back(newLight);
+	m_lightBVH->invalidate();
 }
 
 void Scene::modifyLight(int i, Light * light)
 {
 	assert(i >= 0 && i < m_lights.size());
 	m_lights[i] = light;
+	m_lightBVH->invalidate();
 }
 
 void Scene::removeLight(int i)
 {
 	assert(i >= 0 && i < m_lights.size());
 	m_lights.erase(m_lights.begin() + i);
+	m_lightBVH->invalidate();
 }
 
 int Scene::getNumMaterials() const
@@ -182,6 +200,16 @@ Group* Scene::getGroup() const
 {
 	return m_group;
 }
+
+LightBVH* Scene::getLightBVH() const
+{
+	return m_lightBVH;
+}
+
+AssetCache& Scene::getAssets()
+{
+	return m_assets;
+}
 #pragma endregion
 //////////
 // Parsers
@@ -209,7 +237,9 @@ void Scene::parseFile() {
 			parseMaterials();
 		}
 		else if (!strcmp(token, "Group")) {
-			m_group = parseGroup();
+			Group* group = parseGroup();
+			delete m_group;
+			m_group = group;
 		}
 		else {
 			printf("Unknown token in parseFile: '%s'\n", token);
@@ -282,6 +312,7 @@ void Scene::parseLights() {
 		count++;
 	}
 	getToken(token); assert(!strcmp(token, "}"));
+	m_lightBVH->invalidate();
 }
 
 Light* Scene::parseDirectionalLight() {
@@ -302,8 +333,15 @@ Light* Scene::parsePointLight() {
 	Vector3f position = readVector3f();
 	getToken(token); assert(!strcmp(token, "color"));
 	Vector3f color = readVector3f();
-	getToken(token); assert(!strcmp(token, "}"));
-	return new PointLight(position, color);
+	// optional, the light reaches the whole scene without it
+	float radius = 0;
+	getToken(token);
+	if (!strcmp(token, "radius")) {
+		radius = readFloat();
+		getToken(token);
+	}
+	assert(!strcmp(token, "}"));
+	return new PointLight(position, color, radius);
 }
 
 void Scene::parseMaterials() {
@@ -318,7 +356,7 @@ void Scene::parseMaterials() {
 		getToken(token);
 		if (!strcmp(token, "Material") ||
 			!strcmp(token, "PhongMaterial")) {
-			m_materials[count] = parseMaterial();
+			m_materials.push_back(parseMaterial());
 		}
 		else {
 			printf("Unknown token in parseMaterial: '%s'\n", token);
@@ -357,7 +395,7 @@ Material* Scene::parseMaterial() {
 	}
 	Material *answer = new Material(diffuseColor, specularColor, shininess);
 	if (filename[0] != 0) {
-		answer->loadTexture(filename);
+		answer->setTexture(m_assets.getTexture(filename));
 	}
 	return answer;
 }
@@ -483,7 +521,7 @@ Mesh* Scene::parseTriangleMesh() {
 	getToken(token); assert(!strcmp(token, "}"));
 	const char *ext = &filename[strlen(filename) - 4];
 	assert(!strcmp(ext, ".obj"));
-	Mesh *answer = new Mesh(filename, m_currentMaterial);
+	Mesh *answer = new Mesh(m_assets.getMesh(filename), m_currentMaterial);
 
 	return answer;
 }
@@ -562,7 +600,7 @@ int Scene::getToken(char token[MAX_PARSER_TOKEN_LENGTH]) {
 	// for simplicity, tokens must be separated by whitespace
 	assert(m_file != NULL);
 	//std::string buf;
-	int success = fscanf_s(m_file, "%s ", token, MAX_PARSER_TOKEN_LENGTH);
+	int success = fscanf(m_file, MAX_PARSER_TOKEN_FORMAT, token);
 	if (success == EOF) {
 		token[0] = '\0';
 		return 0;
@@ -576,7 +614,7 @@ int Scene::getToken(char token[MAX_PARSER_TOKEN_LENGTH]) {
 
 Vector3f Scene::readVector3f() {
 	float x, y, z;
-	int count = fscanf_s(m_file, "%f %f %f", &x, &y, &z);
+	int count = fscanf(m_file, "%f %f %f", &x, &y, &z);
 	if (count != 3) {
 		printf("Error trying to read 3 floats to make a Vector3f\n");
 		assert(0);
@@ -586,7 +624,7 @@ Vector3f Scene::readVector3f() {
 
 Vector2f Scene::readVec2f() {
 	float u, v;
-	int count = fscanf_s(m_file, "%f %f", &u, &v);
+	int count = fscanf(m_file, "%f %f", &u, &v);
 	if (count != 2) {
 		printf("Error trying to read 2 floats to make a Vec2f\n");
 		assert(0);
@@ -596,7 +634,7 @@ Vector2f Scene::readVec2f() {
 
 float Scene::readFloat() {
 	float answer;
-	int count = fscanf_s(m_file, "%f", &answer);
+	int count = fscanf(m_file, "%f", &answer);
 	if (count != 1) {
 		printf("Error trying to read 1 float\n");
 		assert(0);
@@ -606,7 +644,7 @@ float Scene::readFloat() {
 
 int Scene::readInt() {
 	int answer;
-	int count = fscanf_s(m_file, "%d", &answer);
+	int count = fscanf(m_file, "%d", &answer);
 	if (count != 1) {
 		printf("Error trying to read 1 int\n");
 		assert(0);
@@ -0,0 +1,177 @@
+#include "ThreadPool.h"
+
+//////////////////////////////////
+// ThreadPool class Implementation
+//////////////////////////////////
+
+// pool and queue owned by the current thread, if it is a worker
+static thread_local ThreadPool* t_pool = NULL;
+static thread_local int t_queueIndex = -1;
+
+///////////////
+// Constructors
+///////////////
+#pragma region Constructors
+
+ThreadPool::ThreadPool(int threadCount) :
+m_queuedTasks(0),
+m_isStopping(false)
+{
+	if (threadCount <= 0)
+	{
+		threadCount = std::thread::hardware_concurrency();
+		if (threadCount <= 0) threadCount = 1;
+	}
+	// the thread calling parallelFor works too, so it counts as one of them
+	for (int i = 0; i < threadCount; ++i)
+	{
+		m_queues.push_back(new TaskQueue());
+	}
+	for (int i = 0; i < threadCount - 1; ++i)
+	{
+		m_threads.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_isStopping = true;
+	}
+	m_wakeUp.notify_all();
+	for (unsigned int i = 0; i < m_threads.size(); ++i)
+	{
+		m_threads[i].join();
+	}
+	for (unsigned int i = 0; i < m_queues.size(); ++i)
+	{
+		delete m_queues[i];
+	}
+}
+#pragma endregion
+//////////
+// Utility
+//////////
+#pragma region Utility
+
+int ThreadPool::getThreadCount() const
+{
+	return m_queues.size();
+}
+
+ThreadPool& ThreadPool::getGlobal()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& body)
+{
+	if (count <= 0) return;
+	if (m_threads.empty())
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			body(i);
+		}
+		return;
+	}
+
+	std::atomic<int> pending(count);
+	int queueCount = m_queues.size();
+	int homeQueue = (t_pool == this) ? t_queueIndex : queueCount - 1;
+
+	// hand out contiguous ranges, starting with the calling thread's own queue
+	for (int q = 0; q < queueCount; ++q)
+	{
+		int begin = (int)((long long)count * q / queueCount);
+		int end = (int)((long long)count * (q + 1) / queueCount);
+		if (begin == end) continue;
+		TaskQueue* queue = m_queues[(homeQueue + q) % queueCount];
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		for (int i = end - 1; i >= begin; --i)
+		{
+			Task task = { &body, i, &pending };
+			queue->tasks.push_back(task);
+		}
+	}
+	m_queuedTasks += count;
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+	}
+	m_wakeUp.notify_all();
+
+	// help until every task of this call is done. Once nothing is left to take, the remaining ones
+	// run on other threads: sleep until the last of them finishes or new tasks (nested calls) are queued
+	while (pending > 0)
+	{
+		Task task;
+		if (popTask(homeQueue, task) || stealTask(homeQueue, task))
+		{
+			runTask(task);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_wakeUp.wait(lock, [this, &pending] { return pending == 0 || m_queuedTasks > 0; });
+	}
+}
+
+void ThreadPool::workerLoop(int queueIndex)
+{
+	t_pool = this;
+	t_queueIndex = queueIndex;
+	while (true)
+	{
+		Task task;
+		if (popTask(queueIndex, task) || stealTask(queueIndex, task))
+		{
+			runTask(task);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_wakeUp.wait(lock, [this] { return m_isStopping || m_queuedTasks > 0; });
+		if (m_isStopping && m_queuedTasks == 0) return;
+	}
+}
+
+bool ThreadPool::popTask(int queueIndex, Task& task)
+{
+	TaskQueue* queue = m_queues[queueIndex];
+	std::lock_guard<std::mutex> lock(queue->mutex);
+	if (queue->tasks.empty()) return false;
+	task = queue->tasks.back();
+	queue->tasks.pop_back();
+	m_queuedTasks--;
+	return true;
+}
+
+bool ThreadPool::stealTask(int queueIndex, Task& task)
+{
+	int queueCount = m_queues.size();
+	for (int i = 1; i < queueCount; ++i)
+	{
+		TaskQueue* queue = m_queues[(queueIndex + i) % queueCount];
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		if (queue->tasks.empty()) continue;
+		task = queue->tasks.front();
+		queue->tasks.pop_front();
+		m_queuedTasks--;
+		return true;
+	}
+	return false;
+}
+
+void ThreadPool::runTask(Task& task)
+{
+	(*task.body)(task.index);
+	// the counter lives in the frame of parallelFor, which may return as soon as it reaches 0
+	if (task.pending->fetch_sub(1) == 1)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+		}
+		m_wakeUp.notify_all();
+	}
+}
+#pragma endregion
@@ -0,0 +1,152 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+
+#include "Scene.h"
+#include "Image.h"
+#include "Renderer.h"
+#include "TextureCache.h"
+
+/////////////////////////////////////////////
+// Headless entry point, renders without Qt
+//
+// RayCasterHeadless -input scene.txt [-output image.bmp]
+//     [-size width height] [-threads n] [-tile size] [-heatmap]
+//     [-texture-budget mb] [-shadows 0|1]
+//
+// Without -output the image is only rendered, which times the renderer alone.
+// -heatmap writes the per pixel traversal cost next to the image,
+// the intersection path must be built with RAYCASTER_COUNTERS
+/////////////////////////////////////////////
+
+static void printUsage(const char* program)
+{
+	printf("usage: %s -input scene.txt [-output image.(bmp|tga|ppm)] [-size width height] [-threads n] [-tile size] [-heatmap] [-texture-budget mb] [-shadows 0|1]\n", program);
+}
+
+static void saveImage(Image& image, const char* filename)
+{
+	int len = strlen(filename);
+	if (len > 4 && strcmp(filename + len - 4, ".ppm") == 0)
+	{
+		image.SavePPM(filename);
+	}
+	else
+	{
+		image.SaveImage(filename);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	const char* input = NULL;
+	const char* output = NULL;
+	int width = 256;
+	int height = 256;
+	int threadCount = 0;
+	int tileSize = 32;
+	bool isHeatmapWanted = false;
+	bool areShadowsEnabled = true;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "-input") && i + 1 < argc)
+		{
+			input = argv[++i];
+		}
+		else if (!strcmp(argv[i], "-output") && i + 1 < argc)
+		{
+			output = argv[++i];
+		}
+		else if (!strcmp(argv[i], "-size") && i + 2 < argc)
+		{
+			width = atoi(argv[++i]);
+			height = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "-threads") && i + 1 < argc)
+		{
+			threadCount = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "-tile") && i + 1 < argc)
+		{
+			tileSize = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "-texture-budget") && i + 1 < argc)
+		{
+			TextureCache::getGlobal().setBudget((size_t)(atof(argv[++i]) * 1024 * 1024));
+		}
+		else if (!strcmp(argv[i], "-shadows") && i + 1 < argc)
+		{
+			areShadowsEnabled = atoi(argv[++i]) != 0;
+		}
+		else if (!strcmp(argv[i], "-heatmap"))
+		{
+			isHeatmapWanted = true;
+		}
+		else
+		{
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+	if (input == NULL || (output == NULL && isHeatmapWanted) || width < 2 || height < 2)
+	{
+		printUsage(argv[0]);
+		return 1;
+	}
+
+	Scene scene;
+	if (!scene.loadScene(input))
+	{
+		return 1;
+	}
+	scene.setShadowsEnabled(areShadowsEnabled);
+	PerspectiveCamera* camera = dynamic_cast<PerspectiveCamera*>(scene.getCamera());
+	if (camera == NULL)
+	{
+		printf("scene has no camera\n");
+		return 1;
+	}
+	// same aspect ratio convention as the UI
+	camera->setAspectRatio((float)width / height);
+
+	Image image(width, height);
+	Renderer renderer(threadCount, tileSize);
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	renderer.render(scene, image);
+	std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+	printf("rendered %dx%d with %d threads in %.3f s\n", width, height, renderer.getThreadCount(),
+		std::chrono::duration<double>(end - start).count());
+	TextureCacheStats textureStats = TextureCache::getGlobal().getStats();
+	printf("textures: %d resident, %.2f of %.2f MB, %lld hits, %lld misses, %lld evictions\n",
+		textureStats.residentCount, textureStats.residentBytes / (1024.0 * 1024.0), textureStats.budget / (1024.0 * 1024.0),
+		textureStats.hits, textureStats.misses, textureStats.evictions);
+
+	if (output == NULL)
+	{
+		return 0;
+	}
+	saveImage(image, output);
+
+	if (isHeatmapWanted)
+	{
+		Image heatmap(width, height);
+		if (!renderer.getHeatmap(heatmap))
+		{
+			printf("no heatmap: build with RAYCASTER_COUNTERS to count traversal steps\n");
+			return 1;
+		}
+		// image.bmp -> image_heatmap.bmp
+		std::string heatmapName(output);
+		size_t dot = heatmapName.find_last_of('.');
+		heatmapName.insert((dot == std::string::npos) ? heatmapName.size() : dot, "_heatmap");
+		saveImage(heatmap, heatmapName.c_str());
+
+		const RenderStats& stats = renderer.getLastStats();
+		printf("%.2f nodes and %.2f intersection tests per primary ray\n",
+			(double)stats.nodeVisits / stats.primaryRays, (double)stats.intersectionTests / stats.primaryRays);
+	}
+	return 0;
+}